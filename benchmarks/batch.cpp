@@ -0,0 +1,80 @@
+#include <ire.hpp>
+
+#include "thunder/batch.hpp"
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+int main()
+{
+	$entrypoint(kernel) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> input(1);
+		writeonly <buffer <unsized_array <f32>>> output(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+
+		f32 sum = 0.0f;
+		$for (i, range(0, 16)) {
+			f32 x = input[tid + u32(i)];
+			$if (x > 1.0f) {
+				sum += sin(x) * cos(x);
+			} $else {
+				sum -= x * x;
+			};
+		};
+
+		output[tid] = sum;
+	};
+
+	static constexpr size_t items = 512;
+
+	struct Configuration {
+		std::string name;
+		Target target;
+	};
+
+	std::vector <Configuration> configurations {
+		{ "glsl", Target::glsl },
+		{ "spirv (direct)", Target::spirv_binary },
+		{ "spirv (via glsl)", Target::spirv_binary_via_glsl },
+	};
+
+	size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+	std::vector <size_t> threads { 1 };
+	while (threads.back() * 2 <= cores)
+		threads.push_back(threads.back() * 2);
+	if (threads.back() != cores)
+		threads.push_back(cores);
+
+	for (auto &[name, target] : configurations) {
+		thunder::BatchItem item;
+		item.procedures = { kernel };
+		item.target = target;
+		item.optimizer = thunder::Optimizer::stable;
+
+		std::vector <thunder::BatchItem> batch(items, item);
+
+		double serial = 0;
+		for (size_t count : threads) {
+			thunder::BatchCompiler compiler(count);
+
+			auto result = bench::measure(fmt::format("{} items, {} ({} threads)", items, name, count), 3,
+				[]() { return 0; },
+				[&](int) {
+					for (auto &future : compiler.submit(batch))
+						bench::sink(future.get().timing);
+				});
+
+			if (count == 1)
+				serial = result.median;
+
+			bench::report(result);
+			fmt::println("{:>40} speedup {:.2f}x", "", serial / result.median);
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#include "thunder/cfg.hpp"
+
+#include "harness.hpp"
+#include "synthetic.hpp"
+
+using namespace jvl;
+using namespace jvl::thunder;
+
+int main()
+{
+	for (size_t size : { 1'000, 10'000, 30'000 }) {
+		Buffer buffer = bench::synthetic_control_flow(size);
+
+		auto original = [&]() -> const Buffer & { return buffer; };
+
+		size_t iterations = (size > 10'000) ? 5 : 20;
+
+		auto scopes = bench::measure(fmt::format("scope hierarchy @{}", size),
+			iterations, original,
+			[](const Buffer &b) { bench::sink(cfg_blocks(b)); });
+
+		auto graph = bench::measure(fmt::format("control flow graph @{}", size),
+			iterations, original,
+			[](const Buffer &b) { bench::sink(control_flow_graph(b)); });
+
+		bench::report(scopes);
+		bench::report(graph);
+
+		auto cfg = control_flow_graph(buffer);
+
+		size_t phis = cfg.phi_list.size();
+		fmt::println("    {} atoms, {} blocks, {} variables, {} phis",
+			buffer.pointer, cfg.size(), cfg.variables.size(), phis);
+	}
+}
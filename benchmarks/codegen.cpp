@@ -0,0 +1,42 @@
+#include <ire.hpp>
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+// Number of levels in the tower, where each level uses the previous twice
+static size_t levels = 0;
+
+int main()
+{
+	for (size_t n : { 4, 8, 12, 16 }) {
+		levels = n;
+
+		$subroutine(f32, power, f32 x) {
+			std::vector <f32> tower { x };
+			for (size_t i = 0; i < levels; i++)
+				tower.emplace_back(tower.back() * tower.back() + tower.back());
+
+			$return tower.back();
+		};
+
+		thunder::LinkageUnit unit;
+		unit.add(power);
+
+		size_t iterations = (n > 12) ? 10 : 100;
+
+		auto glsl = bench::measure(fmt::format("glsl (tower) @{}", n),
+			iterations, []() { return 0; },
+			[&](int) { bench::sink(unit.generate_glsl()); });
+
+		auto cpp = bench::measure(fmt::format("c++ (tower) @{}", n),
+			iterations, []() { return 0; },
+			[&](int) { bench::sink(unit.generate_cpp()); });
+
+		bench::report(glsl);
+		bench::report(cpp);
+
+		fmt::println("source size @{}: {} bytes", n, unit.generate_glsl().size());
+	}
+}
@@ -0,0 +1,97 @@
+#include <ire.hpp>
+
+#include "thunder/dispatch.hpp"
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+int main()
+{
+	$entrypoint(kernel) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> input(1);
+		writeonly <buffer <unsized_array <f32>>> output(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+
+		f32 x = input[tid];
+		f32 sum = 0.0f;
+		$for (i, range(0, 16)) {
+			sum += sin(x * f32(i)) * cos(x + f32(i));
+		};
+
+		output[tid] = sum;
+	};
+
+	thunder::ComputeKernel compute(link(kernel));
+
+	static constexpr uint32_t groups = 1 << 12;
+	static constexpr size_t count = 64 * groups;
+
+	std::vector <float> input(count);
+	std::vector <float> output(count);
+	for (size_t i = 0; i < count; i++)
+		input[i] = float(i % 1000) / 1000.0f;
+
+	thunder::DispatchBindings bindings;
+	bindings.buffers[0] = output.data();
+	bindings.buffers[1] = input.data();
+
+	// Scaling with the number of workers, the caller takes part as well
+	size_t hardware = std::max <size_t> (std::thread::hardware_concurrency(), 1);
+	for (size_t threads = 1; threads <= hardware; threads *= 2) {
+		thunder::ThreadPool pool(threads);
+
+		auto result = bench::measure(fmt::format("{} groups ({} workers)", groups, threads), 5,
+			[]() { return 0; },
+			[&](int) {
+				compute.dispatch(groups, 1, 1, bindings, pool);
+				bench::sink(output[0]);
+			});
+
+		bench::report(result);
+	}
+
+	// Workgroup reductions through shared memory, where invocations
+	// are suspended and resumed at every barrier
+	$entrypoint(reduction) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> input(1);
+		writeonly <buffer <unsized_array <f32>>> output(0);
+
+		shared <array <f32>> partial(64);
+
+		u32 local = gl_LocalInvocationIndex;
+		partial[local] = input[gl_GlobalInvocationID.x];
+		barrier();
+
+		u32 stride = 32;
+		$for (k, range(0, 6)) {
+			$if (local < stride) {
+				partial[local] = partial[local] + partial[local + stride];
+			};
+
+			barrier();
+			stride = stride / 2u;
+		};
+
+		$if (local == 0u) {
+			output[gl_WorkGroupID.x] = partial[0];
+		};
+	};
+
+	thunder::ComputeKernel reducer(link(reduction));
+
+	auto reduced = bench::measure(fmt::format("{} groups (reduction, shared)", groups), 5,
+		[]() { return 0; },
+		[&](int) {
+			reducer.dispatch(groups, 1, 1, bindings);
+			bench::sink(output[0]);
+		});
+
+	bench::report(reduced);
+}
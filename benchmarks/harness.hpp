@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <fmt/printf.h>
+
+namespace jvl::bench {
+
+// Summary of a benchmarked routine, times are in microseconds
+struct Result {
+	std::string name;
+	size_t iterations;
+	double min;
+	double median;
+};
+
+// Prevent the compiler from discarding benchmarked values
+template <typename T>
+inline void sink(const T &value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Setup runs before every iteration, and is excluded from the timing
+template <typename S, typename F>
+Result measure(const std::string &name, size_t iterations, const S &setup, const F &ftn)
+{
+	using clock_t = std::chrono::steady_clock;
+
+	std::vector <double> samples;
+	samples.reserve(iterations);
+
+	for (size_t i = 0; i < iterations; i++) {
+		auto &&input = setup();
+
+		auto start = clock_t::now();
+		ftn(input);
+		auto end = clock_t::now();
+
+		std::chrono::duration <double, std::micro> elapsed = end - start;
+		samples.push_back(elapsed.count());
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	return Result {
+		.name = name,
+		.iterations = iterations,
+		.min = samples.front(),
+		.median = samples[samples.size() / 2],
+	};
+}
+
+inline void report(const Result &result)
+{
+	fmt::println("{:<40} {:>6} iters {:>14.2f} us (min) {:>14.2f} us (median)",
+		result.name, result.iterations,
+		result.min, result.median);
+}
+
+} // namespace jvl::bench
@@ -0,0 +1,102 @@
+#include <set>
+
+#include "thunder/optimization.hpp"
+#include "thunder/relocation.hpp"
+
+#include "harness.hpp"
+#include "synthetic.hpp"
+
+using namespace jvl;
+using namespace jvl::thunder;
+
+// Per-atom storage, excluding decorations and the interned types
+size_t footprint(const Buffer &buffer)
+{
+	return buffer.pointer * (sizeof(Atom) + sizeof(TypeId));
+}
+
+// Marking every third atom and visiting the marked atoms in order,
+// as the passes do with Buffer::marked
+template <typename Set>
+size_t mark_and_visit(size_t size)
+{
+	Set marked;
+	for (size_t i = 0; i < size; i += 3)
+		marked.insert(Index(i));
+
+	size_t sum = 0;
+	for (size_t i = 0; i < size; i++)
+		sum += marked.count(Index(i));
+
+	for (Index i : marked)
+		sum += i;
+
+	return sum;
+}
+
+int main()
+{
+	fmt::println("index: {} bytes, atom: {} bytes, limit: {} atoms",
+		sizeof(Index), sizeof(Atom),
+		size_t(std::numeric_limits <Index> ::max()) + 1);
+
+	std::vector <size_t> sizes { 1'000, 10'000, 30'000 };
+#ifdef JVL_WIDE_INDEX
+	sizes.push_back(100'000);
+	sizes.push_back(300'000);
+#endif
+
+	for (size_t size : sizes) {
+		Buffer straight = bench::synthetic_buffer(size);
+		Buffer branching = bench::synthetic_control_flow(size);
+
+		fmt::println("footprint @{}: {:.1f} KiB", size, footprint(straight) / 1024.0);
+
+		auto straight_copied = [&]() -> Buffer { return straight; };
+		auto branching_copied = [&]() -> Buffer { return branching; };
+
+		size_t iterations = (size > 10'000) ? 5 : 20;
+
+		auto strip = bench::measure(fmt::format("strip @{}", size),
+			iterations, straight_copied,
+			[](Buffer &b) { Optimizer::stable.strip(b); });
+
+		Optimizer optimizer { OptimizationFlags::eLoopInvariance };
+
+		auto hoist = bench::measure(fmt::format("hoist @{}", size),
+			iterations, branching_copied,
+			[&](Buffer &b) { optimizer.hoist(b); });
+
+		bench::report(strip);
+		bench::report(hoist);
+
+		// Flat containers against the node-based ones they replaced
+		auto none = []() { return 0; };
+
+		auto marked = bench::measure(fmt::format("mark @{}", size), iterations, none,
+			[&](int) { bench::sink(mark_and_visit <IndexSet> (size)); });
+
+		auto marked_set = bench::measure(fmt::format("mark (std::set) @{}", size), iterations, none,
+			[&](int) { bench::sink(mark_and_visit <std::set <Index>> (size)); });
+
+		// Dropping every fourth atom, as stripping does
+		DenseRelocation relocation(straight.pointer);
+		for (size_t i = 0, j = 0; i < straight.pointer; i++) {
+			if (i % 4)
+				relocation[i] = j++;
+		}
+
+		Buffer::Decorations decorations;
+		for (size_t i = 0; i < straight.pointer; i += 2) {
+			decorations.type[i].uuid = i;
+			decorations.materialize.insert(i);
+		}
+
+		auto relocated = bench::measure(fmt::format("relocate decorations @{}", size), iterations, none,
+			[&](int) { bench::sink(decorations.relocated(relocation).materialize.size()); });
+
+		bench::report(marked);
+		bench::report(marked_set);
+		bench::report(relocated);
+	}
+}
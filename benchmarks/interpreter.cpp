@@ -0,0 +1,113 @@
+#include <ire.hpp>
+
+#include "thunder/interpreter.hpp"
+#include "thunder/tiered.hpp"
+#include "thunder/optimization.hpp"
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+using kernel_t = float (*)(float, float, float);
+
+int main()
+{
+	// Same kernel as the JIT benchmark, for comparable numbers
+	$subroutine(f32, specular, f32 cosine, f32 roughness, f32 f0) {
+		f32 alpha = roughness * roughness;
+		f32 alpha2 = alpha * alpha;
+		f32 m = 1.0f - cosine;
+		f32 fresnel = f0 + (1.0f - f0) * (m * m * m * m * m);
+		f32 d = cosine * cosine * (alpha2 - 1.0f) + 1.0f;
+		f32 ndf = alpha2 / (3.14159265f * d * d);
+		$return fresnel * ndf / (4.0f * cosine * cosine + 0.0001f);
+	};
+
+	thunder::TrackedBuffer buffer = specular;
+	thunder::Optimizer::stable.apply(buffer.edit());
+
+	thunder::LinkageUnit unit;
+	unit.add(buffer);
+
+	static constexpr size_t samples = 1 << 20;
+
+	std::vector <float> inputs(3 * samples);
+	for (size_t i = 0; i < inputs.size(); i++)
+		inputs[i] = float(i % 1000) / 1000.0f;
+
+	// Time until the kernel can first be run
+	std::optional <thunder::Interpreter> interpreter;
+	kernel_t kernel = nullptr;
+
+	auto lowering = bench::measure("startup (interpreter)", 20,
+		[]() { return 0; },
+		[&](int) { interpreter.emplace(unit); });
+
+	auto compile = bench::measure("startup (jit, -O2)", 5,
+		[]() { return 0; },
+		[&](int) { kernel = (kernel_t) unit.generate_jit_gcc({ .optimization = 2 }); });
+
+	bench::report(lowering);
+	bench::report(compile);
+
+	// Per invocation cost once both are available
+	auto interpreted = bench::measure(fmt::format("{} evaluations (interpreter)", samples), 10,
+		[]() { return 0; },
+		[&](int) {
+			float sum = 0.0f;
+			for (size_t i = 0; i < samples; i++)
+				sum += interpreter->call <float> (inputs[3 * i], inputs[3 * i + 1], inputs[3 * i + 2]);
+
+			bench::sink(sum);
+		});
+
+	auto native = bench::measure(fmt::format("{} evaluations (jit, -O2)", samples), 10,
+		[]() { return 0; },
+		[&](int) {
+			float sum = 0.0f;
+			for (size_t i = 0; i < samples; i++)
+				sum += kernel(inputs[3 * i], inputs[3 * i + 1], inputs[3 * i + 2]);
+
+			bench::sink(sum);
+		});
+
+	bench::report(interpreted);
+	bench::report(native);
+
+	// Invocations after which compiling pays off
+	double per_interpreted = interpreted.median / samples;
+	double per_native = native.median / samples;
+	if (per_interpreted > per_native) {
+		double breakeven = (compile.median - lowering.median) / (per_interpreted - per_native);
+		fmt::println("{:<40} {:>14.0f} invocations", "break-even point", breakeven);
+	}
+
+	// Tiered execution, from the first call until native speed
+	std::unique_ptr <thunder::CompiledProcedure> tiered;
+
+	auto first = bench::measure("first call (tiered)", 20,
+		[]() { return 0; },
+		[&](int) {
+			tiered = std::make_unique <thunder::CompiledProcedure> (unit,
+				thunder::TieredOptions { .jit = { .optimization = 2 } });
+
+			bench::sink(tiered->call <float> (inputs[0], inputs[1], inputs[2]));
+		});
+
+	bench::report(first);
+
+	tiered->wait();
+
+	auto steady = bench::measure(fmt::format("{} evaluations (tiered, native)", samples), 10,
+		[]() { return 0; },
+		[&](int) {
+			float sum = 0.0f;
+			for (size_t i = 0; i < samples; i++)
+				sum += tiered->call <float> (inputs[3 * i], inputs[3 * i + 1], inputs[3 * i + 2]);
+
+			bench::sink(sum);
+		});
+
+	bench::report(steady);
+}
@@ -0,0 +1,88 @@
+#include <ire.hpp>
+
+#include "thunder/optimization.hpp"
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+using kernel_t = float (*)(float, float, float);
+
+int main()
+{
+	// Schlick's approximation and a GGX style distribution term
+	$subroutine(f32, specular, f32 cosine, f32 roughness, f32 f0) {
+		f32 alpha = roughness * roughness;
+		f32 alpha2 = alpha * alpha;
+		f32 m = 1.0f - cosine;
+		f32 fresnel = f0 + (1.0f - f0) * (m * m * m * m * m);
+		f32 d = cosine * cosine * (alpha2 - 1.0f) + 1.0f;
+		f32 ndf = alpha2 / (3.14159265f * d * d);
+		$return fresnel * ndf / (4.0f * cosine * cosine + 0.0001f);
+	};
+
+	thunder::TrackedBuffer buffer = specular;
+	thunder::Optimizer::stable.apply(buffer.edit());
+
+	thunder::LinkageUnit unit;
+	unit.add(buffer);
+
+	static constexpr size_t samples = 1 << 20;
+
+	std::vector <float> inputs(3 * samples);
+	for (size_t i = 0; i < inputs.size(); i++)
+		inputs[i] = float(i % 1000) / 1000.0f;
+
+	struct Configuration {
+		std::string name;
+		JitOptions options;
+	};
+
+	std::vector <Configuration> configurations {
+		{ "-O0", { .optimization = 0 } },
+		{ "-O2", { .optimization = 2 } },
+		{ "-O3", { .optimization = 3 } },
+		{ "-O3 -march=native", { .optimization = 3, .native = true } },
+	};
+
+	for (auto &[name, options] : configurations) {
+		kernel_t kernel = nullptr;
+
+		auto compile = bench::measure(fmt::format("compile ({})", name), 5,
+			[]() { return 0; },
+			[&](int) { kernel = (kernel_t) unit.generate_jit_gcc(options); });
+
+		auto throughput = bench::measure(fmt::format("{} evaluations ({})", samples, name), 10,
+			[]() { return 0; },
+			[&](int) {
+				float sum = 0.0f;
+				for (size_t i = 0; i < samples; i++)
+					sum += kernel(inputs[3 * i], inputs[3 * i + 1], inputs[3 * i + 2]);
+
+				bench::sink(sum);
+			});
+
+		bench::report(compile);
+		bench::report(throughput);
+	}
+
+	// Loading previously compiled kernels from the on-disk cache
+	auto directory = std::filesystem::temp_directory_path() / "javelin-jit-bench";
+	std::filesystem::remove_all(directory);
+
+	JitOptions cached { .optimization = 2, .cache = directory };
+
+	auto cold = bench::measure("compile (-O2, cache miss)", 5,
+		[&]() { std::filesystem::remove_all(directory); return 0; },
+		[&](int) { bench::sink(unit.generate_jit_gcc(cached)); });
+
+	auto warm = bench::measure("compile (-O2, cache hit)", 5,
+		[]() { return 0; },
+		[&](int) { bench::sink(unit.generate_jit_gcc(cached)); });
+
+	bench::report(cold);
+	bench::report(warm);
+
+	std::filesystem::remove_all(directory);
+}
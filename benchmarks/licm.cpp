@@ -0,0 +1,70 @@
+#include <ire.hpp>
+
+#include "thunder/cfg.hpp"
+#include "thunder/optimization.hpp"
+
+#include "harness.hpp"
+#include "synthetic.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+// Operations and intrinsics evaluated within the body of some loop
+size_t loop_work(const thunder::Buffer &buffer)
+{
+	auto cfg = thunder::control_flow_graph(buffer);
+
+	size_t count = 0;
+	for (size_t i = 0; i < buffer.pointer; i++) {
+		auto &atom = buffer.atoms[i];
+		bool work = atom.is <thunder::Operation> () || atom.is <thunder::Intrinsic> ();
+		count += work && (cfg.loop[cfg.block_of[i]] != -1);
+	}
+
+	return count;
+}
+
+int main()
+{
+	$subroutine(vec3, shade, vec3 albedo, vec3 light, f32 roughness, i32 samples) {
+		vec3 color = vec3(0.0f);
+		$for (i, range(0, samples * 4)) {
+			f32 alpha = roughness * roughness;
+			f32 k = (roughness + 1.0f) * (roughness + 1.0f) / 8.0f;
+			vec3 l = normalize(light);
+			$for (j, range(0, samples)) {
+				f32 t = f32(j) / f32(samples);
+				color += albedo * l * (alpha + t * k);
+			};
+		};
+
+		$return color;
+	};
+
+	using thunder::OptimizationFlags;
+
+	for (auto flags : { OptimizationFlags::eStable, OptimizationFlags::eStable + OptimizationFlags::eLoopInvariance }) {
+		thunder::TrackedBuffer copy = shade;
+		thunder::Optimizer { flags }.apply(copy.edit());
+
+		bool hoisted = has(flags, OptimizationFlags::eLoopInvariance);
+		fmt::println("shade ({}): {} loop atoms evaluated per iteration",
+			hoisted ? "hoisted" : "stable", loop_work(copy));
+	}
+
+	for (size_t size : { 1'000, 10'000, 30'000 }) {
+		thunder::Buffer buffer = bench::synthetic_control_flow(size);
+
+		auto copied = [&]() -> thunder::Buffer { return buffer; };
+
+		size_t iterations = (size > 10'000) ? 5 : 20;
+
+		thunder::Optimizer optimizer { OptimizationFlags::eLoopInvariance };
+
+		auto hoist = bench::measure(fmt::format("hoist @{}", size),
+			iterations, copied,
+			[&](thunder::Buffer &b) { optimizer.hoist(b); });
+
+		bench::report(hoist);
+	}
+}
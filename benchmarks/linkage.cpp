@@ -0,0 +1,84 @@
+#include <ire.hpp>
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+// Allocation volume, counted by the global allocator
+static size_t allocations = 0;
+static size_t allocated = 0;
+
+void *operator new(size_t size)
+{
+	allocations++;
+	allocated += size;
+	if (void *ptr = std::malloc(size))
+		return ptr;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+// Number of terms in each generated function
+static size_t terms = 0;
+
+int main()
+{
+	for (size_t functions : { 16, 64 }) {
+		terms = 64;
+
+		std::vector <thunder::TrackedBuffer> library;
+		for (size_t i = 0; i < functions; i++) {
+			$subroutine(f32, series, f32 x, vec3 v) {
+				f32 sum = 0.0f;
+				for (size_t t = 0; t < terms; t++)
+					sum += dot(v, vec3(x * f32(t))) * sin(x + f32(t));
+
+				$return sum;
+			};
+
+			library.push_back(series);
+		}
+
+		thunder::LinkageUnit unit;
+		for (auto &callable : library)
+			unit.add(callable);
+
+		size_t atoms = 0;
+		for (auto &function : unit.functions)
+			atoms += function.pointer;
+
+		fmt::println("library @{}: {} atoms", functions, atoms);
+
+		auto generate = [&](const std::string &name, const auto &ftn) {
+			size_t before = allocated;
+			size_t count = allocations;
+			bench::sink(ftn());
+
+			fmt::println("{:<40} {:>10} allocations {:>14} bytes", name,
+				allocations - count, allocated - before);
+
+			auto result = bench::measure(name, 20,
+				[]() { return 0; },
+				[&](int) { bench::sink(ftn()); });
+
+			bench::report(result);
+		};
+
+		generate(fmt::format("glsl @{}", functions),
+			[&]() { return unit.generate_glsl(); });
+
+		generate(fmt::format("c++ @{}", functions),
+			[&]() { return unit.generate_cpp(); });
+	}
+}
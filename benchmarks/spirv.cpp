@@ -0,0 +1,57 @@
+#include <ire.hpp>
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+int main()
+{
+	$entrypoint(kernel) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> input(1);
+		writeonly <buffer <unsized_array <f32>>> output(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+
+		f32 sum = 0.0f;
+		$for (i, range(0, 16)) {
+			f32 x = input[tid + u32(i)];
+			$if (x > 1.0f) {
+				sum += sin(x) * cos(x);
+			} $elif (x < -1.0f) {
+				sum += sqrt(abs(x));
+			} $else {
+				sum -= x * x;
+			};
+		};
+
+		output[tid] = sum + length(vec3(sum, 1, 2));
+	};
+
+	thunder::LinkageUnit unit;
+	unit.add(kernel);
+
+	auto stage = vk::ShaderStageFlagBits::eCompute;
+
+	auto direct = bench::measure("spirv (direct)", 1000,
+		[]() { return 0; },
+		[&](int) { bench::sink(unit.generate_spirv(stage)); });
+
+	auto via_glsl = bench::measure("spirv (via glsl)", 100,
+		[]() { return 0; },
+		[&](int) { bench::sink(unit.generate_spirv_via_glsl(stage)); });
+
+	auto assembly = bench::measure("spirv (direct, disassembled)", 1000,
+		[]() { return 0; },
+		[&](int) { bench::sink(unit.generate_spirv_assembly(stage)); });
+
+	bench::report(direct);
+	bench::report(via_glsl);
+	bench::report(assembly);
+
+	fmt::println("binary size: {} words (direct), {} words (via glsl)",
+		unit.generate_spirv(stage).size(),
+		unit.generate_spirv_via_glsl(stage).size());
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <random>
+
+#include "thunder/buffer.hpp"
+
+namespace jvl::bench {
+
+// Straight-line buffer of floating point arithmetic, where roughly
+// a quarter of the operations never contribute to the returned value
+inline thunder::Buffer synthetic_buffer(size_t size, uint32_t seed = 0)
+{
+	using namespace thunder;
+
+	std::mt19937 generator(seed);
+
+	Buffer buffer;
+
+	std::vector <Index> live;
+	for (size_t i = 0; i < 4; i++) {
+		Primitive p;
+		p.type = f32;
+		p.fdata = float(i + 1);
+		live.push_back(buffer.emit(p));
+	}
+
+	static constexpr OperationCode codes[] {
+		addition,
+		subtraction,
+		multiplication,
+	};
+
+	std::vector <Index> dead;
+
+	Index accumulated = live.back();
+	while (buffer.pointer + 2 < size) {
+		OperationCode code = codes[generator() % 3];
+
+		// Dead values may use any operand, creating dead chains
+		if (generator() % 4 == 0) {
+			auto &pool = (dead.empty() || generator() % 2) ? live : dead;
+
+			std::uniform_int_distribution <size_t> pick(0, pool.size() - 1);
+
+			Index a = pool[pick(generator)];
+			Index b = live[generator() % live.size()];
+			dead.push_back(buffer.emit(Operation(a, b, code)));
+		} else {
+			std::uniform_int_distribution <size_t> pick(0, live.size() - 1);
+
+			Index a = live[pick(generator)];
+			Index b = live[pick(generator)];
+			Index result = buffer.emit(Operation(a, b, code));
+
+			accumulated = buffer.emit(Operation(accumulated, result, addition));
+			live.push_back(accumulated);
+		}
+	}
+
+	buffer.emit(Return(accumulated));
+
+	return buffer;
+}
+
+// Nested conditionals and loops over a handful of local variables,
+// laid out the same way as the emitter produces branches
+inline thunder::Buffer synthetic_control_flow(size_t size, uint32_t seed = 0)
+{
+	using namespace thunder;
+
+	std::mt19937 generator(seed);
+
+	Buffer buffer;
+
+	TypeInformation ti;
+	ti.item = f32;
+
+	Index type = buffer.emit(ti);
+
+	Primitive zero;
+	zero.type = f32;
+	zero.fdata = 0.0f;
+
+	Index constant = buffer.emit(zero);
+
+	std::vector <Index> variables;
+	for (size_t i = 0; i < 8; i++) {
+		Index v = buffer.emit(Storage(type));
+		buffer.emit(Store(v, constant));
+		variables.push_back(v);
+	}
+
+	auto variable = [&]() {
+		return variables[generator() % variables.size()];
+	};
+
+	auto condition = [&]() {
+		return buffer.emit(Operation(variable(), constant, cmp_ge));
+	};
+
+	// Leave room for closing every open branch and the return
+	auto room = [&](size_t depth) {
+		return buffer.pointer + 4 * (depth + 1) + 8 < size;
+	};
+
+	auto region = [&](auto &self, size_t depth, bool looped) -> void {
+		size_t statements = 1 + generator() % 6;
+		for (size_t s = 0; s < statements && room(depth); s++) {
+			uint32_t choice = (depth < 6) ? generator() % 8 : 0;
+			if (choice < 4) {
+				Index v = variable();
+				Index value = buffer.emit(Operation(v, variable(), addition));
+				buffer.emit(Store(v, value));
+			} else if (choice < 6) {
+				size_t arms = 1 + generator() % 3;
+
+				std::vector <Index> branches;
+				for (size_t a = 0; a < arms && room(depth); a++) {
+					BranchKind kind = conditional_else_if;
+					if (a == 0)
+						kind = conditional_if;
+					else if (a + 1 == arms)
+						kind = conditional_else;
+
+					Index cond = (kind == conditional_else) ? -1 : condition();
+					if (!branches.empty())
+						buffer.atoms[branches.back()].as <Branch> ().failto = buffer.pointer;
+
+					branches.push_back(buffer.emit(Branch(cond, -1, kind)));
+					self(self, depth + 1, looped);
+				}
+
+				buffer.atoms[branches.back()].as <Branch> ().failto = buffer.pointer;
+				buffer.emit(Branch(-1, -1, control_flow_end));
+			} else if (choice == 6) {
+				Index header = buffer.emit(Branch(condition(), -1, loop_while));
+				self(self, depth + 1, true);
+				buffer.atoms[header].as <Branch> ().failto = buffer.pointer;
+				buffer.emit(Branch(-1, -1, control_flow_end));
+			} else if (looped) {
+				BranchKind kind = (generator() % 2) ? control_flow_skip : control_flow_stop;
+				Index cond = condition();
+				Index branch = buffer.emit(Branch(cond, -1, conditional_if));
+				buffer.emit(Branch(-1, -1, kind));
+				buffer.atoms[branch].as <Branch> ().failto = buffer.pointer;
+				buffer.emit(Branch(-1, -1, control_flow_end));
+			}
+		}
+	};
+
+	while (room(0))
+		region(region, 0, false);
+
+	buffer.emit(Return(variable()));
+
+	return buffer;
+}
+
+} // namespace jvl::bench
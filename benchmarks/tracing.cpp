@@ -0,0 +1,92 @@
+#include <ire.hpp>
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+struct leaf {
+	vec3 position;
+	f32 weight;
+
+	auto layout() {
+		return layout_from("leaf",
+			verbatim_field(position),
+			verbatim_field(weight));
+	}
+};
+
+struct branch {
+	leaf near;
+	leaf far;
+	u32 count;
+
+	auto layout() {
+		return layout_from("branch",
+			verbatim_field(near),
+			verbatim_field(far),
+			verbatim_field(count));
+	}
+};
+
+struct tree {
+	branch left;
+	branch right;
+
+	auto layout() {
+		return layout_from("tree",
+			verbatim_field(left),
+			verbatim_field(right));
+	}
+};
+
+// Statements of nested field and array accesses; each access to
+// the forest links every field of the tree, so atoms add up quickly
+thunder::Buffer trace(size_t statements, bool classify)
+{
+	thunder::Buffer traced;
+
+	auto &em = Emitter::active;
+	em.push(traced, classify);
+	{
+		buffer <unsized_array <tree>> forest(0);
+		writeonly <buffer <unsized_array <f32>>> output(1);
+
+		array <leaf> leaves(16);
+
+		u32 tid = gl_GlobalInvocationID.x;
+
+		f32 sum = 0.0f;
+		for (size_t i = 0; i < statements; i++) {
+			sum += forest[tid].left.near.position.x * forest[tid + i].right.far.weight;
+			sum += leaves[i % 16].position.y + f32(forest[tid].right.count);
+		}
+
+		output[tid] = sum;
+	}
+	em.pop();
+
+	return traced;
+}
+
+int main()
+{
+	for (size_t statements : { 4, 16, 32 }) {
+		size_t atoms = trace(statements, true).pointer;
+		size_t iterations = (statements > 16) ? 10 : 40;
+
+		auto none = []() { return 0; };
+
+		// Without classification, isolating the cost of semantic analysis
+		auto unclassified = bench::measure(fmt::format("trace (unclassified) @{}", atoms),
+			iterations, none,
+			[&](int) { bench::sink(trace(statements, false).pointer); });
+
+		auto classified = bench::measure(fmt::format("trace @{}", atoms),
+			iterations, none,
+			[&](int) { bench::sink(trace(statements, true).pointer); });
+
+		bench::report(unclassified);
+		bench::report(classified);
+	}
+}
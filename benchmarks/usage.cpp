@@ -0,0 +1,50 @@
+#include "thunder/optimization.hpp"
+
+#include "harness.hpp"
+#include "synthetic.hpp"
+
+using namespace jvl;
+using namespace jvl::thunder;
+
+// Reference implementation, scanning all later atoms for each atom
+UsageGraph usage_quadratic(const Buffer &buffer)
+{
+	UsageGraph graph(buffer.pointer);
+	for (size_t i = 0; i < graph.size(); i++)
+		graph[i] = usage(buffer, i);
+
+	return graph;
+}
+
+int main()
+{
+	for (size_t size : { 1'000, 10'000, 30'000 }) {
+		Buffer buffer = bench::synthetic_buffer(size);
+
+		auto original = [&]() -> const Buffer & { return buffer; };
+		auto copied = [&]() -> Buffer { return buffer; };
+
+		size_t iterations = (size > 10'000) ? 5 : 20;
+
+		auto quadratic = bench::measure(fmt::format("usage (quadratic) @{}", size),
+			iterations, original,
+			[](const Buffer &b) { bench::sink(usage_quadratic(b)); });
+
+		auto table = bench::measure(fmt::format("usage table @{}", size),
+			iterations, original,
+			[](const Buffer &b) { bench::sink(usage_table(b)); });
+
+		auto graph = bench::measure(fmt::format("usage graph @{}", size),
+			iterations, original,
+			[](const Buffer &b) { bench::sink(usage(b)); });
+
+		auto strip = bench::measure(fmt::format("strip @{}", size),
+			iterations, copied,
+			[](Buffer &b) { Optimizer::stable.strip(b); });
+
+		bench::report(quadratic);
+		bench::report(table);
+		bench::report(graph);
+		bench::report(strip);
+	}
+}
@@ -0,0 +1,91 @@
+#include <glm/glm.hpp>
+
+#include <ire.hpp>
+
+#include "thunder/optimization.hpp"
+
+#include "harness.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+using kernel_t = glm::vec4 (*)(glm::vec4, glm::vec4, glm::vec4);
+
+int main()
+{
+	// Four-wide polynomial with a blend and a normalization term,
+	// which is vector arithmetic from start to finish
+	$subroutine(vec4, shade, vec4 x, vec4 a, vec4 b) {
+		vec4 p = ((a * x + b) * x - a) * x + b;
+		vec4 q = p * 0.5f + (b - a) * x;
+		f32 w = dot(q, q) + 1.0f;
+		vec4 r = q / w + p * dot(p, x);
+		$return r * r - q;
+	};
+
+	auto reference = [](glm::vec4 x, glm::vec4 a, glm::vec4 b) {
+		glm::vec4 p = ((a * x + b) * x - a) * x + b;
+		glm::vec4 q = p * 0.5f + (b - a) * x;
+		float w = glm::dot(q, q) + 1.0f;
+		glm::vec4 r = q / w + p * glm::dot(p, x);
+		return r * r - q;
+	};
+
+	static constexpr size_t samples = 1 << 20;
+
+	std::vector <glm::vec4> inputs(3 * samples);
+	for (size_t i = 0; i < inputs.size(); i++) {
+		float t = float(i % 1000) / 1000.0f;
+		inputs[i] = glm::vec4(t, 1.0f - t, 0.5f * t, t * t);
+	}
+
+	auto run = [&](const std::string &name, const auto &kernel) {
+		auto result = bench::measure(fmt::format("{} evaluations ({})", samples, name), 10,
+			[]() { return 0; },
+			[&](int) {
+				glm::vec4 sum(0.0f);
+				for (size_t i = 0; i < samples; i++)
+					sum += kernel(inputs[3 * i], inputs[3 * i + 1], inputs[3 * i + 2]);
+
+				bench::sink(sum);
+			});
+
+		bench::report(result);
+	};
+
+	run("host", reference);
+
+	// Scalarized legalization against native vector types, where
+	// two and four component operations are kept for the JIT
+	struct Configuration {
+		std::string name;
+		thunder::LegalizationFlags flags;
+		JitOptions options;
+	};
+
+	std::vector <Configuration> configurations {
+		{ "scalar, -O2", thunder::LegalizationFlags::eNone, { .optimization = 2 } },
+		{ "native, -O2", thunder::LegalizationFlags::eNativeVectors, { .optimization = 2 } },
+		{ "scalar, -O3 -march=native", thunder::LegalizationFlags::eNone, { .optimization = 3, .native = true } },
+		{ "native, -O3 -march=native", thunder::LegalizationFlags::eNativeVectors, { .optimization = 3, .native = true } },
+	};
+
+	for (auto &[name, flags, options] : configurations) {
+		thunder::TrackedBuffer buffer = shade;
+		thunder::legalize_for_cc(buffer.edit(), flags);
+		thunder::Optimizer::stable.apply(buffer.edit());
+
+		thunder::LinkageUnit unit;
+		unit.add(buffer);
+
+		kernel_t kernel = nullptr;
+
+		auto compile = bench::measure(fmt::format("compile ({})", name), 5,
+			[]() { return 0; },
+			[&](int) { kernel = (kernel_t) unit.generate_jit_gcc(options); });
+
+		bench::report(compile);
+
+		run(name, kernel);
+	}
+}
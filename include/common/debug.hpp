@@ -20,11 +20,8 @@ void trace_unit(const std::string &name, const jvl::Stage &stage, Args &&...args
 {
 	MODULE(trace_unit);
 
-	std::vector <jvl::thunder::TrackedBuffer> tracked { args... };
-
 	jvl::thunder::LinkageUnit unit;
-	for (auto &tb : tracked)
-		unit.add(tb);
+	(unit.add(args), ...);
 
 	// TODO: stage_extension method
 	std::string ext;
@@ -61,8 +58,8 @@ void trace_unit(const std::string &name, const jvl::Stage &stage, Args &&...args
 
 	std::string dst = detail::trace_destination / (name + "." + ext);
 	for (auto &ftn : unit.functions) {
-		ftn.write_assembly(dst + "." + ftn.name + ".jvl");
-		ftn.graphviz(dst + "." + ftn.name + ".dot");
+		ftn.snapshot->write_assembly(dst + "." + ftn.name + ".jvl");
+		ftn.snapshot->graphviz(dst + "." + ftn.name + ".dot");
 	}
 
 	jvl::io::write_lines(dst, unit.generate_glsl());
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace jvl {
+
+// Incremental 64-bit FNV-1a hashing, stable across processes so
+// that it can be used to key persistent caches
+struct Hasher {
+	uint64_t state = 0xcbf29ce484222325ull;
+
+	Hasher &bytes(const void *data, size_t size) {
+		auto p = reinterpret_cast <const uint8_t *> (data);
+		for (size_t i = 0; i < size; i++) {
+			state ^= p[i];
+			state *= 0x100000001b3ull;
+		}
+
+		return *this;
+	}
+
+	template <typename T>
+	requires std::is_arithmetic_v <T> || std::is_enum_v <T>
+	Hasher &operator<<(const T &value) {
+		return bytes(&value, sizeof(T));
+	}
+
+	// Strings are length prefixed to keep sequences unambiguous
+	Hasher &operator<<(std::string_view str) {
+		*this << str.size();
+		return bytes(str.data(), str.size());
+	}
+
+	uint64_t value() const {
+		return state;
+	}
+};
+
+} // namespace jvl
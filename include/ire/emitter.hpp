@@ -7,6 +7,7 @@
 #include "../thunder/buffer.hpp"
 #include "../thunder/atom.hpp"
 #include "../thunder/enumerations.hpp"
+#include "../thunder/value_table.hpp"
 
 namespace jvl::ire {
 
@@ -38,6 +39,10 @@ public:
 	std::stack <bool> classify;
 	std::stack <cf_await> control_flow_ends;
 	std::stack <reference> scopes;
+	std::stack <std::optional <thunder::ValueTable>> interned;
+
+	// Opt-in interning of immutable atoms for newly pushed scopes
+	bool interning = false;
 
 	Emitter() = default;
 
@@ -48,6 +53,10 @@ public:
 	// Emitting instructions during function invocation
 	Index emit(const thunder::Atom &);
 
+	// Emitting atoms which are never mutated, returning an
+	// existing duplicate instead if the scope is interning
+	Index intern(const thunder::Atom &);
+
 	// Qualifiers
 	Index emit_qualifier(Index, Index, thunder::QualifierKind);
 
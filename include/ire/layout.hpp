@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <type_traits>
 // #include <algorithm>
 
@@ -47,15 +48,13 @@ concept aggregate = requires(T &t) {
 };
 
 // Unique type index generator
-inline int64_t type_index_counter = 0;
+inline std::atomic <int64_t> type_index_counter = 0;
 
 template <typename T>
 int64_t type_counter()
 {
-	// Force ID fetch at runtime
-	static int64_t c = -1;
-	if (c == -1)
-		c = type_index_counter++;
+	// Force ID fetch at runtime, once even if traced concurrently
+	static const int64_t c = type_index_counter++;
 	return c;
 }
 
@@ -17,11 +17,8 @@ inline thunder::LinkageUnit link(const std::vector <thunder::TrackedBuffer> &tra
 template <typename ... Args>
 inline thunder::LinkageUnit link(const Args &... args)
 {
-	std::vector <thunder::TrackedBuffer> tracked { args... };
-
 	thunder::LinkageUnit unit;
-	for (auto &tb : tracked)
-		unit.add(tb);
+	(unit.add(args), ...);
 
 	return unit;
 }
@@ -9,12 +9,13 @@
 
 namespace jvl::ire {
 
-// Methods to translate native C++ primitives
-thunder::Index translate_primitive(bool);
-thunder::Index translate_primitive(int32_t);
-thunder::Index translate_primitive(uint32_t);
-thunder::Index translate_primitive(uint64_t);
-thunder::Index translate_primitive(float);
+// Methods to translate native C++ primitives; shared translations may be
+// interned by the emitter, and must never be used as mutable values
+thunder::Index translate_primitive(bool, bool = false);
+thunder::Index translate_primitive(int32_t, bool = false);
+thunder::Index translate_primitive(uint32_t, bool = false);
+thunder::Index translate_primitive(uint64_t, bool = false);
+thunder::Index translate_primitive(float, bool = false);
 
 // Concepts for natives
 template <typename T>
@@ -97,7 +98,7 @@ struct native_t : tagged {
 	native_t &operator=(const T &v) {
 		auto &em = Emitter::active;
 		if (cached())
-			em.emit_store(ref.id, translate_primitive(v));
+			em.emit_store(ref.id, translate_primitive(v, true));
 		else
 			ref = translate_primitive(v);
 
@@ -46,7 +46,8 @@ struct Procedure : thunder::TrackedBuffer {
 	}
 
 	auto &named(const std::string &name_) {
-		name = name_;
+		edit().name = name_;
+		publish();
 		return *this;
 	}
 
@@ -111,7 +112,7 @@ struct ProcedureBuilder {
 
 		auto &em = Emitter::active;
 
-		em.push(result);
+		em.push(result.edit());
 		{
 			auto args = typename S::args_t();
 
@@ -134,7 +135,7 @@ struct ProcedureBuilder {
 		
 		auto &em = Emitter::active;
 
-		em.push(result);
+		em.push(result.edit());
 		{
 			auto args = typename S::args_t();
 
@@ -53,7 +53,7 @@ thunder::Index list_from_args(const T &t, const Args &... args)
 	auto &em = Emitter::active;
 
 	thunder::List l;
-	l.item = native_t <T> (t).synthesize().id;
+	l.item = translate_primitive(t, true);
 
 	if constexpr (sizeof...(args))
 		l.next = list_from_args(args...);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <filesystem>
 #include <string>
 #include <vector>
 
@@ -18,6 +19,7 @@ enum class Target {
 	spirv_assembly,
 	spirv_binary,
 	spirv_binary_via_glsl,
+	jit_gcc,
 	__end,
 };
 
@@ -44,4 +46,26 @@ using FunctionResult = void *;
 
 using GeneratedResult = bestd::variant <SourceResult, BinaryResult, FunctionResult>;
 
+// Native compilation options for JIT targets
+struct JitOptions {
+	// Optimization level, as in -O0 through -O3
+	int32_t optimization = 0;
+
+	bool debug_info = false;
+
+	// Generating code for the host processor (-march=native)
+	bool native = false;
+
+	// Reproducer of the compilation, skipped if empty
+	std::filesystem::path dump;
+
+	// Directory of compiled shared objects, keyed by the linked
+	// IR and these options (and the host processor for native
+	// builds); caching is disabled if empty
+	std::filesystem::path cache;
+
+	// Passed verbatim to the driver, e.g. -lm
+	std::vector <std::string> driver;
+};
+
 } // namespace jvl
\ No newline at end of file
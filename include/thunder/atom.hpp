@@ -10,8 +10,13 @@
 
 namespace jvl::thunder {
 
-// Index type, small to create compact IR
+// Index type, small to create compact IR; wide indices lift the limit
+// of 32767 atoms per buffer at the cost of doubling the size of atoms
+#ifdef JVL_WIDE_INDEX
+using Index = int32_t;
+#else
 using Index = int16_t;
+#endif
 
 // Addresses referenced in an instruction,
 // useful for various reindexing operations
@@ -304,6 +309,11 @@ struct alignas(4) Atom : atom_base {
 	Addresses addresses();
 
 	void reindex(const reindex <Index> &);
+
+	// Canonical key over the fields of the atom (excluding padding),
+	// equal keys if and only if the atoms are bitwise equal; with wide
+	// indices the fields no longer fit, and distinct atoms may collide
+	uint64_t hash() const;
 	
 	std::string to_assembly_string() const;
 	std::string to_pretty_string() const;
@@ -313,6 +323,6 @@ struct alignas(4) Atom : atom_base {
 std::string format_as(const Atom &atom);
 
 // We want the Atom Intermediate Represenation (AIR) to be lightweight
-static_assert(sizeof(Atom) == 8);
+static_assert(sizeof(Atom) == 4 * sizeof(Index));
 
 } // namespace jvl::thunder
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "linkage_unit.hpp"
+#include "optimization.hpp"
+#include "thread_pool.hpp"
+
+namespace jvl::thunder {
+
+// Procedures which are linked and compiled together
+struct BatchItem {
+	std::vector <TrackedBuffer> procedures;
+
+	Target target = Target::glsl;
+	Stage stage = Stage::compute;
+
+	// Optimization passes over the procedures, skipped if empty
+	std::optional <Optimizer> optimizer = std::nullopt;
+
+	JitOptions jit = {};
+	SpirvOptions spirv = {};
+};
+
+// Per-phase timing of an item, in microseconds
+struct BatchTiming {
+	using duration_t = std::chrono::duration <double, std::micro>;
+
+	// Time spent waiting for a worker
+	duration_t queued;
+
+	duration_t optimization;
+	duration_t linkage;
+	duration_t generation;
+
+	duration_t total() const;
+};
+
+struct BatchResult {
+	GeneratedResult result;
+	BatchTiming timing;
+};
+
+// Compiles batches of items on a work-stealing thread pool
+class BatchCompiler {
+	ThreadPool pool;
+public:
+	BatchCompiler(size_t = std::thread::hardware_concurrency());
+
+	BatchCompiler(const BatchCompiler &) = delete;
+	BatchCompiler &operator=(const BatchCompiler &) = delete;
+
+	size_t size() const;
+
+	std::future <BatchResult> submit(BatchItem);
+	std::vector <std::future <BatchResult>> submit(std::vector <BatchItem>);
+
+	// Compiling a single item on the calling thread
+	static BatchResult compile(const BatchItem &);
+};
+
+} // namespace jvl::thunder
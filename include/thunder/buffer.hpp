@@ -3,10 +3,13 @@
 #include <filesystem>
 #include <fstream>
 #include <set>
+#include <span>
 #include <vector>
 
 #include "atom.hpp"
+#include "index_set.hpp"
 #include "qualified_type.hpp"
+#include "type_table.hpp"
 
 namespace jvl::thunder {
 
@@ -25,8 +28,6 @@ class Buffer {
 	QualifiedType semalz(Index);
 
 	// Populate the synthesized set
-	bool naturally_forced(const Atom &);
-
 	void mark_children(Index);
 	void mark(Index, bool = false);
 public:
@@ -37,16 +38,20 @@ public:
 	};
 
 	size_t pointer;
-	std::set <Index> marked;
+	IndexSet marked;
 	std::vector <Atom> atoms;
-	std::vector <QualifiedType> types;
+	TypeTable types;
 
 	struct Decorations {
-		std::map <Index, TypeHint> type;
-		std::set <Index> phantom;
-		std::set <Index> materialize;
+		IndexMap <TypeHint> type;
+		IndexSet phantom;
+		IndexSet materialize;
 
 		std::string to_string(Index) const;
+
+		// Decorations of the atoms kept after rebuilding the buffer,
+		// given the new index of each old atom (-1 if removed)
+		Decorations relocated(std::span <const Index>) const;
 	} decorations;
 
 	Buffer();
@@ -56,7 +61,8 @@ public:
 	void clear();
 
 	// Analysis methods
-	Index reference_of(Index);
+	Index reference_of(Index) const;
+	bool naturally_forced(const Atom &);
 
 	// Debugging and visualization utilities
 	void write(std::ofstream &) const;
@@ -81,6 +87,27 @@ public:
 	std::vector <QualifiedType> expand_list_types(Index) const;
 };
 
+// Read-only view of a buffer, for generators and analyses which only
+// inspect it; the viewed buffer must outlive the view
+struct BufferView {
+	size_t pointer;
+	std::span <const Atom> atoms;
+	const TypeTable &types;
+	const IndexSet &marked;
+	const Buffer::Decorations &decorations;
+
+	BufferView(const Buffer &);
+
+	Index reference_of(Index) const;
+
+	void display_assembly() const;
+
+	const Atom &operator[](size_t) const;
+
+	std::vector <Index> expand_list(Index) const;
+	std::vector <QualifiedType> expand_list_types(Index) const;
+};
+
 #define JVL_BUFFER_DUMP_ON_ASSERT(cond, ...)	\
 	do {					\
 		if (!(cond))			\
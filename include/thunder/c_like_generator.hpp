@@ -10,31 +10,48 @@
 
 namespace jvl::thunder::detail {
 
-struct auxiliary_block_t : Buffer {
+struct auxiliary_block_t : BufferView {
 	std::map <Index, std::string> struct_names;
 
-	auxiliary_block_t(const Buffer &buffer, const auto &names)
-		: Buffer(buffer), struct_names(names) {}
+	auxiliary_block_t(const BufferView &view, const auto &names)
+		: BufferView(view), struct_names(names) {}
 };
 
 struct c_like_generator_t : auxiliary_block_t {
-	std::map <Index, std::string> local_variables;
+	// Names of the local variables, empty for inlined atoms
+	std::vector <std::string> local_variables;
+	size_t locals;
 	size_t indentation;
 	std::string source;
 
+	// Shared expressions which are bound to temporaries
+	// instead of being inlined at each of their uses
+	std::vector <bool> bound;
+
 	c_like_generator_t(const auxiliary_block_t &);
 
+	void bind();
+
 	void comment(const std::string &);
 	void finish(const std::string &, bool = true);
 
+	std::string variable(Index);
+
 	void declare(Index);
+	void define(Index);
 	void define(Index, const std::string &);
-	void assign(int, const std::string &);
-	
-	std::string reference(Index) const;
-	std::string inlined(Index) const;
+	void assign(Index, Index);
+	void condition(const char *, Index);
+
+	// Expressions are written directly to the end of the given string
+	void reference(std::string &, Index) const;
+	void inlined(std::string &, Index) const;
+	void arguments(std::string &, Index) const;
 
-	std::vector <std::string> arguments(Index) const;
+	// Names of callees are only loaded once from the tracked buffer cache
+	mutable std::map <Index, std::string> callees;
+
+	const std::string &callee(Index) const;
 
 	struct type_string {
 		std::string pre;
@@ -43,6 +60,11 @@ struct c_like_generator_t : auxiliary_block_t {
 
 	type_string type_to_string(const QualifiedType &) const;
 
+	// Type strings are shared by all atoms with the same interned type
+	mutable std::map <TypeId, type_string> type_strings;
+
+	const type_string &atom_type_to_string(Index) const;
+
 	// Per-atom generator
 	void generate(Index);
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <stack>
 
 #include "../common/logging.hpp"
@@ -26,7 +27,7 @@ struct Scope {
 	}
 };
 
-std::string format_as(const Scope &scope)
+inline std::string format_as(const Scope &scope)
 {
 	return fmt::format("[{}, {}]", scope.begin, scope.end);
 }
@@ -82,9 +83,7 @@ struct ScopeHierarchy : Scope {
 // struct Block : Scope {
 // };
 
-// TODO: CFG construction...
-// TODO: flesh this out at some point with connections and phis...
-ScopeHierarchy cfg_blocks(const Buffer &buffer)
+inline ScopeHierarchy cfg_blocks(const Buffer &buffer)
 {
 	MODULE(cfg_blocks);
 
@@ -100,11 +99,29 @@ ScopeHierarchy cfg_blocks(const Buffer &buffer)
 		if (auto branch = atom.get <Branch> ()) {
 			switch (branch->kind) {
 
+			case conditional_if:
 			case loop_while:
+			case loop_for:
 			{
 				stack.emplace(i, -1);
 			} break;
 
+			// Each branch of a conditional chain is a separate scope
+			case conditional_else_if:
+			case conditional_else:
+			{
+				auto done = stack.top();
+				done.end = i - 1;
+				stack.pop();
+
+				JVL_ASSERT(!stack.empty(), "scope stack is unexpectedly empty");
+
+				auto &higher = stack.top();
+				higher.nested.emplace_back(done);
+
+				stack.emplace(i, -1);
+			} break;
+
 			case control_flow_end:
 			{
 				auto done = stack.top();
@@ -116,6 +133,11 @@ ScopeHierarchy cfg_blocks(const Buffer &buffer)
 				higher.nested.emplace_back(done);
 			} break;
 
+			// Jumps do not introduce any new scopes
+			case control_flow_skip:
+			case control_flow_stop:
+				break;
+
 			default:
 				JVL_ABORT("unhandled branch kind:\n{}", atom);
 			}
@@ -129,4 +151,99 @@ ScopeHierarchy cfg_blocks(const Buffer &buffer)
 	return stack.top();
 }
 
+// Control flow graph over the linear IR; basic blocks are ranges of atoms,
+// and branches are placed in blocks of their own. All per-block data
+// is kept in flat arrays, with adjacency stored as compressed rows
+struct ControlFlowGraph {
+	// Block of each atom, and the range of atoms in each block
+	std::vector <Index> block_of;
+	std::vector <Index> first;
+	std::vector <Index> last;
+
+	// Edges between blocks
+	std::vector <uint32_t> successor_offsets;
+	std::vector <Index> successor_list;
+	std::vector <uint32_t> predecessor_offsets;
+	std::vector <Index> predecessor_list;
+
+	// Header of the innermost loop containing each block, or -1
+	std::vector <Index> loop;
+
+	// Dominator tree; the entry is its own immediate dominator and
+	// unreachable blocks have none. The preorder and postorder numbers
+	// of the tree answer dominance queries in constant time
+	std::vector <Index> idom;
+	std::vector <uint32_t> preorder;
+	std::vector <uint32_t> postorder;
+
+	// Dominance frontiers
+	std::vector <uint32_t> frontier_offsets;
+	std::vector <Index> frontier_list;
+
+	// Variables are the roots of store destinations, each with a dense
+	// identifier; liveness is kept as one row of bits per block
+	std::vector <Index> variables;
+	std::vector <Index> variable_of;
+
+	size_t words = 0;
+	std::vector <uint64_t> live_in;
+	std::vector <uint64_t> live_out;
+
+	// Variables which require phis at the entry of each block
+	std::vector <uint32_t> phi_offsets;
+	std::vector <Index> phi_list;
+
+	size_t size() const {
+		return first.size();
+	}
+
+	std::span <const Index> successors(Index b) const {
+		return row(successor_offsets, successor_list, b);
+	}
+
+	std::span <const Index> predecessors(Index b) const {
+		return row(predecessor_offsets, predecessor_list, b);
+	}
+
+	std::span <const Index> frontier(Index b) const {
+		return row(frontier_offsets, frontier_list, b);
+	}
+
+	std::span <const Index> phis(Index b) const {
+		return row(phi_offsets, phi_list, b);
+	}
+
+	bool reachable(Index b) const {
+		return idom[b] != -1;
+	}
+
+	bool dominates(Index a, Index b) const {
+		return reachable(a) && reachable(b)
+			&& (preorder[a] <= preorder[b])
+			&& (postorder[b] <= postorder[a]);
+	}
+
+	bool live_at_entry(Index b, Index variable) const {
+		return bit(live_in, b, variable);
+	}
+
+	bool live_at_exit(Index b, Index variable) const {
+		return bit(live_out, b, variable);
+	}
+
+	void display() const;
+private:
+	static std::span <const Index> row(const std::vector <uint32_t> &offsets,
+					   const std::vector <Index> &list,
+					   Index b) {
+		return { list.data() + offsets[b], list.data() + offsets[b + 1] };
+	}
+
+	bool bit(const std::vector <uint64_t> &rows, Index b, Index variable) const {
+		return (rows[b * words + variable / 64] >> (variable % 64)) & 1;
+	}
+};
+
+ControlFlowGraph control_flow_graph(const Buffer &);
+
 } // namespace jvl::thunder
\ No newline at end of file
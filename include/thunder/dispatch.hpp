@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+
+#include "interpreter.hpp"
+#include "linkage_unit.hpp"
+#include "thread_pool.hpp"
+
+namespace jvl::thunder {
+
+// Host memory bound to the global variables of a compute kernel,
+// in the std430 layout of their declarations
+struct DispatchBindings {
+	// Storage buffers, by binding
+	std::map <Index, void *> buffers;
+
+	// Push constant block, where members declared
+	// at an offset are read from that offset
+	const void *push_constants = nullptr;
+};
+
+// Compute kernel lowered once for the interpreter, whose workgroups
+// are run on the host across the workers of a thread pool; kernels
+// with barriers run the invocations of a workgroup in turns, each up
+// to its next barrier, on a stack of its own
+class ComputeKernel {
+	Interpreter interpreter;
+	glm::uvec3 local_size;
+
+	// Shared variables are packed into one block per workgroup,
+	// with the offsets indexed like the globals of the interpreter
+	std::vector <uint32_t> shared_offsets;
+	uint32_t shared_size;
+public:
+	ComputeKernel(const LinkageUnit &);
+
+	// Size of each workgroup, from layout_local_size
+	glm::uvec3 workgroup_size() const;
+
+	// Blocks until every workgroup of the grid has completed;
+	// must not be called from a task running on the same pool
+	void dispatch(uint32_t, uint32_t, uint32_t,
+		const DispatchBindings &,
+		ThreadPool & = ThreadPool::shared()) const;
+};
+
+// Lowering and dispatching a kernel in one go
+void dispatch(const LinkageUnit &, uint32_t, uint32_t, uint32_t, const DispatchBindings &);
+
+} // namespace jvl::thunder
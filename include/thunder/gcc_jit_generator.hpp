@@ -13,11 +13,20 @@ namespace jvl::thunder::detail {
 // Type information with size and alignment info
 struct gcc_type_info {
 	gcc_jit_type *real = nullptr;
+
+	// Native vectors are passed and stored as structures, which
+	// keeps the calling convention and the layout of solid_t
+	gcc_jit_type *storage = nullptr;
+
 	uint32_t size = 0;
 	uint32_t align = 0;
+
+	gcc_jit_type *stored() const {
+		return storage ? storage : real;
+	}
 };
 
-struct gcc_jit_function_generator_t : Buffer {
+struct gcc_jit_function_generator_t : BufferView {
 	gcc_jit_context *const context;
 	gcc_jit_function *function;
 	gcc_jit_block *block;
@@ -27,7 +36,7 @@ struct gcc_jit_function_generator_t : Buffer {
 	bestd::hash_table <Index, gcc_jit_object *> values;
 	bestd::hash_table <QualifiedType, gcc_type_info> mapped_types;
 
-	gcc_jit_function_generator_t(gcc_jit_context *const , const Buffer &);
+	gcc_jit_function_generator_t(gcc_jit_context *const , const BufferView &);
 
 	// Generating types
 	gcc_type_info jitify_type(QualifiedType);
@@ -62,4 +71,8 @@ struct gcc_jit_function_generator_t : Buffer {
 	void generate();
 };
 
+// Whether every atom of the function can be lowered, which excludes
+// control flow, calls, storage and array accesses
+bool gcc_jit_supported(const BufferView &);
+
 } // namespace jvl::thunder::detail
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "atom.hpp"
+
+namespace jvl::thunder {
+
+// Dense set of atom indices, one bit per atom of the buffer;
+// iteration visits the indices in increasing order
+class IndexSet {
+	std::vector <uint64_t> words;
+	size_t elements = 0;
+
+	static constexpr size_t bits = 64;
+public:
+	struct iterator {
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Index;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Index *;
+		using reference = Index;
+
+		const IndexSet *set = nullptr;
+		size_t position = 0;
+
+		Index operator*() const {
+			return Index(position);
+		}
+
+		// Skips ahead to the next set bit, or the end
+		iterator &operator++() {
+			position = set->next(position + 1);
+			return *this;
+		}
+
+		iterator operator++(int) {
+			iterator old = *this;
+			++(*this);
+			return old;
+		}
+
+		bool operator==(const iterator &) const = default;
+	};
+
+	size_t next(size_t i) const {
+		size_t w = i / bits;
+		if (w >= words.size())
+			return end().position;
+
+		uint64_t word = words[w] & (~uint64_t(0) << (i % bits));
+		while (!word) {
+			if (++w >= words.size())
+				return end().position;
+
+			word = words[w];
+		}
+
+		return w * bits + std::countr_zero(word);
+	}
+
+	bool contains(Index i) const {
+		size_t w = size_t(i) / bits;
+		return (i >= 0) && (w < words.size())
+			&& (words[w] >> (size_t(i) % bits)) & 1;
+	}
+
+	size_t count(Index i) const {
+		return contains(i);
+	}
+
+	std::pair <iterator, bool> insert(Index i) {
+		size_t w = size_t(i) / bits;
+		if (w >= words.size())
+			words.resize(w + 1, 0);
+
+		uint64_t bit = uint64_t(1) << (size_t(i) % bits);
+		bool inserted = !(words[w] & bit);
+		words[w] |= bit;
+		elements += inserted;
+
+		return { iterator { this, size_t(i) }, inserted };
+	}
+
+	size_t erase(Index i) {
+		if (!contains(i))
+			return 0;
+
+		words[size_t(i) / bits] &= ~(uint64_t(1) << (size_t(i) % bits));
+		elements--;
+
+		return 1;
+	}
+
+	void clear() {
+		words.clear();
+		elements = 0;
+	}
+
+	size_t size() const {
+		return elements;
+	}
+
+	bool empty() const {
+		return elements == 0;
+	}
+
+	iterator begin() const {
+		return iterator { this, next(0) };
+	}
+
+	iterator end() const {
+		return iterator { this, words.size() * bits };
+	}
+
+	// Indices moved to their new positions, where indices
+	// mapped to -1 (or beyond the mapping) are dropped
+	IndexSet relocated(std::span <const Index> mapping) const {
+		IndexSet result;
+		for (Index i : *this) {
+			if (size_t(i) < mapping.size() && mapping[i] != -1)
+				result.insert(mapping[i]);
+		}
+
+		return result;
+	}
+};
+
+// Sparse map from atom indices to values, kept as a flat vector sorted
+// by index; most insertions are for the latest atom, which appends
+template <typename T>
+class IndexMap {
+	using entry_t = std::pair <Index, T>;
+
+	std::vector <entry_t> entries;
+
+	static bool before(const entry_t &entry, Index i) {
+		return entry.first < i;
+	}
+public:
+	using iterator = typename std::vector <entry_t> ::iterator;
+	using const_iterator = typename std::vector <entry_t> ::const_iterator;
+
+	iterator find(Index i) {
+		auto it = std::lower_bound(entries.begin(), entries.end(), i, before);
+		return (it != entries.end() && it->first == i) ? it : entries.end();
+	}
+
+	const_iterator find(Index i) const {
+		auto it = std::lower_bound(entries.begin(), entries.end(), i, before);
+		return (it != entries.end() && it->first == i) ? it : entries.end();
+	}
+
+	bool contains(Index i) const {
+		return find(i) != entries.end();
+	}
+
+	const T &at(Index i) const {
+		auto it = find(i);
+		if (it == entries.end())
+			throw std::out_of_range("index is not in the map");
+
+		return it->second;
+	}
+
+	T &operator[](Index i) {
+		if (entries.empty() || entries.back().first < i)
+			return entries.emplace_back(i, T()).second;
+
+		auto it = std::lower_bound(entries.begin(), entries.end(), i, before);
+		if (it == entries.end() || it->first != i)
+			it = entries.emplace(it, i, T());
+
+		return it->second;
+	}
+
+	void clear() {
+		entries.clear();
+	}
+
+	size_t size() const {
+		return entries.size();
+	}
+
+	bool empty() const {
+		return entries.empty();
+	}
+
+	iterator begin() { return entries.begin(); }
+	iterator end() { return entries.end(); }
+
+	const_iterator begin() const { return entries.begin(); }
+	const_iterator end() const { return entries.end(); }
+
+	// Entries moved to their new positions, see IndexSet::relocated
+	IndexMap relocated(std::span <const Index> mapping) const {
+		IndexMap result;
+		for (auto &[i, value] : entries) {
+			if (size_t(i) < mapping.size() && mapping[i] != -1)
+				result.entries.emplace_back(mapping[i], value);
+		}
+
+		std::sort(result.entries.begin(), result.entries.end(),
+			[](const entry_t &a, const entry_t &b) { return a.first < b.first; });
+
+		return result;
+	}
+};
+
+} // namespace jvl::thunder
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <concepts>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../common/logging.hpp"
+
+#include "buffer.hpp"
+#include "linkage_unit.hpp"
+
+namespace jvl::thunder {
+
+namespace detail {
+
+// Instruction set of the interpreter; operands are byte offsets
+// into the frame of the running function unless noted otherwise,
+// and count is the number of components of vector operations
+#define JVL_INTERPRETER_OPCODES(X)						\
+	/* Moving data: dst <- a (c bytes), zeros or broadcasts of a */	\
+	X(copy) X(zero) X(splat32) X(splat64)				\
+	/* Pointers: frame addresses, dst <- a + index(b) * stride(c) */	\
+	X(address) X(index)							\
+	/* Memory: dst <- *(a + b), *(dst + b) <- a, both of c bytes */	\
+	X(load) X(store)							\
+	/* Control flow: targets are instruction indices */		\
+	X(jump) X(unless) X(call) X(ret)					\
+	/* Suspends the invocation until its workgroup catches up */	\
+	X(barrier)								\
+	/* Conversions between component types */			\
+	X(f32_to_i32) X(f32_to_u32) X(i32_to_f32) X(u32_to_f32)		\
+	X(i32_to_u64) X(u32_to_u64) X(u64_to_u32)				\
+	X(f32_to_u64) X(u64_to_f32)						\
+	/* Arithmetic, wrapping integer operations share instructions */	\
+	X(add_u32) X(sub_u32) X(mul_u32) X(neg_u32)				\
+	X(add_u64) X(sub_u64) X(mul_u64) X(neg_u64)				\
+	X(add_f32) X(sub_f32) X(mul_f32) X(neg_f32)				\
+	X(div_i32) X(div_u32) X(div_u64) X(div_f32)				\
+	X(mod_i32) X(mod_u32) X(mod_u64) X(mod_f32)				\
+	/* Bitwise and logical operations, booleans are 0 or 1 */	\
+	X(and_u32) X(or_u32) X(xor_u32) X(not_bool)				\
+	X(and_u64) X(or_u64) X(xor_u64)					\
+	X(shl_u32) X(shr_i32) X(shr_u32) X(shl_u64) X(shr_u64)		\
+	/* Comparisons, true if they hold for every component */	\
+	X(eq_u32) X(eq_u64) X(eq_f32)						\
+	X(ne_u32) X(ne_u64) X(ne_f32)						\
+	X(lt_i32) X(lt_u32) X(lt_u64) X(lt_f32)				\
+	X(le_i32) X(le_u32) X(le_u64) X(le_f32)				\
+	/* Component-wise intrinsics */					\
+	X(abs_i32) X(abs_f32)							\
+	X(min_i32) X(min_u32) X(min_f32)					\
+	X(max_i32) X(max_u32) X(max_f32)					\
+	X(clamp_i32) X(clamp_u32) X(clamp_f32)				\
+	X(sin) X(cos) X(tan) X(asin) X(acos) X(atan)				\
+	X(sinh) X(cosh) X(tanh) X(sqrt) X(exp) X(log)				\
+	X(floor) X(ceil) X(fract)						\
+	X(pow) X(atan2) X(mix) X(smoothstep)					\
+	/* Geometric intrinsics over a vector of count components */	\
+	X(dot) X(length) X(normalize) X(cross) X(reflect)			\
+	/* Matrix products, see interpreter_matrix_shape */		\
+	X(matmul)
+
+enum interpreter_opcode : uint16_t {
+#define JVL_INTERPRETER_ENUM(name) op_##name,
+	JVL_INTERPRETER_OPCODES(JVL_INTERPRETER_ENUM)
+#undef JVL_INTERPRETER_ENUM
+	__op_end
+};
+
+extern const char *tbl_interpreter_opcode[__op_end];
+
+// Pre-decoded instruction, the handler is resolved once lowering is
+// complete so that dispatch jumps straight to the implementation
+struct interpreter_instruction {
+	const void *handler = nullptr;
+	interpreter_opcode code;
+	uint16_t count = 0;
+	uint32_t dst = 0;
+	uint32_t a = 0;
+	uint32_t b = 0;
+	uint32_t c = 0;
+};
+
+// Matrix products treat every operand as a column-major matrix: count
+// holds the rows, inner dimension and columns (four bits each) and c
+// holds the column strides of a, b and dst (eight bits each)
+struct interpreter_matrix_shape {
+	uint32_t rows;
+	uint32_t inner;
+	uint32_t columns;
+	uint32_t strides[3];
+
+	uint16_t count() const {
+		return rows | (inner << 4) | (columns << 8);
+	}
+
+	uint32_t packed() const {
+		return strides[0] | (strides[1] << 8) | (strides[2] << 16);
+	}
+};
+
+// Arguments are copied into the frame of the callee, and out
+// or inout arguments are copied back once the callee returns
+struct interpreter_argument {
+	uint32_t caller;
+	uint32_t callee;
+	uint32_t size;
+	bool writeback;
+};
+
+struct interpreter_call {
+	uint32_t function;
+	std::vector <interpreter_argument> arguments;
+};
+
+// Global variables are bound by the caller, and their addresses
+// are placed in pointer slots of the frame on entry
+struct interpreter_global {
+	QualifierKind kind;
+	Index binding;
+	uint32_t size;
+};
+
+struct interpreter_binding {
+	uint32_t slot;
+	uint32_t global;
+};
+
+struct interpreter_function {
+	std::string name;
+	std::vector <interpreter_instruction> code;
+
+	// Constants, copied to the frame at base on entry; the parameters
+	// come before base so that they are filled in by the caller
+	std::vector <std::byte> image;
+	uint32_t base = 0;
+
+	std::vector <uint32_t> parameters;
+	std::vector <uint32_t> sizes;
+	std::vector <interpreter_binding> bindings;
+
+	uint32_t returns = 0;
+	uint32_t frame = 0;
+};
+
+struct interpreter_program {
+	std::vector <interpreter_function> functions;
+	std::vector <interpreter_call> calls;
+	std::vector <interpreter_global> globals;
+
+	// Size of the deepest chain of frames, starting at each function
+	std::vector <uint32_t> stack;
+};
+
+// Frames are laid out back to back on the stack of an invocation
+inline uint32_t interpreter_frame_size(const interpreter_function &function)
+{
+	return (function.frame + 15) & ~uint32_t(15);
+}
+
+// Lowering of a single function of the linkage unit; value semantics
+// follow the SPIR-V generator, with materialized atoms evaluated in
+// place and the rest evaluated where they are used
+struct interpreter_function_generator_t : BufferView {
+	interpreter_program &program;
+	const LinkageUnit &unit;
+	const Function &function;
+	interpreter_function &result;
+
+	// Slots of materialized atoms and of their temporaries
+	std::map <Index, uint32_t> values;
+	std::map <Index, uint32_t> temporaries;
+
+	// Slots of inlined atoms, valid until the next label or store
+	std::map <Index, uint32_t> cache;
+
+	// Constants, keyed by their type and bits
+	std::map <std::pair <PrimitiveType, uint64_t>, uint32_t> constants;
+
+	// Variables which are written to, and pointers to global variables
+	std::map <Index, uint32_t> locals;
+	std::map <uint32_t, uint32_t> globals;
+	std::set <Index> lvalues;
+
+	// Open control flow constructs, with jumps waiting for their targets
+	struct construct {
+		BranchKind kind;
+		uint32_t header;
+		std::vector <uint32_t> next;
+		std::vector <uint32_t> continuing;
+		std::vector <uint32_t> merge;
+	};
+
+	std::vector <construct> constructs;
+
+	// Location of a value, either in the frame or behind a pointer slot
+	struct location {
+		bool indirect;
+		uint32_t slot;
+		uint32_t offset;
+	};
+
+	interpreter_function_generator_t(interpreter_program &, const LinkageUnit &, size_t);
+
+	// Types and layouts
+	struct layout_info {
+		uint32_t size;
+		uint32_t align;
+	};
+
+	QualifiedType resolve(QualifiedType) const;
+	std::vector <QualifiedType> fields(QualifiedType) const;
+	PrimitiveType primitive(Index) const;
+
+	layout_info layout(const QualifiedType &) const;
+	uint32_t field_offset(const QualifiedType &, Index) const;
+	uint32_t element_stride(const QualifiedType &) const;
+
+	// Frame allocation and instructions
+	uint32_t allocate(const layout_info &);
+	uint32_t allocate(const QualifiedType &);
+	uint32_t slot(Index);
+	uint32_t constant(const Primitive &);
+
+	uint32_t emit(interpreter_opcode, uint32_t = 0, uint32_t = 0, uint32_t = 0, uint32_t = 0, uint16_t = 0);
+	uint32_t here() const;
+	void label();
+	void patch(const std::vector <uint32_t> &, uint32_t);
+
+	void copy(uint32_t, uint32_t, uint32_t);
+	void convert(uint32_t, uint32_t, PrimitiveType, PrimitiveType);
+	uint32_t converted(uint32_t, PrimitiveType, PrimitiveType);
+	uint32_t splat(uint32_t, PrimitiveType, PrimitiveType);
+
+	// Values and locations
+	uint32_t pointer(const location &);
+	std::optional <location> address(Index);
+	uint32_t global_variable(Index);
+
+	void load(const location &, uint32_t, uint32_t);
+	void store(const location &, uint32_t, uint32_t);
+
+	uint32_t value(Index);
+	void compute(Index, uint32_t);
+	void define(Index);
+
+	// Per-atom generator
+	void generate(Index);
+
+	template <typename T>
+	void generate(const T &atom, Index i) {
+		MODULE(interpreter-generate);
+
+		JVL_ABORT("failed to lower atom for the interpreter: {} (@{})", atom, i);
+	}
+
+	void generate_operation(const Operation &, Index, uint32_t);
+	void generate_intrinsic(const Intrinsic &, Index, uint32_t);
+	void generate_construct(const Construct &, Index, uint32_t);
+	void generate_call(const Call &, Index, uint32_t);
+
+	void branch(const Branch &);
+
+	// Wholistic generation
+	void generate();
+};
+
+// Handlers of the instruction set, in the order of the opcodes
+const void *const *interpreter_handlers();
+
+// Runs a function from the start, or resumes it from a barrier; gives
+// the instruction to resume from if it stopped at a barrier, else zero
+uint32_t interpreter_execute(const interpreter_program &, uint32_t, std::byte *, void *, void *const *, uint32_t = 0);
+
+// Host values passed by the typed interface, where
+// booleans take up four bytes as they do in buffers
+template <typename T>
+struct interpreter_host {
+	using type = T;
+};
+
+template <>
+struct interpreter_host <bool> {
+	using type = uint32_t;
+};
+
+} // namespace detail
+
+// Runs a linked unit on the host without native compilation; the entry
+// point is the function named main, or else the first in the unit.
+// Values use the std430 layout of storage buffers, which solid_t
+// matches for scalars, vectors, matrices and structures
+class Interpreter {
+	detail::interpreter_program program;
+	uint32_t entry;
+	bool synchronized;
+
+	std::byte *stack() const;
+public:
+	Interpreter(const LinkageUnit &);
+
+	const detail::interpreter_program &lowered() const;
+
+	// Global variables (buffers, builtins, etc.) in binding order
+	const std::vector <detail::interpreter_global> &globals() const;
+
+	// Arguments and results are in the layout of the entry point's
+	// types, and globals holds an address for each global variable
+	void invoke(void *, const void *const *, void *const * = nullptr) const;
+	void invoke(std::byte *, void *, const void *const *, void *const *) const;
+
+	// Size of the stack required by an invocation
+	size_t stack_size() const;
+
+	// Whether the entry point waits on barriers, in which case
+	// invocations are run in turns through resume instead
+	bool barriers() const;
+
+	// Runs an invocation of an entry point without parameters until
+	// it returns, giving zero, or until it reaches a barrier, giving
+	// the point to resume from; the stack holds the suspended state
+	uint32_t resume(std::byte *, uint32_t, void *const *) const;
+
+	// Disassembly of the lowered functions
+	std::string disassemble() const;
+
+	template <typename R = void, typename ... Args>
+	R call(const Args &... args) const {
+		MODULE(interpreter);
+
+		JVL_ASSERT(program.globals.empty(),
+			"entry point of the interpreter uses global variables, "
+			"which must be bound with invoke");
+
+		std::tuple <typename detail::interpreter_host <Args> ::type...> values { args... };
+
+		const void *pointers[sizeof...(Args) + 1];
+		std::apply([&](const auto &... v) {
+			size_t j = 0;
+			((pointers[j++] = &v), ...);
+		}, values);
+
+		if constexpr (std::same_as <R, void>) {
+			invoke(nullptr, pointers);
+		} else {
+			typename detail::interpreter_host <R> ::type result;
+			invoke(&result, pointers);
+			return R(result);
+		}
+	}
+};
+
+} // namespace jvl::thunder
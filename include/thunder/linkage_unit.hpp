@@ -11,6 +11,7 @@
 #include "qualified_type.hpp"
 #include "tracked_buffer.hpp"
 #include "c_like_generator.hpp"
+#include "spirv_cache.hpp"
 #include "../target.hpp"
 
 namespace jvl::thunder {
@@ -31,13 +32,15 @@ struct Aggregate {
 	bool operator==(const Aggregate &) const;
 };
 
-struct Function : Buffer {
+// Views the shared contents of a callable, which it keeps alive
+struct Function : BufferView {
+	Snapshot snapshot;
 	size_t cid;
 	std::string name;
 	QualifiedType returns;
 	std::vector <QualifiedType> args;
 
-	Function(const Buffer &, const std::string &, size_t);
+	Function(const Snapshot &, size_t);
 };
 
 using TypeMap = std::map <Index, Index>;
@@ -94,6 +97,10 @@ struct LinkageUnit {
 	// Mapping function CIDs to local indices
 	std::map <Index, uint32_t> loaded;
 
+	// Contents linked for callees in place of their registered
+	// snapshots, e.g. copies which have been optimized
+	std::map <Index, Snapshot> substitutes;
+
 	std::vector <Function> functions;
 	std::vector <Aggregate> aggregates;
 	std::vector <TypeMap> types;
@@ -127,9 +134,9 @@ struct LinkageUnit {
 
 	using function_result_t = std::pair <Index, std::set <Index>>;
 
-	function_result_t process_function(const Function &);
+	function_result_t process_function(Function &&);
 
-	Index add(uint32_t, const NamedBuffer &);
+	Index add(uint32_t, const Snapshot &);
 	Index add(const TrackedBuffer &);
 
 	generator_list configure_generators() const;
@@ -141,15 +148,22 @@ struct LinkageUnit {
 	SourceResult generate_cpp() const;
 	SourceResult generate_cuda() const;
 
-	BinaryResult generate_spirv_via_glsl(const vk::ShaderStageFlagBits &) const;
+	BinaryResult generate_spirv(const vk::ShaderStageFlagBits &) const;
+	SourceResult generate_spirv_assembly(const vk::ShaderStageFlagBits &) const;
+	BinaryResult generate_spirv_via_glsl(const vk::ShaderStageFlagBits &, const SpirvOptions & = {}) const;
 
-	FunctionResult generate_jit_gcc() const;
+	FunctionResult generate_jit_gcc(const JitOptions & = {}) const;
 
-	GeneratedResult generate(const Target &, const Stage & = Stage::compute) const;
+	GeneratedResult generate(const Target &, const Stage & = Stage::compute, const JitOptions & = {}) const;
 
 	// Serializing
+	uint64_t hash() const;
+
 	void write(const std::filesystem::path &) const;
 	void write_assembly(const std::filesystem::path &) const;
 };
 
+// Translating target stages into Vulkan counterparts
+vk::ShaderStageFlagBits to_vulkan(Stage);
+
 } // namespace jvl::thunder
@@ -16,12 +16,16 @@ enum class OptimizationFlags : uint8_t {
 	eDeduplication		= 0b10,
 	eCastingElision		= 0b100,
 	eStoreElision		= 0b1000,
+	eConstantFolding	= 0b10000,
+	eLoopInvariance		= 0b100000,
 	eStable			= eDeadCodeElimination
 				| eCastingElision,
 	eAll			= eDeadCodeElimination
 				| eDeduplication
 				| eCastingElision
-				| eStoreElision,
+				| eStoreElision
+				| eConstantFolding
+				| eLoopInvariance,
 };
 
 DEFINE_FLAG_OPERATORS(OptimizationFlags, uint8_t);
@@ -36,8 +40,18 @@ enum class DisolveFlags : uint8_t {
 
 DEFINE_FLAG_OPERATORS(DisolveFlags, uint8_t);
 
+// Flags for legalizing instructions for C-family compiled targets
+enum class LegalizationFlags : uint8_t {
+	eNone			= 0b0,
+	// Operations on vectors of two or four components are kept
+	// intact, for targets which map them to native vector types
+	eNativeVectors		= 0b1,
+};
+
+DEFINE_FLAG_OPERATORS(LegalizationFlags, uint8_t);
+
 // Legalizing instructions for C-family compiled targets
-void legalize_for_cc(Buffer &);
+void legalize_for_cc(Buffer &, LegalizationFlags = LegalizationFlags::eNone);
 
 // Stitching mapped instruction blocks
 void stitch_mapped_instructions(Buffer &, std::vector <mapped_instruction_t> &);
@@ -51,11 +65,21 @@ struct Optimizer {
 	// Instruction distillation (deduplication)
 	uint32_t distill_types_once(Buffer &) const;
 	void distill_types(Buffer &) const;
+	uint32_t distill_once(Buffer &) const;
 	void distill(Buffer &) const;
 
+	// Constant folding and algebraic simplification
+	uint32_t fold_once(Buffer &) const;
+	void fold(Buffer &) const;
+
+	// Loop invariant code motion
+	uint32_t hoist_once(Buffer &) const;
+	void hoist(Buffer &) const;
+
 	// Instruction disolving (removal and elision)
 	bool disolve_casting_intrinsic(Relocation &, const Buffer &, const Intrinsic &, Index) const;
 	bool disolve_casting_constructor(Relocation &, const Buffer &, const Construct &, Index) const;
+	uint32_t disolve_stores(Buffer &) const;
 	void disolve_once(Buffer &, DisolveFlags) const;
 	void disolve(Buffer &, DisolveFlags = DisolveFlags::eAll) const;
 
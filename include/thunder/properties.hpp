@@ -224,4 +224,96 @@ constexpr bool side_effects(IntrinsicOperation opn)
 	return false;
 }
 
+// Intrinsics which are functions of their arguments alone
+constexpr bool pure(IntrinsicOperation opn)
+{
+	switch (opn) {
+	case cast_to_int:
+	case cast_to_ivec2:
+	case cast_to_ivec3:
+	case cast_to_ivec4:
+	case cast_to_uint:
+	case cast_to_uvec2:
+	case cast_to_uvec3:
+	case cast_to_uvec4:
+	case cast_to_float:
+	case cast_to_vec2:
+	case cast_to_vec3:
+	case cast_to_vec4:
+	case cast_to_uint64:
+	case sin:
+	case cos:
+	case tan:
+	case asin:
+	case acos:
+	case atan:
+	case sinh:
+	case cosh:
+	case tanh:
+	case sqrt:
+	case exp:
+	case pow:
+	case log:
+	case abs:
+	case clamp:
+	case min:
+	case max:
+	case fract:
+	case floor:
+	case ceil:
+	case length:
+	case dot:
+	case cross:
+	case normalize:
+	case reflect:
+	case mod:
+	case mix:
+	case smoothstep:
+	case glsl_floatBitsToInt:
+	case glsl_floatBitsToUint:
+	case glsl_intBitsToFloat:
+	case glsl_uintBitsToFloat:
+		return true;
+	default:
+		break;
+	}
+
+	return false;
+}
+
+// Global qualifiers whose values cannot change during an invocation
+constexpr bool invariant_kind(QualifierKind kind)
+{
+	switch (kind) {
+	case parameter:
+	case layout_in_flat:
+	case layout_in_noperspective:
+	case layout_in_smooth:
+	case push_constant:
+	case uniform_buffer:
+	case glsl_FragCoord:
+	case glsl_InstanceID:
+	case glsl_InstanceIndex:
+	case glsl_VertexID:
+	case glsl_VertexIndex:
+	case glsl_GlobalInvocationID:
+	case glsl_LocalInvocationID:
+	case glsl_LocalInvocationIndex:
+	case glsl_WorkGroupID:
+	case glsl_WorkGroupSize:
+	case glsl_SubgroupInvocationID:
+	case glsl_LaunchIDEXT:
+	case glsl_LaunchSizeEXT:
+	case glsl_InstanceCustomIndexEXT:
+	case glsl_PrimitiveID:
+	case glsl_ObjectToWorldEXT:
+	case glsl_WorldRayDirectionEXT:
+		return true;
+	default:
+		break;
+	}
+
+	return false;
+}
+
 } // namespace jvl::thunder
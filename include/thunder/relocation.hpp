@@ -25,4 +25,26 @@ struct Relocation : std::map <Index, Index> {
 	}
 };
 
+// Relocation of every atom of a buffer, indexed by the old atom; atoms
+// without a new position are -1, and addresses to them are unchanged
+struct DenseRelocation : std::vector <Index> {
+	DenseRelocation(size_t size) : std::vector <Index> (size, -1) {}
+
+	bool contains(Index addr) const {
+		return addr != -1 && size_t(addr) < size() && (*this)[addr] != -1;
+	}
+
+	void apply(Index &addr) const {
+		if (contains(addr))
+			addr = (*this)[addr];
+	}
+
+	void apply(Atom &atom) const {
+		auto addrs = atom.addresses();
+
+		apply(addrs.a0);
+		apply(addrs.a1);
+	}
+};
+
 } // namespace jvl::thunder
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "../target.hpp"
+
+namespace jvl::thunder {
+
+// Compiled SPIR-V binaries, kept in memory and optionally on disk;
+// keys are hashes of the source, stage and compilation options
+class SpirvCache {
+	std::mutex mutex;
+	std::unordered_map <uint64_t, BinaryResult> entries;
+
+	std::atomic <size_t> hit_count = 0;
+	std::atomic <size_t> miss_count = 0;
+
+	std::filesystem::path entry(uint64_t) const;
+public:
+	// On-disk entries are skipped if empty
+	const std::filesystem::path directory;
+
+	SpirvCache(const std::filesystem::path & = {});
+
+	std::optional <BinaryResult> find(uint64_t);
+	void insert(uint64_t, const BinaryResult &);
+	void clear();
+
+	size_t hits() const;
+	size_t misses() const;
+};
+
+// Options for compiling to SPIR-V
+struct SpirvOptions {
+	bool debug_info = true;
+
+	// Shared cache of results, disabled if null
+	SpirvCache *cache = nullptr;
+};
+
+} // namespace jvl::thunder
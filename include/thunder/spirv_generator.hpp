@@ -0,0 +1,325 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../common/logging.hpp"
+
+#include "buffer.hpp"
+#include "linkage_unit.hpp"
+
+namespace jvl::thunder::detail {
+
+// Subset of the SPIR-V specification used by the direct backend
+namespace spv {
+
+static constexpr uint32_t magic = 0x07230203;
+static constexpr uint32_t version = 0x00010600;
+
+enum Op : uint16_t {
+	OpName = 5,
+	OpExtInstImport = 11,
+	OpExtInst = 12,
+	OpMemoryModel = 14,
+	OpEntryPoint = 15,
+	OpExecutionMode = 16,
+	OpCapability = 17,
+	OpTypeVoid = 19,
+	OpTypeBool = 20,
+	OpTypeInt = 21,
+	OpTypeFloat = 22,
+	OpTypeVector = 23,
+	OpTypeMatrix = 24,
+	OpTypeArray = 28,
+	OpTypeRuntimeArray = 29,
+	OpTypeStruct = 30,
+	OpTypePointer = 32,
+	OpTypeFunction = 33,
+	OpConstantTrue = 41,
+	OpConstantFalse = 42,
+	OpConstant = 43,
+	OpConstantNull = 46,
+	OpFunction = 54,
+	OpFunctionParameter = 55,
+	OpFunctionEnd = 56,
+	OpFunctionCall = 57,
+	OpVariable = 59,
+	OpLoad = 61,
+	OpStore = 62,
+	OpAccessChain = 65,
+	OpDecorate = 71,
+	OpMemberDecorate = 72,
+	OpVectorExtractDynamic = 77,
+	OpVectorShuffle = 79,
+	OpCompositeConstruct = 80,
+	OpCompositeExtract = 81,
+	OpConvertFToU = 109,
+	OpConvertFToS = 110,
+	OpConvertSToF = 111,
+	OpConvertUToF = 112,
+	OpUConvert = 113,
+	OpSConvert = 114,
+	OpBitcast = 124,
+	OpSNegate = 126,
+	OpFNegate = 127,
+	OpIAdd = 128,
+	OpFAdd = 129,
+	OpISub = 130,
+	OpFSub = 131,
+	OpIMul = 132,
+	OpFMul = 133,
+	OpUDiv = 134,
+	OpSDiv = 135,
+	OpFDiv = 136,
+	OpUMod = 137,
+	OpSMod = 139,
+	OpFMod = 141,
+	OpVectorTimesScalar = 142,
+	OpMatrixTimesScalar = 143,
+	OpVectorTimesMatrix = 144,
+	OpMatrixTimesVector = 145,
+	OpMatrixTimesMatrix = 146,
+	OpDot = 148,
+	OpLogicalEqual = 164,
+	OpLogicalNotEqual = 165,
+	OpLogicalOr = 166,
+	OpLogicalAnd = 167,
+	OpLogicalNot = 168,
+	OpSelect = 169,
+	OpIEqual = 170,
+	OpINotEqual = 171,
+	OpUGreaterThan = 172,
+	OpSGreaterThan = 173,
+	OpUGreaterThanEqual = 174,
+	OpSGreaterThanEqual = 175,
+	OpULessThan = 176,
+	OpSLessThan = 177,
+	OpULessThanEqual = 178,
+	OpSLessThanEqual = 179,
+	OpFOrdEqual = 180,
+	OpFUnordNotEqual = 183,
+	OpFOrdLessThan = 184,
+	OpFOrdGreaterThan = 186,
+	OpFOrdLessThanEqual = 188,
+	OpFOrdGreaterThanEqual = 190,
+	OpShiftRightLogical = 194,
+	OpShiftRightArithmetic = 195,
+	OpShiftLeftLogical = 196,
+	OpBitwiseOr = 197,
+	OpBitwiseXor = 198,
+	OpBitwiseAnd = 199,
+	OpDPdx = 207,
+	OpDPdy = 208,
+	OpDPdxFine = 210,
+	OpDPdyFine = 211,
+	OpControlBarrier = 224,
+	OpLoopMerge = 246,
+	OpSelectionMerge = 247,
+	OpLabel = 248,
+	OpBranch = 249,
+	OpBranchConditional = 250,
+	OpKill = 252,
+	OpReturn = 253,
+	OpReturnValue = 254,
+	OpUnreachable = 255,
+	OpCopyLogical = 400,
+};
+
+enum StorageClass : uint32_t {
+	Input = 1,
+	Uniform = 2,
+	Output = 3,
+	Workgroup = 4,
+	Function = 7,
+	PushConstant = 9,
+	StorageBuffer = 12,
+};
+
+enum Decoration : uint32_t {
+	Block = 2,
+	ColMajor = 5,
+	ArrayStride = 6,
+	MatrixStride = 7,
+	BuiltIn = 11,
+	NoPerspective = 13,
+	Flat = 14,
+	NonWritable = 24,
+	NonReadable = 25,
+	Location = 30,
+	Binding = 33,
+	DescriptorSet = 34,
+	Offset = 35,
+};
+
+enum Capability : uint32_t {
+	Matrix = 0,
+	Shader = 1,
+	Int64 = 11,
+	DerivativeControl = 51,
+	GroupNonUniform = 61,
+};
+
+} // namespace spv
+
+std::string spirv_disassemble(const std::vector <uint32_t> &);
+
+// Memory layouts of aggregates; externally visible storage
+// requires explicit offsets and strides on its types
+enum spirv_layout : uint32_t {
+	plain,
+	std430,
+	std140,
+};
+
+// Pointer to a SPIR-V variable or an access chain into one
+struct spirv_pointer {
+	uint32_t id = 0;
+	uint32_t storage = spv::Function;
+	spirv_layout layout = plain;
+};
+
+// Module level state, shared by the functions in a linkage unit;
+// sections are kept apart so that each can be appended to freely
+struct spirv_module_t {
+	const LinkageUnit &unit;
+
+	uint32_t bound = 1;
+	uint32_t glsl_std_450 = 0;
+
+	std::set <uint32_t> capabilities;
+	std::vector <uint32_t> entries;
+	std::vector <uint32_t> names;
+	std::vector <uint32_t> annotations;
+	std::vector <uint32_t> globals;
+	std::vector <uint32_t> code;
+
+	// Types and constants are interned by their operands
+	std::map <std::vector <uint32_t>, uint32_t> interned;
+
+	// Global variables, keyed by qualifier kind and binding
+	std::map <std::pair <QualifierKind, Index>, spirv_pointer> variables;
+	std::vector <uint32_t> interface;
+	bool depth_replacing = false;
+
+	// Result ids of the functions in the unit
+	std::vector <uint32_t> functions;
+
+	spirv_module_t(const LinkageUnit &);
+
+	uint32_t id();
+
+	static std::vector <uint32_t> literal(const std::string &);
+	static void emit(std::vector <uint32_t> &, spv::Op, const std::vector <uint32_t> &);
+
+	uint32_t intern(spv::Op, const std::vector <uint32_t> &, uint32_t = 0);
+
+	// Types
+	uint32_t type_void();
+	uint32_t type_bool();
+	uint32_t type_primitive(PrimitiveType);
+	uint32_t type_pointer(uint32_t, uint32_t);
+
+	// Constants
+	uint32_t constant(const Primitive &);
+	uint32_t constant_i32(int32_t);
+	uint32_t constant_u32(uint32_t);
+	uint32_t constant_null(uint32_t);
+
+	// Final binary with the header
+	std::vector <uint32_t> assemble() const;
+};
+
+struct spirv_function_generator_t : BufferView {
+	spirv_module_t &module;
+	const Function &function;
+
+	// Sections of the function body
+	std::vector <uint32_t> variables;
+	std::vector <uint32_t> body;
+
+	// Values of materialized atoms
+	std::map <Index, uint32_t> values;
+
+	// Values of inlined atoms, valid until the next block or store
+	std::map <Index, uint32_t> cache;
+
+	// Locals which are written to, and parameter ids
+	std::map <Index, spirv_pointer> locals;
+	std::vector <uint32_t> parameters;
+	std::set <Index> lvalues;
+
+	// Open structured constructs
+	struct construct {
+		BranchKind kind;
+		uint32_t merge;
+		uint32_t next;
+		uint32_t header;
+		uint32_t continuing;
+		bool chained;
+	};
+
+	std::vector <construct> constructs;
+	bool terminated;
+
+	spirv_function_generator_t(spirv_module_t &, size_t);
+
+	// Types and layouts
+	struct layout_info {
+		uint32_t size;
+		uint32_t align;
+	};
+
+	QualifiedType resolve(QualifiedType) const;
+	std::vector <QualifiedType> fields(QualifiedType) const;
+	PrimitiveType primitive(Index) const;
+
+	layout_info layout(const QualifiedType &, spirv_layout) const;
+	uint32_t type(const QualifiedType &, spirv_layout = plain);
+	uint32_t structure(const std::vector <QualifiedType> &, spirv_layout, uint32_t = 0, bool = false);
+
+	// Instructions
+	void emit(spv::Op, const std::vector <uint32_t> &);
+	uint32_t emit_value(spv::Op, uint32_t, const std::vector <uint32_t> &);
+	uint32_t local(uint32_t);
+	void label(uint32_t);
+	void jump(uint32_t);
+
+	uint32_t splat(uint32_t, PrimitiveType, PrimitiveType);
+	uint32_t convert(uint32_t, PrimitiveType, PrimitiveType);
+
+	// Values and pointers
+	spirv_pointer global_variable(Index);
+	std::optional <spirv_pointer> address(Index);
+	spirv_pointer chain(const spirv_pointer &, uint32_t, Index);
+
+	uint32_t load(const spirv_pointer &, Index);
+	void store(const spirv_pointer &, Index, uint32_t);
+
+	uint32_t value(Index);
+	uint32_t compute(Index);
+	void define(Index);
+
+	// Per-atom generator
+	void generate(Index);
+
+	template <typename T>
+	void generate(const T &atom, Index i) {
+		MODULE(spirv-generate);
+
+		JVL_ABORT("failed to generate SPIR-V for atom: {} (@{})", atom, i);
+	}
+
+	uint32_t generate_operation(const Operation &, Index);
+	uint32_t generate_intrinsic(const Intrinsic &, Index);
+	uint32_t generate_construct(const Construct &, Index);
+	uint32_t generate_call(const Call &, Index);
+
+	void branch(const Branch &);
+
+	// Wholistic generation
+	void generate();
+};
+
+} // namespace jvl::thunder::detail
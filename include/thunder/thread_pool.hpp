@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace jvl::thunder {
+
+// Work-stealing thread pool; each worker owns a queue and steals
+// from the others when it runs dry
+class ThreadPool {
+public:
+	using task_t = std::function <void ()>;
+private:
+	struct worker_queue_t {
+		std::mutex mutex;
+		std::deque <task_t> tasks;
+	};
+
+	std::vector <std::unique_ptr <worker_queue_t>> queues;
+	std::vector <std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable available;
+	std::atomic <size_t> pending = 0;
+	std::atomic <size_t> next = 0;
+	bool stopping = false;
+
+	std::optional <task_t> pop(size_t);
+	void run(size_t);
+public:
+	ThreadPool(size_t = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	size_t size() const;
+
+	void push(task_t);
+
+	// Pool with a worker per hardware thread, created on first use
+	static ThreadPool &shared();
+};
+
+} // namespace jvl::thunder
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <future>
+#include <mutex>
+
+#include "interpreter.hpp"
+#include "linkage_unit.hpp"
+
+namespace jvl::thunder {
+
+struct TieredOptions {
+	// Invocations served by the interpreter before compiling,
+	// where zero compiles right away
+	size_t threshold = 1024;
+
+	JitOptions jit = {};
+};
+
+enum class Tier {
+	interpreted,
+	compiling,
+	native,
+};
+
+// Linked procedure which starts out in the interpreter, and is compiled
+// with gcc-jit in the background once it has been called often enough;
+// the native function replaces the interpreter as soon as it is ready
+class CompiledProcedure {
+	LinkageUnit unit;
+	Interpreter interpreter;
+	TieredOptions options;
+
+	// Units which gcc-jit cannot lower stay in the interpreter
+	bool compilable;
+
+	std::atomic <size_t> counter = 0;
+	std::atomic <void *> native = nullptr;
+	std::atomic <bool> started = false;
+
+	std::mutex mutex;
+	std::shared_future <void> compilation;
+
+	void promote();
+public:
+	CompiledProcedure(const LinkageUnit &, const TieredOptions & = {});
+	~CompiledProcedure();
+
+	CompiledProcedure(const CompiledProcedure &) = delete;
+	CompiledProcedure &operator=(const CompiledProcedure &) = delete;
+
+	Tier tier() const;
+
+	// Invocations so far, including those served natively
+	size_t invocations() const;
+
+	// Native function, or null while it is not available
+	void *function() const;
+
+	// Blocks until the native function is available, compiling
+	// right away if the threshold has not been reached yet; returns
+	// immediately for procedures which cannot be compiled
+	void wait();
+
+	template <typename R = void, typename ... Args>
+	R call(const Args &... args) {
+		if (void *ftn = native.load(std::memory_order_acquire)) {
+			counter.fetch_add(1, std::memory_order_relaxed);
+			return ((R (*)(Args...)) ftn)(args...);
+		}
+
+		if (counter.fetch_add(1, std::memory_order_relaxed) + 1 == options.threshold)
+			promote();
+
+		return interpreter.call <R> (args...);
+	}
+
+	template <typename R = void, typename ... Args>
+	R operator()(const Args &... args) {
+		return call <R> (args...);
+	}
+};
+
+} // namespace jvl::thunder
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
 #include <map>
+#include <memory>
+#include <shared_mutex>
 
 #include "buffer.hpp"
 
@@ -11,35 +14,60 @@ struct NamedBuffer : Buffer {
 	std::string name;
 };
 
+// Immutable contents of a traced callable, shared by its
+// copies, the global cache and the linkage units using it
+using Snapshot = std::shared_ptr <const NamedBuffer>;
+
 // Buffer with name and unique index
-struct TrackedBuffer : NamedBuffer {
+struct TrackedBuffer {
 	// Global list of callables
 	struct cache_entry_t {
 		int32_t count;
-		NamedBuffer buffer;
-		const NamedBuffer *link;
+		Snapshot buffer;
+	};
+
+	// Sharded by cid so that threads tracing different
+	// callables rarely contend for the same lock
+	struct cache_shard_t {
+		std::shared_mutex mutex;
+		std::map <int32_t, cache_entry_t> entries;
 	};
 
-	using cache_t = std::map <int32_t, cache_entry_t>;
+	static constexpr size_t cache_shards = 16;
+
+	using cache_t = std::array <cache_shard_t, cache_shards>;
 
 	static cache_t &cache();
-	static const NamedBuffer &cache_load(int32_t);
+	static cache_shard_t &cache_shard(int32_t);
+	static Snapshot cache_load(int32_t);
 	static void cache_increment(int32_t);
 	static void cache_decrement(int32_t);
-	static void cache_unlink(int32_t);
 	static void cache_insert(const TrackedBuffer *);
 	static void cache_display();
 
 	// Unique id
 	int32_t cid;
 
+	// Current contents, possibly shared with other owners
+	Snapshot snapshot;
+
 	TrackedBuffer();
 	TrackedBuffer(const TrackedBuffer &);
 	TrackedBuffer &operator=(const TrackedBuffer &);
 	~TrackedBuffer();
 
+	const NamedBuffer &operator*() const;
+	const NamedBuffer *operator->() const;
+
+	operator const NamedBuffer &() const;
+
+	// Mutable contents, copied first if they are shared; changes
+	// are only seen by the cache (and callers) once published
+	NamedBuffer &edit();
+	void publish() const;
+
 	void display_assembly() const;
 	void display_pretty() const;
 };
 
-} // namespace jvl::thunder
\ No newline at end of file
+} // namespace jvl::thunder
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include "qualified_type.hpp"
+#include "value_table.hpp"
+
+namespace jvl::thunder {
+
+// Compact handle to an interned type, only meaningful within its table
+using TypeId = std::make_unsigned_t <Index>;
+
+// Types of the atoms in a buffer; each distinct type is stored once and
+// atoms refer to it by id, so equal ids imply equal types and vice versa
+class TypeTable {
+	// Distinct types, indexed by their ids
+	std::vector <QualifiedType> entries;
+	std::vector <TypeId> ids;
+
+	// From canonical keys (see TypeTable::key) to interned ids
+	ValueTable lookup;
+public:
+	// Always interned first, so that unassigned atoms are nil
+	static constexpr TypeId nil = 0;
+
+	TypeTable(size_t = 0);
+
+	// Per-atom types
+	const QualifiedType &operator[](size_t) const;
+
+	TypeId id(size_t) const;
+
+	void assign(size_t, const QualifiedType &);
+	void resize(size_t);
+	size_t size() const;
+
+	// Interned types
+	TypeId intern(const QualifiedType &);
+
+	// Non-nil types have non-zero keys, which are distinct for
+	// distinct types unless indices are wide
+	static uint64_t key(const QualifiedType &);
+
+	const QualifiedType &type(TypeId) const;
+	const std::vector <QualifiedType> &interned() const;
+};
+
+} // namespace jvl::thunder
@@ -9,6 +9,29 @@ namespace jvl::thunder {
 using UsageSet = std::set <Index>;
 using UsageGraph = std::vector <UsageSet>;
 
+// Flat def-use graph, users of each atom are stored contiguously
+// (in increasing order) in a compressed sparse row layout
+struct UsageTable {
+	std::vector <uint32_t> offsets;
+	std::vector <Index> users;
+
+	size_t size() const {
+		return offsets.size() - 1;
+	}
+
+	uint32_t count(Index i) const {
+		return offsets[i + 1] - offsets[i];
+	}
+
+	const Index *begin(Index i) const {
+		return users.data() + offsets[i];
+	}
+
+	const Index *end(Index i) const {
+		return users.data() + offsets[i + 1];
+	}
+};
+
 // Structure for recording instruction transformations
 struct ref_index_t {
 	Index index;
@@ -27,5 +50,6 @@ struct mapped_instruction_t : Buffer {
 UsageSet usage(const std::vector <Atom> &, Index);
 UsageSet usage(const Buffer &, Index);
 UsageGraph usage(const Buffer &);
+UsageTable usage_table(const Buffer &);
 
 } // namespace jvl::thunder
\ No newline at end of file
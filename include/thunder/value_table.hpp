@@ -0,0 +1,78 @@
+#pragma once
+
+#include <bit>
+#include <vector>
+
+#include "atom.hpp"
+
+namespace jvl::thunder {
+
+// Flat open-addressing table from canonical keys (see Atom::hash and
+// TypeTable::key) to indices, keys are never zero so empty slots are zeroed
+struct ValueTable {
+	std::vector <uint64_t> keys;
+	std::vector <Index> values;
+	size_t count = 0;
+
+	ValueTable(size_t size = 0) {
+		size_t capacity = std::bit_ceil(2 * size + 2);
+		keys.resize(capacity, 0);
+		values.resize(capacity, -1);
+	}
+
+	// Slot of the key, or the empty slot where it would be inserted
+	size_t find(uint64_t key) const {
+		uint64_t h = key;
+		h ^= h >> 31;
+		h *= 0x7fb5d329728ea185ull;
+		h ^= h >> 27;
+
+		size_t mask = keys.size() - 1;
+		size_t slot = h & mask;
+		while (keys[slot] && keys[slot] != key)
+			slot = (slot + 1) & mask;
+
+		return slot;
+	}
+
+	Index lookup(uint64_t key) const {
+		size_t slot = find(key);
+		return (keys[slot] == key) ? values[slot] : -1;
+	}
+
+	// Inserts or replaces the value for the key
+	void insert(uint64_t key, Index value) {
+		size_t slot = find(key);
+		if (keys[slot] == key) {
+			values[slot] = value;
+			return;
+		}
+
+		if (2 * (count + 1) > keys.size()) {
+			rehash(keys.size() << 1);
+			slot = find(key);
+		}
+
+		keys[slot] = key;
+		values[slot] = value;
+		count++;
+	}
+
+	void rehash(size_t capacity) {
+		auto old_keys = std::move(keys);
+		auto old_values = std::move(values);
+
+		keys.assign(capacity, 0);
+		values.assign(capacity, -1);
+
+		for (size_t i = 0; i < old_keys.size(); i++) {
+			if (old_keys[i]) {
+				size_t slot = find(old_keys[i]);
+				keys[slot] = old_keys[i];
+				values[slot] = old_values[i];
+			}
+		}
+	}
+};
+
+} // namespace jvl::thunder
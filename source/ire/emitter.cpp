@@ -26,6 +26,12 @@ void Emitter::push(thunder::Buffer &scratch, bool enable_classify)
 {
 	scopes.push(std::ref(scratch));
 	classify.push(enable_classify);
+
+	// Only interning for classified scopes, others are transformation passes
+	if (interning && enable_classify)
+		interned.push(thunder::ValueTable());
+	else
+		interned.push(std::nullopt);
 	// JVL_INFO("pushed new scratch buffer to global emitter ({} scopes)", scopes.size());
 }
 
@@ -33,16 +39,63 @@ void Emitter::pop()
 {
 	scopes.pop();
 	classify.pop();
+	interned.pop();
 	// JVL_INFO("popped scratch buffer from global emitter ({} scopes)", scopes.size());
 }
 
+// Atoms which can never be the destination of a store
+bool immutable(const thunder::Atom &atom)
+{
+	if (auto type = atom.get <thunder::TypeInformation> ())
+		return (type->down == -1) && (type->next == -1);
+
+	return atom.is <thunder::List> ();
+}
+
 // Emitting instructions during function invocation
 Emitter::Index Emitter::emit(const thunder::Atom &atom)
 {
 	JVL_ASSERT(scopes.size(), "in emit: no active scope");
+
+	auto &table = interned.top();
+	if (table) {
+		if (immutable(atom))
+			return intern(atom);
+
+		if (auto store = atom.get <thunder::Store> ()) {
+			auto &buffer = scopes.top().get();
+			Index root = buffer.reference_of(store->dst);
+			JVL_ASSERT(table->lookup(buffer[root].hash()) != root,
+				"store into interned atom %{}", root);
+		}
+	}
+
 	return scopes.top().get().emit(atom, classify.top());
 }
 
+Emitter::Index Emitter::intern(const thunder::Atom &atom)
+{
+	JVL_ASSERT(scopes.size(), "in intern: no active scope");
+
+	auto &table = interned.top();
+	if (!table)
+		return scopes.top().get().emit(atom, classify.top());
+
+	uint64_t key = atom.hash();
+
+	// Keys of wide atoms can collide, so matches are compared as well
+	auto &buffer = scopes.top().get();
+
+	Index existing = table->lookup(key);
+	if (existing != -1 && buffer.atoms[existing] == atom)
+		return existing;
+
+	Index i = buffer.emit(atom, classify.top());
+	table->insert(key, i);
+
+	return i;
+}
+
 // Qualifiers
 Emitter::Index Emitter::emit_qualifier(Index underlying, Index numerical, thunder::QualifierKind kind)
 {
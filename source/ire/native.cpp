@@ -6,7 +6,7 @@ namespace jvl::ire {
 // Translating native C++ primitives //
 ///////////////////////////////////////
 
-thunder::Index translate_primitive(bool b)
+thunder::Index translate_primitive(bool b, bool shared)
 {
 	auto &em = Emitter::active;
 
@@ -14,10 +14,10 @@ thunder::Index translate_primitive(bool b)
 	p.type = thunder::boolean;
 	p.bdata = b;
 
-	return em.emit(p);
+	return shared ? em.intern(p) : em.emit(p);
 }
 
-thunder::Index translate_primitive(int32_t i)
+thunder::Index translate_primitive(int32_t i, bool shared)
 {
 	auto &em = Emitter::active;
 
@@ -25,10 +25,10 @@ thunder::Index translate_primitive(int32_t i)
 	p.type = thunder::i32;
 	p.idata = i;
 
-	return em.emit(p);
+	return shared ? em.intern(p) : em.emit(p);
 }
 
-thunder::Index translate_primitive(uint32_t i)
+thunder::Index translate_primitive(uint32_t i, bool shared)
 {
 	auto &em = Emitter::active;
 
@@ -36,29 +36,31 @@ thunder::Index translate_primitive(uint32_t i)
 	p.type = thunder::u32;
 	p.udata = i;
 
-	return em.emit(p);
+	return shared ? em.intern(p) : em.emit(p);
 }
 
-thunder::Index translate_primitive(uint64_t i)
+thunder::Index translate_primitive(uint64_t i, bool shared)
 {
 	auto &em = Emitter::active;
 
-	auto high = translate_primitive(uint32_t(i >> 32));
+	// Only the final result may be used as a mutable value
+	auto high = translate_primitive(uint32_t(i >> 32), true);
 	auto hlist = em.emit_list(high);
-	auto h64 = em.emit_intrinsic(hlist, thunder::IntrinsicOperation::cast_to_uint64);
+	auto h64 = em.intern(thunder::Intrinsic(hlist, thunder::IntrinsicOperation::cast_to_uint64));
 
-	auto low = translate_primitive(uint32_t(i & 0xFFFFFFFF));
+	auto low = translate_primitive(uint32_t(i & 0xFFFFFFFF), true);
 	auto llist = em.emit_list(low);
-	auto l64 = em.emit_intrinsic(llist, thunder::IntrinsicOperation::cast_to_uint64);
+	auto l64 = em.intern(thunder::Intrinsic(llist, thunder::IntrinsicOperation::cast_to_uint64));
 
-	auto shamt = translate_primitive(32u);
-	auto shifted = em.emit_operation(h64, shamt, thunder::OperationCode::bit_shift_left);
-	auto combined = em.emit_operation(shifted, l64, thunder::OperationCode::bit_or);
+	auto shamt = translate_primitive(32u, true);
+	auto shifted = em.intern(thunder::Operation(h64, shamt, thunder::OperationCode::bit_shift_left));
 
-	return combined;
+	thunder::Operation combined(shifted, l64, thunder::OperationCode::bit_or);
+
+	return shared ? em.intern(combined) : em.emit(combined);
 }
 
-thunder::Index translate_primitive(float f)
+thunder::Index translate_primitive(float f, bool shared)
 {
 	auto &em = Emitter::active;
 
@@ -66,7 +68,7 @@ thunder::Index translate_primitive(float f)
 	p.type = thunder::f32;
 	p.fdata = f;
 
-	return em.emit(p);
+	return shared ? em.intern(p) : em.emit(p);
 }
 
 } // namespace jvl::ire
\ No newline at end of file
@@ -190,7 +190,7 @@ std::string Primitive::value_string() const
 		return fmt::format("{}", udata);
 	case u64:
 		// Full data unavailable...
-		return fmt::format("{}", udata);
+		return fmt::format("{}ul", udata);
 	case f32:
 		return fmt::format("{}", fdata);
 	default:
@@ -361,10 +361,10 @@ Addresses Call::addresses()
 
 std::string Call::to_assembly_string() const
 {
-        auto &buffer = TrackedBuffer::cache_load(cid);
+        auto buffer = TrackedBuffer::cache_load(cid);
 
         return fmt::format("call ${} {} {}",
-                buffer.name,
+                buffer->name,
                 fmtaddr(args),
                 fmtaddr(type));
 }
@@ -373,10 +373,10 @@ std::string Call::to_pretty_string() const
 {
         std::string result;
 
-        auto &buffer = TrackedBuffer::cache_load(cid);
+        auto buffer = TrackedBuffer::cache_load(cid);
        
         result += header("CALL", fmt::color::dark_magenta);
-        result += fmt::format("\n          :: callable: ${}", buffer.name);
+        result += fmt::format("\n          :: callable: ${}", buffer->name);
         if (args != -1)
                 result += fmt::format("\n          :: args: %{}", args);
 
@@ -566,6 +566,70 @@ void Atom::reindex(const thunder::reindex <Index> &reindexer)
         if (addrs.a1 != -1) reindexer(addrs.a1);
 }
 
+#ifdef JVL_WIDE_INDEX
+
+// Three wide fields do not fit below the tag, so they are mixed instead
+static uint64_t pack(uint32_t a, uint32_t b = 0, uint32_t c = 0)
+{
+	uint64_t h = uint64_t(a) | (uint64_t(b) << 32);
+	h ^= (uint64_t(c) + 1) * 0x9e3779b97f4a7c15ull;
+	h ^= h >> 29;
+	return h & ((uint64_t(1) << 56) - 1);
+}
+
+#else
+
+static uint64_t pack(uint16_t a, uint16_t b = 0, uint16_t c = 0)
+{
+	return uint64_t(a) | (uint64_t(b) << 16) | (uint64_t(c) << 32);
+}
+
+#endif
+
+uint64_t Atom::hash() const
+{
+	auto ftn = [](const auto &x) -> uint64_t {
+		using T = std::decay_t <decltype(x)>;
+
+		if constexpr (std::same_as <T, Qualifier>)
+			return pack(x.underlying, x.numerical, x.kind);
+		else if constexpr (std::same_as <T, TypeInformation>)
+			return pack(x.down, x.next, x.item);
+		else if constexpr (std::same_as <T, Primitive>) {
+			uint32_t data = (x.type == boolean) ? uint32_t(x.bdata) : x.udata;
+			return uint64_t(uint16_t(x.type)) | (uint64_t(data) << 16);
+		} else if constexpr (std::same_as <T, Swizzle>)
+			return pack(x.src, x.code);
+		else if constexpr (std::same_as <T, Operation>)
+			return pack(x.a, x.b, x.code);
+		else if constexpr (std::same_as <T, Intrinsic>)
+			return pack(x.args, x.opn);
+		else if constexpr (std::same_as <T, List>)
+			return pack(x.item, x.next);
+		else if constexpr (std::same_as <T, Construct>)
+			return pack(x.type, x.args, x.mode);
+		else if constexpr (std::same_as <T, Call>)
+			return pack(x.cid, x.args, x.type);
+		else if constexpr (std::same_as <T, Storage>)
+			return pack(x.type);
+		else if constexpr (std::same_as <T, Store>)
+			return pack(x.dst, x.src);
+		else if constexpr (std::same_as <T, Load>)
+			return pack(x.src, x.idx);
+		else if constexpr (std::same_as <T, ArrayAccess>)
+			return pack(x.src, x.loc);
+		else if constexpr (std::same_as <T, Branch>)
+			return pack(x.cond, x.failto, x.kind);
+		else if constexpr (std::same_as <T, Return>)
+			return pack(x.value);
+		else
+			static_assert(false, "atom key is not implemented for this type");
+	};
+
+	// Alternative tag in the upper bits, which also keeps keys non-zero
+	return (uint64_t(index() + 1) << 56) | std::visit(ftn, *this);
+}
+
 std::string Atom::to_assembly_string() const
 {
         auto ftn = [](const auto &x) -> std::string { return x.to_assembly_string(); };
@@ -40,11 +40,11 @@ Index synthesize_dual_type(const QualifiedType &qt)
 	return em.emit_type_information(-1, dual, primitive);
 }
 
-struct ad_fwd_iteration_context_t : Buffer {
+struct ad_fwd_iteration_context_t : BufferView {
 	std::deque <Index> queue;
 	std::set <Index> diffed;
 
-	ad_fwd_iteration_context_t(const Buffer &buffer) : Buffer(buffer) {}
+	ad_fwd_iteration_context_t(const BufferView &view) : BufferView(view) {}
 };
 
 Index ad_fwd_binary_operation_dual_value(mapped_instruction_t &mapped,
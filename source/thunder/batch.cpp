@@ -0,0 +1,125 @@
+#include "common/logging.hpp"
+
+#include "thunder/batch.hpp"
+
+namespace jvl::thunder {
+
+MODULE(batch-compiler);
+
+BatchTiming::duration_t BatchTiming::total() const
+{
+	return queued + optimization + linkage + generation;
+}
+
+BatchCompiler::BatchCompiler(size_t threads) : pool(threads) {}
+
+size_t BatchCompiler::size() const
+{
+	return pool.size();
+}
+
+std::future <BatchResult> BatchCompiler::submit(BatchItem item)
+{
+	using clock_t = std::chrono::steady_clock;
+
+	auto submitted = clock_t::now();
+
+	// Tasks are copyable functions, so the promise is shared
+	auto promise = std::make_shared <std::promise <BatchResult>> ();
+	auto shared = std::make_shared <BatchItem> (std::move(item));
+
+	auto future = promise->get_future();
+
+	pool.push([promise, shared, submitted]() {
+		BatchTiming::duration_t queued = clock_t::now() - submitted;
+
+		auto result = compile(*shared);
+		result.timing.queued = queued;
+		promise->set_value(std::move(result));
+	});
+
+	return future;
+}
+
+std::vector <std::future <BatchResult>> BatchCompiler::submit(std::vector <BatchItem> items)
+{
+	std::vector <std::future <BatchResult>> futures;
+	futures.reserve(items.size());
+
+	for (auto &item : items)
+		futures.push_back(submit(std::move(item)));
+
+	return futures;
+}
+
+BatchResult BatchCompiler::compile(const BatchItem &item)
+{
+	using clock_t = std::chrono::steady_clock;
+
+	JVL_ASSERT(item.procedures.size(), "batch item has no procedures to compile");
+
+	BatchResult result;
+
+	// Optimizing copies, the registered callables are left untouched
+	auto start = clock_t::now();
+
+	auto optimize = [&](const Snapshot &snapshot) -> Snapshot {
+		if (!item.optimizer)
+			return snapshot;
+
+		auto copy = std::make_shared <NamedBuffer> (*snapshot);
+		item.optimizer->apply(*copy);
+		return copy;
+	};
+
+	// Callees are optimized as well and linked in place of their
+	// registered contents, regardless of the order of the procedures
+	std::map <Index, Snapshot> snapshots;
+	for (auto &procedure : item.procedures) {
+		if (!snapshots.contains(procedure.cid))
+			snapshots[procedure.cid] = optimize(procedure.snapshot);
+	}
+
+	std::vector <Snapshot> pending;
+	for (auto &[cid, snapshot] : snapshots)
+		pending.push_back(snapshot);
+
+	while (pending.size()) {
+		auto snapshot = pending.back();
+		pending.pop_back();
+
+		for (size_t i = 0; i < snapshot->pointer; i++) {
+			auto call = snapshot->atoms[i].get <Call> ();
+			if (!call || snapshots.contains(call->cid))
+				continue;
+
+			auto callee = optimize(TrackedBuffer::cache_load(call->cid));
+			snapshots[call->cid] = callee;
+			pending.push_back(callee);
+		}
+	}
+
+	auto optimized = clock_t::now();
+
+	LinkageUnit unit;
+	unit.substitutes = snapshots;
+	for (auto &procedure : item.procedures)
+		unit.add(procedure.cid, snapshots[procedure.cid]);
+
+	auto linked = clock_t::now();
+
+	if (item.target == Target::spirv_binary_via_glsl)
+		result.result = unit.generate_spirv_via_glsl(to_vulkan(item.stage), item.spirv);
+	else
+		result.result = unit.generate(item.target, item.stage, item.jit);
+
+	auto generated = clock_t::now();
+
+	result.timing.optimization = optimized - start;
+	result.timing.linkage = linked - optimized;
+	result.timing.generation = generated - linked;
+
+	return result;
+}
+
+} // namespace jvl::thunder
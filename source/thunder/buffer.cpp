@@ -1,3 +1,5 @@
+#include <limits>
+
 #include "common/logging.hpp"
 
 #include "thunder/atom.hpp"
@@ -41,6 +43,15 @@ std::string Buffer::Decorations::to_string(Index idx) const
 	return concatted;
 }
 
+Buffer::Decorations Buffer::Decorations::relocated(std::span <const Index> mapping) const
+{
+	Decorations result;
+	result.type = type.relocated(mapping);
+	result.phantom = phantom.relocated(mapping);
+	result.materialize = materialize.relocated(mapping);
+	return result;
+}
+
 // TODO: provide parameters to control startup size...
 Buffer::Buffer()
 	: pointer(0),
@@ -49,6 +60,13 @@ Buffer::Buffer()
 
 Index Buffer::emit(const Atom &atom, bool enable_classification)
 {
+	// Checked in all builds, since indices would otherwise wrap around
+	if (pointer > size_t(std::numeric_limits <Index> ::max())) {
+		JVL_ABORT("buffer exceeds the limit of {} atoms, "
+			"wide indices are available with ENABLE_WIDE_INDEX",
+			size_t(std::numeric_limits <Index> ::max()) + 1);
+	}
+
 	if (pointer >= atoms.size()) {
 		atoms.resize((atoms.size() << 1));
 		types.resize(atoms.size());
@@ -60,7 +78,7 @@ Index Buffer::emit(const Atom &atom, bool enable_classification)
 
 	atoms[pointer] = atom;
 	if (enable_classification) {
-		types[pointer] = semalz(pointer);
+		types.assign(pointer, semalz(pointer));
 		mark(pointer);
 	}
 
@@ -72,6 +90,7 @@ void Buffer::clear()
 	pointer = 0;
 	atoms.clear();
 	atoms.resize(4);
+	types = TypeTable(atoms.size());
 }
 
 // Debugging utilities
@@ -85,7 +104,18 @@ void Buffer::write(std::ofstream &file) const
 
 	file.write(reinterpret_cast <const char *> (&pointer), sizeof(size_t));
 	file.write(reinterpret_cast <const char *> (atoms.data()), pointer * sizeof(Atom));
-	file.write(reinterpret_cast <const char *> (types.data()), pointer * sizeof(QualifiedType));
+
+	// Interned types, followed by the type id of each atom
+	std::vector <QualifiedType> interned(types.interned().begin(), types.interned().end());
+	size_t interned_count = interned.size();
+	file.write(reinterpret_cast <const char *> (&interned_count), sizeof(size_t));
+	file.write(reinterpret_cast <const char *> (interned.data()), interned_count * sizeof(QualifiedType));
+
+	std::vector <TypeId> ids;
+	for (size_t i = 0; i < pointer; i++)
+		ids.push_back(types.id(i));
+
+	file.write(reinterpret_cast <const char *> (ids.data()), pointer * sizeof(TypeId));
 
 	// TODO: write decorations
 }
@@ -137,6 +167,11 @@ std::string Buffer::to_string_pretty() const
 }
 
 void Buffer::display_assembly() const
+{
+	BufferView(*this).display_assembly();
+}
+
+void BufferView::display_assembly() const
 {
 	for (size_t i = 0; i < pointer; i++) {
 		std::string s = fmt::format("%{}", i);
@@ -206,6 +241,29 @@ const Atom &Buffer::operator[](size_t i) const
 }
 
 std::vector <Index> Buffer::expand_list(Index i) const
+{
+	return BufferView(*this).expand_list(i);
+}
+
+std::vector <QualifiedType> Buffer::expand_list_types(Index i) const
+{
+	return BufferView(*this).expand_list_types(i);
+}
+
+// Views
+BufferView::BufferView(const Buffer &buffer)
+		: pointer(buffer.pointer),
+		atoms(buffer.atoms.data(), buffer.pointer),
+		types(buffer.types),
+		marked(buffer.marked),
+		decorations(buffer.decorations) {}
+
+const Atom &BufferView::operator[](size_t i) const
+{
+	return atoms[i];
+}
+
+std::vector <Index> BufferView::expand_list(Index i) const
 {
 	std::vector <Index> args;
 	while (i != -1) {
@@ -221,7 +279,7 @@ std::vector <Index> Buffer::expand_list(Index i) const
 	return args;
 }
 
-std::vector <QualifiedType> Buffer::expand_list_types(Index i) const
+std::vector <QualifiedType> BufferView::expand_list_types(Index i) const
 {
 	std::vector <QualifiedType> args;
 	while (i != -1) {
@@ -14,7 +14,7 @@ namespace jvl::thunder::detail {
 MODULE(c-like-generator);
 
 // TODO: separate file at this point...
-static std::optional <std::string> generate_global_reference(const std::vector <Atom> &atoms, const Index &idx)
+static std::optional <std::string> generate_global_reference(std::span <const Atom> atoms, const Index &idx)
 {
 	auto &qualifier = atoms[idx].as <Qualifier> ();
 
@@ -146,67 +146,307 @@ static std::optional <std::string> generate_global_reference(const std::vector <
 	return std::nullopt;
 }
 
-static std::string arguments_to_string(const std::vector <std::string> &args)
-{
-	std::string ret;
-	ret += "(";
-	for (size_t i = 0; i < args.size(); i++) {
-		ret += args[i];
-		if (i + 1 < args.size())
-			ret += ", ";
-	}
-
-	ret += ")";
-	return ret;
-}
-
-std::string generate_operation(OperationCode code, const std::string &a, const std::string &b)
+static const char *operation_symbol(OperationCode code)
 {
 	// Binary operator strings
 	static const bestd::hash_table <OperationCode, const char *> operators {
-		{ addition,		"+" },
-		{ subtraction,		"-" },
-		{ multiplication,	"*" },
-		{ division,		"/" },
+		{ addition,		" + " },
+		{ subtraction,		" - " },
+		{ multiplication,	" * " },
+		{ division,		" / " },
 
-		{ modulus,		"%" },
+		{ modulus,		" % " },
 
-		{ bit_shift_left,	"<<" },
-		{ bit_shift_right,	">>" },
+		{ bit_shift_left,	" << " },
+		{ bit_shift_right,	" >> " },
 
-		{ bool_and,		"&&" },
-		{ bool_or,		"||" },
+		{ bool_and,		" && " },
+		{ bool_or,		" || " },
 
-		{ bit_and,		"&" },
-		{ bit_or,		"|" },
-		{ bit_xor,		"^" },
+		{ bit_and,		" & " },
+		{ bit_or,		" | " },
+		{ bit_xor,		" ^ " },
 
-		{ cmp_ge,		">" },
-		{ cmp_geq,		">=" },
-		{ cmp_le,		"<" },
-		{ cmp_leq,		"<=" },
-		{ equals,		"==" },
-		{ not_equals,		"!=" },
+		{ cmp_ge,		" > " },
+		{ cmp_geq,		" >= " },
+		{ cmp_le,		" < " },
+		{ cmp_leq,		" <= " },
+		{ equals,		" == " },
+		{ not_equals,		" != " },
 	};
 
-	// Handle the special cases
-	if (code == unary_negation)
-		return fmt::format("-({})", a);
-	if (code == bool_not)
-		return fmt::format("!({})", a);
-
 	// Should be left with purely binary operations
 	JVL_ASSERT(operators.contains(code),
 		"no operator symbol found for $({})",
 		tbl_operation_code[code]);
 
-	const char *const op = operators.at(code);
-
-	return fmt::format("({} {} {})", a, op, b);
+	return operators.at(code);
 }
 
 c_like_generator_t::c_like_generator_t(const auxiliary_block_t &body)
-	: auxiliary_block_t(body), indentation(1) {}
+	: auxiliary_block_t(body),
+	local_variables(body.pointer),
+	locals(0),
+	indentation(1),
+	bound(body.pointer, false) {}
+
+// Calls the function for each operand which is written out
+// when the atom is generated, either in place or inlined
+template <typename F>
+static void for_each_operand(const Atom &atom, const F &ftn)
+{
+	auto optional = [&](Index i) {
+		if (i >= 0)
+			ftn(i);
+	};
+
+	switch (atom.index()) {
+
+	variant_case(Atom, Operation):
+	{
+		auto &operation = atom.as <Operation> ();
+		ftn(operation.a);
+		optional(operation.b);
+	} break;
+
+	variant_case(Atom, Intrinsic):
+		return optional(atom.as <Intrinsic> ().args);
+
+	variant_case(Atom, Construct):
+	{
+		auto &constructor = atom.as <Construct> ();
+		if (constructor.mode == global)
+			return ftn(constructor.type);
+
+		optional(constructor.args);
+	} break;
+
+	variant_case(Atom, Call):
+		return optional(atom.as <Call> ().args);
+
+	variant_case(Atom, List):
+	{
+		auto &list = atom.as <List> ();
+		ftn(list.item);
+		optional(list.next);
+	} break;
+
+	variant_case(Atom, Swizzle):
+		return ftn(atom.as <Swizzle> ().src);
+
+	variant_case(Atom, Load):
+		return ftn(atom.as <Load> ().src);
+
+	variant_case(Atom, ArrayAccess):
+	{
+		auto &access = atom.as <ArrayAccess> ();
+		ftn(access.src);
+		ftn(access.loc);
+	} break;
+
+	variant_case(Atom, Store):
+	{
+		auto &store = atom.as <Store> ();
+		ftn(store.dst);
+		ftn(store.src);
+	} break;
+
+	variant_case(Atom, Branch):
+		return optional(atom.as <Branch> ().cond);
+
+	variant_case(Atom, Return):
+		return optional(atom.as <Return> ().value);
+
+	default:
+		break;
+	}
+}
+
+void c_like_generator_t::bind()
+{
+	static constexpr Index none = -2;
+
+	// Scopes are identified by the branch opening them, and -1 is the
+	// body of the function; conditions belong to the enclosing scope
+	std::vector <Index> scope(pointer, -1);
+	std::vector <Index> parent(pointer, -1);
+	std::vector <uint32_t> depth(pointer, 0);
+
+	auto level = [&](Index s) -> uint32_t {
+		return (s == -1) ? 0 : depth[s];
+	};
+
+	auto encloses = [&](Index a, Index b) {
+		while (level(b) > level(a))
+			b = parent[b];
+
+		return a == b;
+	};
+
+	auto common = [&](Index a, Index b) {
+		while (a != b) {
+			if (level(a) >= level(b))
+				a = parent[a];
+			else
+				b = parent[b];
+		}
+
+		return a;
+	};
+
+	// Roots of everything that may be written to
+	std::vector <bool> written(pointer, false);
+
+	auto write_arguments = [&](Index l) {
+		for (; l != -1; l = atoms[l].as <List> ().next)
+			written[reference_of(atoms[l].as <List> ().item)] = true;
+	};
+
+	Index current = -1;
+	for (size_t i = 0; i < pointer; i++) {
+		auto &atom = atoms[i];
+
+		scope[i] = current;
+
+		if (auto branch = atom.get <Branch> ()) {
+			switch (branch->kind) {
+			case conditional_else_if:
+			case conditional_else:
+				if (current != -1)
+					current = parent[current];
+				scope[i] = current;
+				[[fallthrough]];
+			case conditional_if:
+			case loop_while:
+			case loop_for:
+				parent[i] = current;
+				depth[i] = level(current) + 1;
+				current = i;
+				break;
+			case control_flow_end:
+				if (current != -1)
+					current = parent[current];
+				break;
+			default:
+				break;
+			}
+		} else if (auto store = atom.get <Store> ()) {
+			written[reference_of(store->dst)] = true;
+		} else if (auto call = atom.get <Call> ()) {
+			write_arguments(call->args);
+		} else if (auto intrinsic = atom.get <Intrinsic> ()) {
+			if (side_effects(intrinsic->opn))
+				write_arguments(intrinsic->args);
+		}
+	}
+
+	// Values which are the same wherever they are evaluated, built only
+	// from atoms appearing before them; anything else stays inlined.
+	// Literals are cheap to repeat, so they are always inlined as well
+	std::vector <bool> stable(pointer, false);
+	std::vector <bool> literal(pointer, false);
+	std::vector <bool> forward(pointer, false);
+
+	for (size_t i = 0; i < pointer; i++) {
+		auto &atom = atoms[i];
+
+		bool operands = true;
+		bool literals = true;
+		for_each_operand(atom, [&](Index j) {
+			forward[j] = forward[j] || (j >= Index(i));
+			operands = operands && (j < Index(i)) && stable[j];
+			literals = literals && (j < Index(i)) && literal[j];
+		});
+
+		literal[i] = atom.is <Primitive> ()
+			|| (literals && (atom.is <Operation> ()
+				|| atom.is <Intrinsic> ()
+				|| atom.is <Construct> ()
+				|| atom.is <List> ()));
+
+		bool value = false;
+
+		switch (atom.index()) {
+
+		variant_case(Atom, Primitive):
+		variant_case(Atom, TypeInformation):
+			value = true;
+			break;
+
+		variant_case(Atom, Qualifier):
+		{
+			auto &qualifier = atom.as <Qualifier> ();
+			value = invariant_kind(qualifier.kind);
+		} break;
+
+		// Calls are always materialized, so their results are fixed
+		variant_case(Atom, Call):
+			value = true;
+			break;
+
+		variant_case(Atom, Intrinsic):
+			value = operands && !side_effects(atom.as <Intrinsic> ().opn);
+			break;
+
+		variant_case(Atom, Construct):
+		{
+			auto &constructor = atom.as <Construct> ();
+			if (constructor.mode == global)
+				value = operands;
+			else
+				value = operands && (constructor.args != -1);
+		} break;
+
+		variant_case(Atom, Operation):
+		variant_case(Atom, List):
+		variant_case(Atom, Swizzle):
+		variant_case(Atom, Load):
+		variant_case(Atom, ArrayAccess):
+			value = operands;
+			break;
+
+		default:
+			break;
+		}
+
+		stable[i] = value && !written[i];
+	}
+
+	// Walking backwards, every use of an atom has been seen by the time
+	// it is reached; expansions counts how many times it would be
+	// written out, and site is the innermost scope enclosing those
+	std::vector <uint32_t> expansions(pointer, 0);
+	std::vector <Index> site(pointer, none);
+
+	for (Index i = pointer - 1; i >= 0; i--) {
+		auto &atom = atoms[i];
+
+		bool generated = marked.contains(i) || decorations.materialize.contains(i);
+		if (!generated && site[i] == none)
+			continue;
+
+		bool expression = atom.is <Operation> ()
+			|| atom.is <Intrinsic> ()
+			|| atom.is <Construct> ();
+
+		if (!generated && expression
+				&& (expansions[i] > 1)
+				&& stable[i] && !literal[i] && !forward[i]
+				&& !types[i].is <NilType> ()
+				&& encloses(scope[i], site[i]))
+			bound[i] = true;
+
+		bool placed = generated || bound[i];
+
+		uint32_t count = placed ? 1 : expansions[i];
+		Index at = placed ? scope[i] : site[i];
+
+		for_each_operand(atom, [&](Index j) {
+			expansions[j] = std::min <uint64_t> (uint64_t(expansions[j]) + count, UINT32_MAX);
+			site[j] = (site[j] == none) ? at : common(site[j], at);
+		});
+	}
+}
 
 void c_like_generator_t::comment(const std::string &s)
 {
@@ -215,41 +455,79 @@ void c_like_generator_t::comment(const std::string &s)
 
 void c_like_generator_t::finish(const std::string &s, bool semicolon)
 {
-	source += std::string(indentation << 2, ' ') + s + (semicolon ? ";" : "") + "\n";
+	source.append(indentation << 2, ' ');
+	source += s;
+	source += semicolon ? ";\n" : "\n";
+}
+
+// Starts the declaration of a new local variable, returning its name
+std::string c_like_generator_t::variable(Index index)
+{
+	auto &t = atom_type_to_string(index);
+
+	std::string var = fmt::format("s{}", locals++);
+
+	source.append(indentation << 2, ' ');
+	source += t.pre;
+	source += ' ';
+	source += var;
+	source += t.post;
+
+	return var;
 }
 
 void c_like_generator_t::declare(Index index)
 {
-	auto t = type_to_string(types[index]);
-	int n = local_variables.size();
-	std::string var = fmt::format("s{}", n);
-	std::string stmt = fmt::format("{} {}{}", t.pre, var, t.post);
+	local_variables[index] = variable(index);
+	source += ";\n";
+}
+
+void c_like_generator_t::define(Index index)
+{
+	std::string var = variable(index);
+	source += " = ";
+	inlined(source, index);
+	source += ";\n";
+
 	local_variables[index] = var;
-	finish(stmt);
 }
 
 void c_like_generator_t::define(Index index, const std::string &v)
 {
-	auto t = type_to_string(types[index]);
-	int n = local_variables.size();
-	std::string var = fmt::format("s{}", n);
-	std::string stmt = fmt::format("{} {}{} = {}", t.pre, var, t.post, v);
+	std::string var = variable(index);
+	source += " = ";
+	source += v;
+	source += ";\n";
+
 	local_variables[index] = var;
-	finish(stmt);
 }
 
-void c_like_generator_t::assign(int index, const std::string &v)
+void c_like_generator_t::assign(Index dst, Index src)
+{
+	source.append(indentation << 2, ' ');
+	reference(source, dst);
+	source += " = ";
+	inlined(source, src);
+	source += ";\n";
+}
+
+void c_like_generator_t::condition(const char *keyword, Index cond)
 {
-	std::string stmt = fmt::format("{} = {}", reference(index), v);
-	finish(stmt);
+	source.append(indentation << 2, ' ');
+	source += keyword;
+	source += " (";
+	inlined(source, cond);
+	source += ") {\n";
 }
 
-std::string c_like_generator_t::reference(Index index) const
+void c_like_generator_t::reference(std::string &out, Index index) const
 {
 	JVL_ASSERT(index != -1, "invalid index passed to ref");
 
-	if (local_variables.count(index))
-		return local_variables.at(index);
+	if (!local_variables[index].empty()) {
+		out += local_variables[index];
+		return;
+	}
 
 	const Atom &atom = atoms[index];
 
@@ -258,8 +536,10 @@ std::string c_like_generator_t::reference(Index index) const
 	variant_case(Atom, Qualifier):
 	{
 		auto ref = generate_global_reference(atoms, index);
-		if (ref)
-			return ref.value();
+		if (ref) {
+			out += ref.value();
+			return;
+		}
 
 		JVL_ABORT("failed to generate global reference for qualifier:\n{}", atom);
 	} break;
@@ -268,42 +548,49 @@ std::string c_like_generator_t::reference(Index index) const
 	{
 		auto &constructor = atom.as <Construct> ();
 		if (constructor.mode == global)
-			return inlined(constructor.type);
+			return inlined(out, constructor.type);
 	} break;
 
 	variant_case(Atom, Load):
 	{
 		auto &load = atom.as <Load> ();
 
-		std::string ref = reference(load.src);
+		reference(out, load.src);
 
 		// Default pathway
 		if (load.idx == -1)
-			return ref;
-
-		std::string accessor = fmt::format(".f{}", load.idx);
+			return;
 
 		// Check for name hints for the field
 		auto it = decorations.type.find(load.src);
-		if (it == decorations.type.end())
+		if (it == decorations.type.end()) {
 			JVL_WARNING("no decoration for load (@{}) source (@{})", index, load.src);
-		else
-			accessor = "." + it->second.fields[load.idx];
+			out += fmt::format(".f{}", load.idx);
+		} else {
+			out += '.';
+			out += it->second.fields[load.idx];
+		}
 
-		return ref + accessor;
+		return;
 	}
 
 	variant_case(Atom, Swizzle):
 	{
 		auto &swizzle = atom.as <Swizzle> ();
-		std::string accessor = tbl_swizzle_code[swizzle.code];
-		return reference(swizzle.src) + "." + accessor;
+		reference(out, swizzle.src);
+		out += '.';
+		out += tbl_swizzle_code[swizzle.code];
+		return;
 	}
 
 	variant_case(Atom, ArrayAccess):
 	{
 		auto &access = atom.as <ArrayAccess> ();
-		return fmt::format("{}[{}]", inlined(access.src), inlined(access.loc));
+		inlined(out, access.src);
+		out += '[';
+		inlined(out, access.loc);
+		out += ']';
+		return;
 	}
 
 	default:
@@ -311,70 +598,81 @@ std::string c_like_generator_t::reference(Index index) const
 	}
 
 	// TODO: Could be problematic, its not an actual storage location
-	return inlined(index);
+	inlined(out, index);
 }
 
-std::string c_like_generator_t::inlined(Index index) const
+void c_like_generator_t::inlined(std::string &out, Index index) const
 {
 	JVL_ASSERT(index != -1, "invalid index passed to inlined");
 
-	if (local_variables.count(index))
-		return local_variables.at(index);
+	if (!local_variables[index].empty()) {
+		out += local_variables[index];
+		return;
+	}
 
 	const Atom &atom = atoms[index];
 
 	switch (atom.index()) {
 
 	variant_case(Atom, Primitive):
-		return atom.as <Primitive> ().value_string();
+		out += atom.as <Primitive> ().value_string();
+		return;
 
 	variant_case(Atom, Operation):
 	{
 		auto &operation = atom.as <Operation> ();
-		std::string a = inlined(operation.a);
-		std::string b = (operation.b == -1) ? "" : inlined(operation.b);
-		return generate_operation(operation.code, a, b);
+
+		// Handle the special cases
+		if (operation.code == unary_negation || operation.code == bool_not) {
+			out += (operation.code == unary_negation) ? "-(" : "!(";
+			inlined(out, operation.a);
+			out += ')';
+			return;
+		}
+
+		out += '(';
+		inlined(out, operation.a);
+		out += operation_symbol(operation.code);
+		if (operation.b != -1)
+			inlined(out, operation.b);
+		out += ')';
+		return;
 	}
 
 	variant_case(Atom, Intrinsic):
 	{
 		auto &intrinsic = atom.as <Intrinsic> ();
-		auto args = arguments(intrinsic.args);
-		return tbl_intrinsic_operation[intrinsic.opn] + arguments_to_string(args);
+		out += tbl_intrinsic_operation[intrinsic.opn];
+		arguments(out, intrinsic.args);
+		return;
 	}
 
 	variant_case(Atom, Construct):
 	{
 		auto &constructor = atom.as <Construct> ();
 		if (constructor.mode == global)
-			return inlined(constructor.type);
-
-		auto t = type_to_string(types[index]);
-		if (constructor.args != -1) {
-			auto args = arguments(constructor.args);
-			return t.pre + t.post + arguments_to_string(args);
-		}
+			return inlined(out, constructor.type);
 
-		return t.pre + t.post + "()";
+		auto &t = atom_type_to_string(index);
+		out += t.pre;
+		out += t.post;
+		arguments(out, constructor.args);
+		return;
 	}
 
 	variant_case(Atom, Call):
 	{
 		auto &call = atom.as <Call> ();
-
-		auto &buffer = TrackedBuffer::cache_load(call.cid);
-		std::string args;
-		if (call.args != -1)
-			args = arguments_to_string(arguments(call.args));
-
-		return fmt::format("{}{}", buffer.name, args);
+		out += callee(call.cid);
+		arguments(out, call.args);
+		return;
 	}
 
 	variant_case(Atom, Load):
 	variant_case(Atom, Swizzle):
 	variant_case(Atom, ArrayAccess):
 	variant_case(Atom, Qualifier):
-		return reference(index);
+		return reference(out, index);
 
 	default:
 		break;
@@ -383,28 +681,40 @@ std::string c_like_generator_t::inlined(Index index) const
 	JVL_ABORT("failed to inline atom: {} (@{})", atom, index);
 }
 
-std::vector <std::string> c_like_generator_t::arguments(Index start) const
+void c_like_generator_t::arguments(std::string &out, Index start) const
 {
-	std::vector <std::string> args;
+	out += '(';
 
 	int l = start;
 	while (l != -1) {
-		Atom h = atoms[l];
+		const Atom &h = atoms[l];
 		if (!h.is <List> ()) {
 			JVL_ABORT("unexpected atom in argument list:\n{}", h.to_pretty_string());
 		}
 
-		List list = h.as <List> ();
+		auto &list = h.as <List> ();
 		if (list.item == -1) {
 			JVL_ABORT("invalid index (-1) found in list item");
 		}
 
-		args.push_back(inlined(list.item));
+		if (l != start)
+			out += ", ";
+
+		inlined(out, list.item);
 
 		l = list.next;
 	}
 
-	return args;
+	out += ')';
+}
+
+const std::string &c_like_generator_t::callee(Index cid) const
+{
+	auto it = callees.find(cid);
+	if (it == callees.end())
+		it = callees.emplace(cid, TrackedBuffer::cache_load(cid)->name).first;
+
+	return it->second;
 }
 
 c_like_generator_t::type_string c_like_generator_t::type_to_string(const QualifiedType &qt) const
@@ -505,6 +815,17 @@ c_like_generator_t::type_string c_like_generator_t::type_to_string(const Qualifi
 	JVL_BUFFER_DUMP_AND_ABORT("failed to resolve type name for {}", qt);
 }
 
+const c_like_generator_t::type_string &c_like_generator_t::atom_type_to_string(Index index) const
+{
+	TypeId id = types.id(index);
+
+	auto it = type_strings.find(id);
+	if (it == type_strings.end())
+		it = type_strings.emplace(id, type_to_string(types.type(id))).first;
+
+	return it->second;
+}
+
 // Generators for each kind of instruction
 template <>
 void c_like_generator_t::generate(const Qualifier &, Index)
@@ -530,13 +851,13 @@ void c_like_generator_t::generate(const Primitive &primitive, Index index)
 template <>
 void c_like_generator_t::generate(const Swizzle &swizzle, Index index)
 {
-	define(index, inlined(index));
+	define(index);
 }
 
 template <>
 void c_like_generator_t::generate(const Operation &operation, Index index)
 {
-	define(index, inlined(index));
+	define(index);
 }
 
 template <>
@@ -562,13 +883,11 @@ void c_like_generator_t::generate(const Intrinsic &intrinsic, Index index)
 
 	if (voided) {
 		// Void return type, so no assignment
-		auto args = arguments(intrinsic.args);
-		std::string v = tbl_intrinsic_operation[intrinsic.opn] + arguments_to_string(args);
-		return finish(v);
+		source.append(indentation << 2, ' ');
+		inlined(source, index);
+		source += ";\n";
 	} else {
-		auto args = arguments(intrinsic.args);
-		auto intr = tbl_intrinsic_operation[intrinsic.opn];
-		return define(index, intr + arguments_to_string(args));
+		define(index);
 	}
 }
 
@@ -581,21 +900,18 @@ void c_like_generator_t::generate(const Construct &construct, Index index)
 	if (construct.args == -1)
 		return declare(index);
 
-	define(index, inlined(index));
+	define(index);
 }
 
 template <>
 void c_like_generator_t::generate(const Call &call, Index index)
 {
-	auto &buffer = TrackedBuffer::cache_load(call.cid);
-	std::string args = "()";
-	if (call.args != -1)
-		args = arguments_to_string(arguments(call.args));
-
 	if (call.type >= 0)
-		define(index, buffer.name + args);
-	else
-		finish(buffer.name + args);
+		return define(index);
+
+	source.append(indentation << 2, ' ');
+	inlined(source, index);
+	source += ";\n";
 }
 
 template <>
@@ -609,20 +925,20 @@ template <>
 void c_like_generator_t::generate(const Store &store, Index)
 {
 	comment(store.to_assembly_string());
-	assign(store.dst, inlined(store.src));
+	assign(store.dst, store.src);
 }
 
 template <>
 void c_like_generator_t::generate(const Load &load, Index index)
 {
 	comment(load.to_assembly_string());
-	define(index, inlined(index));
+	define(index);
 }
 
 template <>
 void c_like_generator_t::generate(const ArrayAccess &access, Index index)
 {
-	define(index, inlined(index));
+	define(index);
 }
 
 template <>
@@ -636,18 +952,18 @@ void c_like_generator_t::generate(const Branch &branch, Index)
 		return;
 
 	case conditional_if:
-		finish(fmt::format("if ({}) {{", inlined(branch.cond)), false);
+		condition("if", branch.cond);
 		indentation++;
 		return;
 
 	case loop_while:
-		finish(fmt::format("while ({}) {{", inlined(branch.cond)), false);
+		condition("while", branch.cond);
 		indentation++;
 		return;
 
 	case conditional_else_if:
 		indentation--;
-		finish(fmt::format("}} else if ({}) {{", inlined(branch.cond)), false);
+		condition("} else if", branch.cond);
 		indentation++;
 		return;
 
@@ -675,10 +991,13 @@ void c_like_generator_t::generate(const Return &returns, Index)
 {
 	comment(returns.to_assembly_string());
 
-	if (returns.value >= 0)
-		finish("return " + inlined(returns.value));
-	else
-		finish("return");
+	if (returns.value < 0)
+		return finish("return");
+
+	source.append(indentation << 2, ' ');
+	source += "return ";
+	inlined(source, returns.value);
+	source += ";\n";
 }
 
 // Per-atom generator
@@ -691,8 +1010,13 @@ void c_like_generator_t::generate(Index i)
 // General generator
 std::string c_like_generator_t::generate()
 {
+	bind();
+
+	// Generated statements average well under this many bytes per atom
+	source.reserve(source.size() + 16 * pointer);
+
 	for (size_t i = 0; i < pointer; i++) {
-		if (marked.count(i) || decorations.materialize.contains(i)) {
+		if (marked.count(i) || decorations.materialize.contains(i) || bound[i]) {
 			// TODO: comment
 			// TODO: option for debug info...
 			// fmt::println("  generating: {}", atoms[i]);
@@ -0,0 +1,520 @@
+#include <algorithm>
+
+#include <fmt/ranges.h>
+
+#include "common/logging.hpp"
+
+#include "thunder/cfg.hpp"
+
+namespace jvl::thunder {
+
+MODULE(cfg);
+
+// Compressed rows from (row, value) pairs, sorted and without duplicates
+void compress(std::vector <std::pair <Index, Index>> &pairs,
+	      size_t rows,
+	      std::vector <uint32_t> &offsets,
+	      std::vector <Index> &list)
+{
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+	offsets.assign(rows + 1, 0);
+	for (auto &[row, _] : pairs)
+		offsets[row + 1]++;
+
+	for (size_t i = 0; i < rows; i++)
+		offsets[i + 1] += offsets[i];
+
+	list.resize(pairs.size());
+	for (size_t i = 0; i < pairs.size(); i++)
+		list[i] = pairs[i].second;
+}
+
+// Basic blocks, edges and loop nesting
+void partition(ControlFlowGraph &cfg, const Buffer &buffer)
+{
+	size_t n = buffer.pointer;
+
+	// Each branch is in a block of its own, and
+	// returns terminate the block containing them
+	cfg.block_of.resize(n);
+
+	bool open = false;
+	for (size_t i = 0; i < n; i++) {
+		auto &atom = buffer.atoms[i];
+
+		bool branch = atom.is <Branch> ();
+		if (branch || !open) {
+			cfg.first.push_back(i);
+			cfg.last.push_back(i);
+		}
+
+		Index b = cfg.size() - 1;
+		cfg.block_of[i] = b;
+		cfg.last[b] = i;
+
+		open = !branch && !atom.is <Return> ();
+	}
+
+	size_t blocks = cfg.size();
+
+	// End of the conditional chain containing each arm
+	std::vector <Index> chain_end(n, -1);
+	for (Index i = n - 1; i >= 0; i--) {
+		auto branch = buffer.atoms[i].get <Branch> ();
+		if (!branch)
+			continue;
+
+		switch (branch->kind) {
+		case conditional_if:
+		case conditional_else_if:
+		case conditional_else:
+		{
+			Index f = branch->failto;
+			JVL_ASSERT(f > i && f < Index(n) && buffer.atoms[f].is <Branch> (),
+				"conditional branch (@{}) has an invalid target: {}", i, f);
+
+			auto &next = buffer.atoms[f].as <Branch> ();
+			chain_end[i] = (next.kind == control_flow_end) ? f : chain_end[f];
+		} break;
+		default:
+			break;
+		}
+	}
+
+	// Leaving a block in program order; the end of
+	// an arm skips the remaining arms of its chain
+	auto sequential = [&](Index b) -> Index {
+		if (b + 1 >= Index(blocks))
+			return -1;
+
+		Index j = cfg.first[b + 1];
+		if (auto branch = buffer.atoms[j].get <Branch> ()) {
+			if (branch->kind == conditional_else_if || branch->kind == conditional_else)
+				return cfg.block_of[chain_end[j]];
+		}
+
+		return b + 1;
+	};
+
+	std::vector <std::pair <Index, Index>> edges;
+
+	auto edge = [&](Index from, Index to) {
+		if (to != -1)
+			edges.emplace_back(from, to);
+	};
+
+	// Stack of the branches opening each loop
+	std::vector <Index> loops;
+
+	cfg.loop.resize(blocks, -1);
+	for (size_t b = 0; b < blocks; b++) {
+		Index i = cfg.last[b];
+
+		if (loops.size())
+			cfg.loop[b] = cfg.block_of[loops.back()];
+
+		auto &atom = buffer.atoms[i];
+		if (atom.is <Return> ())
+			continue;
+
+		auto branch = atom.get <Branch> ();
+		if (!branch) {
+			edge(b, sequential(b));
+			continue;
+		}
+
+		switch (branch->kind) {
+
+		case conditional_if:
+		case conditional_else_if:
+			edge(b, sequential(b));
+			edge(b, cfg.block_of[branch->failto]);
+			break;
+
+		case conditional_else:
+			edge(b, sequential(b));
+			break;
+
+		case loop_while:
+		case loop_for:
+			cfg.loop[b] = b;
+			loops.push_back(i);
+			edge(b, sequential(b));
+			edge(b, sequential(cfg.block_of[branch->failto]));
+			break;
+
+		case control_flow_skip:
+			JVL_ASSERT(loops.size(), "continue statement (@{}) outside of a loop", i);
+			edge(b, cfg.block_of[loops.back()]);
+			break;
+
+		case control_flow_stop:
+		{
+			JVL_ASSERT(loops.size(), "break statement (@{}) outside of a loop", i);
+			auto &header = buffer.atoms[loops.back()].as <Branch> ();
+			edge(b, sequential(cfg.block_of[header.failto]));
+		} break;
+
+		case control_flow_end:
+			if (loops.size() && buffer.atoms[loops.back()].as <Branch> ().failto == i) {
+				edge(b, cfg.block_of[loops.back()]);
+				loops.pop_back();
+			} else {
+				edge(b, sequential(b));
+			}
+			break;
+
+		default:
+			JVL_ABORT("unhandled branch kind:\n{}", atom);
+		}
+	}
+
+	auto reversed = edges;
+	for (auto &[from, to] : reversed)
+		std::swap(from, to);
+
+	compress(edges, blocks, cfg.successor_offsets, cfg.successor_list);
+	compress(reversed, blocks, cfg.predecessor_offsets, cfg.predecessor_list);
+}
+
+// Dominator tree using the iterative algorithm of Cooper, Harvey and Kennedy
+void dominators(ControlFlowGraph &cfg)
+{
+	size_t blocks = cfg.size();
+
+	// Reverse postorder of the reachable blocks
+	std::vector <Index> order;
+	std::vector <uint32_t> rpo(blocks, -1);
+	std::vector <uint8_t> visited(blocks, false);
+	std::vector <std::pair <Index, uint32_t>> stack;
+
+	stack.emplace_back(0, 0);
+	visited[0] = true;
+	while (stack.size()) {
+		auto &[b, k] = stack.back();
+
+		auto successors = cfg.successors(b);
+		if (k < successors.size()) {
+			Index s = successors[k++];
+			if (!visited[s]) {
+				visited[s] = true;
+				stack.emplace_back(s, 0);
+			}
+		} else {
+			order.push_back(b);
+			stack.pop_back();
+		}
+	}
+
+	std::reverse(order.begin(), order.end());
+	for (size_t i = 0; i < order.size(); i++)
+		rpo[order[i]] = i;
+
+	auto intersect = [&](Index a, Index b) {
+		while (a != b) {
+			while (rpo[a] > rpo[b])
+				a = cfg.idom[a];
+			while (rpo[b] > rpo[a])
+				b = cfg.idom[b];
+		}
+
+		return a;
+	};
+
+	cfg.idom.assign(blocks, -1);
+	cfg.idom[0] = 0;
+
+	bool changed;
+	do {
+		changed = false;
+		for (size_t i = 1; i < order.size(); i++) {
+			Index b = order[i];
+
+			Index dominator = -1;
+			for (Index p : cfg.predecessors(b)) {
+				if (cfg.idom[p] == -1)
+					continue;
+
+				dominator = (dominator == -1) ? p : intersect(p, dominator);
+			}
+
+			if (cfg.idom[b] != dominator) {
+				cfg.idom[b] = dominator;
+				changed = true;
+			}
+		}
+	} while (changed);
+
+	// Numbering the tree for dominance queries
+	std::vector <std::pair <Index, Index>> tree;
+	for (size_t b = 1; b < blocks; b++) {
+		if (cfg.idom[b] != -1)
+			tree.emplace_back(cfg.idom[b], b);
+	}
+
+	std::vector <uint32_t> offsets;
+	std::vector <Index> children;
+	compress(tree, blocks, offsets, children);
+
+	cfg.preorder.assign(blocks, -1);
+	cfg.postorder.assign(blocks, -1);
+
+	uint32_t pre = 0;
+	uint32_t post = 0;
+
+	stack.emplace_back(0, offsets[0]);
+	cfg.preorder[0] = pre++;
+	while (stack.size()) {
+		auto &[b, k] = stack.back();
+		if (k < offsets[b + 1]) {
+			Index c = children[k++];
+			cfg.preorder[c] = pre++;
+			stack.emplace_back(c, offsets[c]);
+		} else {
+			cfg.postorder[b] = post++;
+			stack.pop_back();
+		}
+	}
+
+	// Dominance frontiers, from the predecessors of join points
+	std::vector <std::pair <Index, Index>> frontiers;
+	for (size_t b = 0; b < blocks; b++) {
+		auto predecessors = cfg.predecessors(b);
+		if (predecessors.size() < 2 || !cfg.reachable(b))
+			continue;
+
+		for (Index p : predecessors) {
+			if (!cfg.reachable(p))
+				continue;
+
+			Index runner = p;
+			while (runner != cfg.idom[b]) {
+				frontiers.emplace_back(runner, b);
+				if (runner == cfg.idom[runner])
+					break;
+
+				runner = cfg.idom[runner];
+			}
+		}
+	}
+
+	compress(frontiers, blocks, cfg.frontier_offsets, cfg.frontier_list);
+}
+
+// Liveness of variables, and the phis of pruned SSA form
+void variables(ControlFlowGraph &cfg, const Buffer &buffer)
+{
+	size_t n = buffer.pointer;
+	size_t blocks = cfg.size();
+
+	cfg.variable_of.assign(n, -1);
+	for (size_t i = 0; i < n; i++) {
+		if (auto store = buffer.atoms[i].get <Store> ())
+			cfg.variable_of[buffer.reference_of(store->dst)] = 0;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (cfg.variable_of[i] != -1) {
+			cfg.variable_of[i] = cfg.variables.size();
+			cfg.variables.push_back(i);
+		}
+	}
+
+	size_t words = (cfg.variables.size() + 63) / 64;
+
+	cfg.words = words;
+
+	// Upward exposed uses and definitions of each block; values are
+	// considered to be read at the position of the atom using them
+	std::vector <uint64_t> used(blocks * words, 0);
+	std::vector <uint64_t> killed(blocks * words, 0);
+
+	auto set = [&](std::vector <uint64_t> &rows, Index b, Index v) {
+		rows[b * words + v / 64] |= (uint64_t(1) << (v % 64));
+	};
+
+	auto test = [&](std::vector <uint64_t> &rows, Index b, Index v) -> bool {
+		return (rows[b * words + v / 64] >> (v % 64)) & 1;
+	};
+
+	auto use = [&](Index b, Index k, Index i) {
+		if (k < 0 || k >= i)
+			return;
+
+		Index v = cfg.variable_of[k];
+		if (v != -1 && !test(killed, b, v))
+			set(used, b, v);
+	};
+
+	// Conditions of loops are evaluated in the header on every iteration,
+	// so the atoms inlined into them (neither marked nor materialized,
+	// nor variables) are read there as well as where they are placed
+	std::vector <Index> condition(n, -1);
+	std::vector <Index> work;
+
+	auto inlined = [&](Index k) {
+		return !buffer.marked.contains(k)
+			&& !buffer.decorations.materialize.contains(k)
+			&& cfg.variable_of[k] == -1;
+	};
+
+	auto header = [&](Index b, Index h, Index cond) {
+		work.assign(1, cond);
+		while (work.size()) {
+			Index k = work.back();
+			work.pop_back();
+
+			if (k < 0 || k >= h || condition[k] == h || !inlined(k))
+				continue;
+
+			condition[k] = h;
+
+			Atom atom = buffer.atoms[k];
+			auto &&addrs = atom.addresses();
+			use(b, addrs.a0, h);
+			use(b, addrs.a1, h);
+
+			work.push_back(addrs.a0);
+			work.push_back(addrs.a1);
+		}
+	};
+
+	// Blocks which define each variable
+	std::vector <std::pair <Index, Index>> definitions;
+
+	for (size_t i = 0; i < n; i++) {
+		Index b = cfg.block_of[i];
+
+		Atom atom = buffer.atoms[i];
+		if (auto store = atom.get <Store> ()) {
+			use(b, store->src, i);
+
+			Index v = cfg.variable_of[buffer.reference_of(store->dst)];
+			definitions.emplace_back(v, b);
+
+			// Partial stores read the rest of the value
+			if (store->dst != cfg.variables[v])
+				use(b, cfg.variables[v], i);
+			else
+				set(killed, b, v);
+
+			continue;
+		}
+
+		if (auto branch = atom.get <Branch> ()) {
+			if (branch->kind == loop_while || branch->kind == loop_for)
+				header(b, i, branch->cond);
+		}
+
+		auto &&addrs = atom.addresses();
+		use(b, addrs.a0, i);
+		use(b, addrs.a1, i);
+
+		if (Index v = cfg.variable_of[i]; v != -1) {
+			definitions.emplace_back(v, b);
+			set(killed, b, v);
+		}
+	}
+
+	// Backward data flow, visiting blocks in reverse order
+	cfg.live_in.assign(blocks * words, 0);
+	cfg.live_out.assign(blocks * words, 0);
+
+	bool changed;
+	do {
+		changed = false;
+		for (Index b = blocks - 1; b >= 0; b--) {
+			uint64_t *out = &cfg.live_out[b * words];
+			uint64_t *in = &cfg.live_in[b * words];
+
+			for (Index s : cfg.successors(b)) {
+				uint64_t *next = &cfg.live_in[s * words];
+				for (size_t w = 0; w < words; w++)
+					out[w] |= next[w];
+			}
+
+			for (size_t w = 0; w < words; w++) {
+				uint64_t value = used[b * words + w] | (out[w] & ~killed[b * words + w]);
+				changed |= (value != in[w]);
+				in[w] = value;
+			}
+		}
+	} while (changed);
+
+	// Phis on the iterated dominance frontier of the definitions,
+	// only where the variable is live at the entry of the block
+	std::sort(definitions.begin(), definitions.end());
+	definitions.erase(std::unique(definitions.begin(), definitions.end()), definitions.end());
+
+	std::vector <std::pair <Index, Index>> phis;
+	std::vector <Index> placed(blocks, -1);
+	std::vector <Index> queued(blocks, -1);
+	std::vector <Index> worklist;
+
+	for (size_t k = 0; k < definitions.size(); ) {
+		Index v = definitions[k].first;
+
+		for (; k < definitions.size() && definitions[k].first == v; k++) {
+			Index b = definitions[k].second;
+			queued[b] = v;
+			worklist.push_back(b);
+		}
+
+		while (worklist.size()) {
+			Index x = worklist.back();
+			worklist.pop_back();
+
+			for (Index y : cfg.frontier(x)) {
+				if (placed[y] == v)
+					continue;
+
+				placed[y] = v;
+				if (cfg.live_at_entry(y, v))
+					phis.emplace_back(y, v);
+
+				if (queued[y] != v) {
+					queued[y] = v;
+					worklist.push_back(y);
+				}
+			}
+		}
+	}
+
+	compress(phis, blocks, cfg.phi_offsets, cfg.phi_list);
+}
+
+ControlFlowGraph control_flow_graph(const Buffer &buffer)
+{
+	ControlFlowGraph cfg;
+	if (!buffer.pointer)
+		return cfg;
+
+	partition(cfg, buffer);
+	dominators(cfg);
+	variables(cfg, buffer);
+
+	return cfg;
+}
+
+void ControlFlowGraph::display() const
+{
+	for (size_t b = 0; b < size(); b++) {
+		fmt::println("block {} [{}, {}] (idom: {}, loop: {})",
+			b, first[b], last[b], idom[b], loop[b]);
+
+		fmt::println("  successors: {}", fmt::join(successors(b), ", "));
+		fmt::println("  predecessors: {}", fmt::join(predecessors(b), ", "));
+		fmt::println("  frontier: {}", fmt::join(frontier(b), ", "));
+
+		std::vector <Index> phi_variables;
+		for (Index v : phis(b))
+			phi_variables.push_back(variables[v]);
+
+		if (phi_variables.size())
+			fmt::println("  phis: {}", fmt::join(phi_variables, ", "));
+	}
+}
+
+} // namespace jvl::thunder
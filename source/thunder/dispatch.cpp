@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#include "common/logging.hpp"
+
+#include "thunder/dispatch.hpp"
+#include "thunder/enumerations.hpp"
+
+namespace jvl::thunder {
+
+MODULE(dispatch);
+
+// Values of the compute builtins for the running invocation,
+// with the vectors aligned as uvec3 is in std430
+struct dispatch_builtins {
+	alignas(16) uint32_t global[4];
+	alignas(16) uint32_t local[4];
+	alignas(16) uint32_t group[4];
+	alignas(16) uint32_t size[4];
+	uint32_t index;
+};
+
+static size_t round_up(size_t offset, size_t align)
+{
+	return align * ((offset + align - 1) / align);
+}
+
+ComputeKernel::ComputeKernel(const LinkageUnit &unit)
+		: interpreter(unit),
+		local_size(unit.local_size.value_or(glm::uvec3(1, 1, 1))),
+		shared_size(0)
+{
+	auto &globals = interpreter.globals();
+
+	shared_offsets.resize(globals.size(), 0);
+	for (size_t i = 0; i < globals.size(); i++) {
+		auto &global = globals[i];
+
+		switch (global.kind) {
+		case shared:
+			shared_offsets[i] = round_up(shared_size, 16);
+			shared_size = shared_offsets[i] + global.size;
+			break;
+		case storage_buffer:
+		case push_constant:
+		case glsl_GlobalInvocationID:
+		case glsl_LocalInvocationID:
+		case glsl_LocalInvocationIndex:
+		case glsl_WorkGroupID:
+		case glsl_WorkGroupSize:
+			break;
+		default:
+			JVL_ABORT("global variable {} (binding {}) cannot be bound when dispatching on the host",
+				tbl_qualifier_kind[global.kind], global.binding);
+		}
+	}
+}
+
+glm::uvec3 ComputeKernel::workgroup_size() const
+{
+	return local_size;
+}
+
+void ComputeKernel::dispatch(uint32_t gx, uint32_t gy, uint32_t gz, const DispatchBindings &bindings, ThreadPool &pool) const
+{
+	size_t groups = size_t(gx) * size_t(gy) * size_t(gz);
+	if (!groups)
+		return;
+
+	auto &globals = interpreter.globals();
+
+	// Buffers are shared by all invocations, builtins are per worker
+	std::vector <void *> resolved(globals.size(), nullptr);
+	for (size_t i = 0; i < globals.size(); i++) {
+		auto &global = globals[i];
+
+		if (global.kind == storage_buffer) {
+			auto it = bindings.buffers.find(global.binding);
+			JVL_ASSERT(it != bindings.buffers.end(),
+				"no host memory is bound to the storage buffer at binding {}",
+				global.binding);
+
+			resolved[i] = it->second;
+		} else if (global.kind == push_constant) {
+			JVL_ASSERT(bindings.push_constants, "kernel reads push constants, but none were bound");
+
+			auto block = static_cast <const std::byte *> (bindings.push_constants);
+			resolved[i] = const_cast <std::byte *> (block + std::max <Index> (global.binding, 0));
+		}
+	}
+
+	// Workgroups are claimed one at a time, which balances out uneven groups
+	std::atomic <size_t> next = 0;
+
+	size_t invocations = size_t(local_size.x) * size_t(local_size.y) * size_t(local_size.z);
+
+	auto work = [&]() {
+		dispatch_builtins builtins {};
+
+		builtins.size[0] = local_size.x;
+		builtins.size[1] = local_size.y;
+		builtins.size[2] = local_size.z;
+
+		// Shared memory of the workgroup running on this worker
+		using word_t = std::max_align_t;
+
+		std::vector <word_t> memory(round_up(shared_size, sizeof(word_t)) / sizeof(word_t));
+		auto block = reinterpret_cast <std::byte *> (memory.data());
+
+		std::vector <void *> pointers = resolved;
+		for (size_t i = 0; i < globals.size(); i++) {
+			switch (globals[i].kind) {
+			case glsl_GlobalInvocationID:
+				pointers[i] = builtins.global;
+				break;
+			case glsl_LocalInvocationID:
+				pointers[i] = builtins.local;
+				break;
+			case glsl_LocalInvocationIndex:
+				pointers[i] = &builtins.index;
+				break;
+			case glsl_WorkGroupID:
+				pointers[i] = builtins.group;
+				break;
+			case glsl_WorkGroupSize:
+				pointers[i] = builtins.size;
+				break;
+			case shared:
+				pointers[i] = block + shared_offsets[i];
+				break;
+			default:
+				break;
+			}
+		}
+
+		auto locate = [&](size_t j) {
+			builtins.local[0] = j % local_size.x;
+			builtins.local[1] = (j / local_size.x) % local_size.y;
+			builtins.local[2] = j / (size_t(local_size.x) * size_t(local_size.y));
+			builtins.index = j;
+
+			for (size_t k = 0; k < 3; k++)
+				builtins.global[k] = builtins.group[k] * builtins.size[k] + builtins.local[k];
+		};
+
+		// Suspended invocations keep their frames on separate stacks
+		bool synchronized = interpreter.barriers();
+
+		size_t stride = round_up(interpreter.stack_size(), sizeof(word_t)) / sizeof(word_t);
+
+		std::vector <word_t> stacks(synchronized ? invocations * stride : 0);
+		std::vector <uint32_t> points(synchronized ? invocations : 0);
+		std::vector <uint8_t> running(synchronized ? invocations : 0);
+
+		size_t g;
+		while ((g = next.fetch_add(1, std::memory_order_relaxed)) < groups) {
+			builtins.group[0] = g % gx;
+			builtins.group[1] = (g / gx) % gy;
+			builtins.group[2] = g / (size_t(gx) * size_t(gy));
+
+			if (shared_size)
+				std::memset(block, 0, shared_size);
+
+			if (!synchronized) {
+				for (size_t j = 0; j < invocations; j++) {
+					locate(j);
+					interpreter.invoke(nullptr, nullptr, pointers.data());
+				}
+
+				continue;
+			}
+
+			// Every invocation runs up to its next barrier before
+			// any of them continues past it
+			std::fill(points.begin(), points.end(), 0);
+			std::fill(running.begin(), running.end(), 1);
+
+			for (bool pending = true; pending; ) {
+				pending = false;
+				for (size_t j = 0; j < invocations; j++) {
+					if (!running[j])
+						continue;
+
+					locate(j);
+
+					auto stack = reinterpret_cast <std::byte *> (stacks.data() + j * stride);
+					points[j] = interpreter.resume(stack, points[j], pointers.data());
+					running[j] = (points[j] != 0);
+					pending |= running[j];
+				}
+			}
+		}
+	};
+
+	// The calling thread takes part, and then waits for the helpers
+	size_t helpers = std::min(groups, pool.size() + 1) - 1;
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	size_t remaining = helpers;
+
+	for (size_t i = 0; i < helpers; i++) {
+		pool.push([&]() {
+			work();
+
+			// Notifying under the lock keeps the state alive until then
+			std::lock_guard guard(mutex);
+			if (--remaining == 0)
+				finished.notify_all();
+		});
+	}
+
+	work();
+
+	std::unique_lock lock(mutex);
+	finished.wait(lock, [&]() { return remaining == 0; });
+}
+
+void dispatch(const LinkageUnit &unit, uint32_t gx, uint32_t gy, uint32_t gz, const DispatchBindings &bindings)
+{
+	ComputeKernel(unit).dispatch(gx, gy, gz, bindings);
+}
+
+} // namespace jvl::thunder
@@ -46,6 +46,12 @@ gcc_type_info generate_primitive_scalar_type(gcc_jit_context *const context, Pri
 			.size = 4,
 			.align = 4,
 		};
+	case u64:
+		return {
+			.real = gcc_jit_context_get_type(context, GCC_JIT_TYPE_UINT64_T),
+			.size = 8,
+			.align = 8,
+		};
 	case f32:
 		return {
 			.real = gcc_jit_context_get_type(context, GCC_JIT_TYPE_FLOAT),
@@ -92,6 +98,17 @@ gcc_type_info generate_primitive_vector_type(gcc_jit_context *context,
 		"primitive type {}x{}",
 		tbl_primitive_types[item], components);
 
+	// Two and four components are native vectors, which
+	// have the same size and alignment as the structure
+	if (components == 2 || components == 4) {
+		return {
+			.real = gcc_jit_type_get_vector(element.real, components),
+			.storage = gcc_jit_struct_as_type(vector),
+			.size = components * element.size,
+			.align = components * element.size,
+		};
+	}
+
 	// TODO: generalize
 	return {
 		.real = gcc_jit_struct_as_type(vector),
@@ -108,6 +125,7 @@ gcc_type_info generate_primitive_type(gcc_jit_context *const context, PrimitiveT
 	case boolean:
 	case i32:
 	case u32:
+	case u64:
 	case f32:
 		return generate_primitive_scalar_type(context, item);
 
@@ -149,6 +167,12 @@ gcc_jit_object *generate_primitive(gcc_jit_context *const context, const Primiti
 
 	switch (primitive.type) {
 
+	case boolean:
+	{
+		auto rv = gcc_jit_context_new_rvalue_from_int(context, scalar_type, primitive.bdata);
+		return gcc_jit_rvalue_as_object(rv);
+	}
+
 	case i32:
 	{
 		auto rv = gcc_jit_context_new_rvalue_from_int(context, scalar_type, primitive.idata);
@@ -161,6 +185,12 @@ gcc_jit_object *generate_primitive(gcc_jit_context *const context, const Primiti
 		return gcc_jit_rvalue_as_object(rv);
 	}
 
+	case u64:
+	{
+		auto rv = gcc_jit_context_new_rvalue_from_long(context, scalar_type, primitive.udata);
+		return gcc_jit_rvalue_as_object(rv);
+	}
+
 	case f32:
 	{
 		auto rv = gcc_jit_context_new_rvalue_from_double(context, scalar_type, primitive.fdata);
@@ -204,6 +234,68 @@ gcc_jit_object *generate_operation(gcc_jit_context *const context,
 	JVL_ABORT("unsupported operation: {}", tbl_operation_code[code]);
 }
 
+// Conversions between native vectors and their structures
+gcc_jit_rvalue *vector_from_storage(gcc_jit_context *const context, gcc_jit_rvalue *rv, const gcc_type_info &info)
+{
+	if (!info.storage)
+		return rv;
+
+	return gcc_jit_context_new_bitcast(context, LOCATION(context), rv, info.real);
+}
+
+gcc_jit_rvalue *vector_to_storage(gcc_jit_context *const context, gcc_jit_rvalue *rv, const gcc_type_info &info)
+{
+	if (!info.storage)
+		return rv;
+
+	return gcc_jit_context_new_bitcast(context, LOCATION(context), rv, info.storage);
+}
+
+size_t vector_lanes(const gcc_type_info &info)
+{
+	auto structure = reinterpret_cast <gcc_jit_struct *> (info.storage);
+	return gcc_jit_struct_get_field_count(structure);
+}
+
+// Broadcasting a scalar to every lane of a native vector
+gcc_jit_rvalue *vector_splat(gcc_jit_context *const context, gcc_jit_rvalue *rv, const gcc_type_info &info)
+{
+	std::vector <gcc_jit_rvalue *> lanes(vector_lanes(info), rv);
+
+	return gcc_jit_context_new_rvalue_from_vector(context,
+		LOCATION(context), info.real,
+		lanes.size(), lanes.data());
+}
+
+// Dot product of native vectors, as a single product
+// followed by the sum of the lanes of the result
+gcc_jit_rvalue *vector_dot(gcc_jit_context *const context,
+			   const gcc_type_info &info,
+			   gcc_jit_type *scalar,
+			   gcc_jit_rvalue *one,
+			   gcc_jit_rvalue *two)
+{
+	gcc_jit_rvalue *product = gcc_jit_context_new_binary_op(context,
+		LOCATION(context), GCC_JIT_BINARY_OP_MULT,
+		info.real, one, two);
+
+	product = vector_to_storage(context, product, info);
+
+	auto structure = reinterpret_cast <gcc_jit_struct *> (info.storage);
+
+	gcc_jit_rvalue *sum = nullptr;
+	for (size_t i = 0; i < vector_lanes(info); i++) {
+		auto field = gcc_jit_struct_get_field(structure, i);
+		auto lane = gcc_jit_rvalue_access_field(product, LOCATION(context), field);
+
+		sum = sum ? gcc_jit_context_new_binary_op(context,
+				LOCATION(context), GCC_JIT_BINARY_OP_PLUS,
+				scalar, sum, lane) : lane;
+	}
+
+	return sum;
+}
+
 struct intrinsic_lookup_info {
 	IntrinsicOperation opn;
 	std::vector <PrimitiveType> types;
@@ -291,8 +383,8 @@ gcc_jit_function *intrinsic_lookup(gcc_jit_context *const context, const intrins
 	JVL_ABORT("{} intrinsic is unsupported in (gcc) JIT", tbl_intrinsic_operation[info.opn]);
 }
 
-gcc_jit_function_generator_t::gcc_jit_function_generator_t(gcc_jit_context *const context_, const Buffer &buffer_)
-		: Buffer(buffer_), context(context_) {}
+gcc_jit_function_generator_t::gcc_jit_function_generator_t(gcc_jit_context *const context_, const BufferView &view)
+		: BufferView(view), context(context_) {}
 
 // Generating types
 gcc_type_info gcc_jit_function_generator_t::jitify_type(QualifiedType qt)
@@ -344,6 +436,10 @@ gcc_type_info gcc_jit_function_generator_t::jitify_type(QualifiedType qt)
 			fmt::println("  size of resulting field: {}", info.size);
 			fmt::println("  align of resulting field: {}", info.align);
 
+			// Native vectors are kept in their structures
+			info.real = info.stored();
+			info.storage = nullptr;
+
 			field_infos.push_back(info);
 		}
 
@@ -498,6 +594,7 @@ gcc_jit_object *gcc_jit_function_generator_t::generate(const Construct &construc
 		if (qualifier.kind == parameter) {
 			Index loc = qualifier.numerical;
 			auto rv = gcc_jit_param_as_rvalue(parameters[loc]);
+			rv = vector_from_storage(context, rv, jitify_type(types[qualifier.underlying]));
 			return gcc_jit_rvalue_as_object(rv);
 		}
 
@@ -514,6 +611,31 @@ gcc_jit_object *gcc_jit_function_generator_t::generate(const Construct &construc
 	fmt::println("regular constructor: {} args", args.rvalues.size());
 	fmt::println("  struct size: {}", info.size);
 
+	// Native vectors are built from their lanes, or from a single
+	// scalar which is broadcast or a vector which is passed through
+	if (info.storage) {
+		if (args.rvalues.size() == 1 && vector_type(args.types[0]))
+			return gcc_jit_rvalue_as_object(args.rvalues[0]);
+
+		if (args.rvalues.size() == 1)
+			return gcc_jit_rvalue_as_object(vector_splat(context, args.rvalues[0], info));
+
+		JVL_ASSERT(vector_lanes(info) == args.rvalues.size(),
+			"mismatch in construct arguments (got {}, expected {}), "
+			"did you legalize the instructions for GCC JIT?",
+			args.rvalues.size(), vector_lanes(info));
+
+		gcc_jit_rvalue *constructed = gcc_jit_context_new_rvalue_from_vector(context,
+			LOCATION(context),
+			info.real,
+			args.rvalues.size(),
+			args.rvalues.data());
+
+		JVL_ASSERT_PLAIN(constructed);
+
+		return gcc_jit_rvalue_as_object(constructed);
+	}
+
 	gcc_jit_type *type = info.real;
 	gcc_jit_struct *structure = reinterpret_cast <gcc_jit_struct *> (type);
 
@@ -529,6 +651,9 @@ gcc_jit_object *gcc_jit_function_generator_t::generate(const Construct &construc
 	for (size_t i = 0; i < args.rvalues.size(); i++) {
 		auto field = gcc_jit_struct_get_field(structure, i);
 		fields.emplace_back(field);
+
+		auto arg = jitify_type(QualifiedType::primitive(args.types[i]));
+		args.rvalues[i] = vector_to_storage(context, args.rvalues[i], arg);
 	}
 
 	gcc_jit_rvalue *constructed = gcc_jit_context_new_struct_constructor(context,
@@ -553,11 +678,13 @@ gcc_jit_object *gcc_jit_function_generator_t::load_field(Index src, Index index,
 	// TODO: double check that it is indeed a struct
 
 	auto type = jitify_type(original);
-	auto struct_type = reinterpret_cast <gcc_jit_struct*> (type.real);
+	auto struct_type = reinterpret_cast <gcc_jit_struct*> (type.stored());
 	auto field = gcc_jit_struct_get_field(struct_type, index);
 
+	// Lanes of native vectors are read through their structures
 	auto v = values.at(src);
 	auto rv = reinterpret_cast <gcc_jit_rvalue *> (v);
+	rv = vector_to_storage(context, rv, type);
 	rv = gcc_jit_rvalue_access_field(rv, LOCATION(context), field);
 
 	return gcc_jit_rvalue_as_object(rv);
@@ -584,8 +711,12 @@ gcc_jit_object *gcc_jit_function_generator_t::generate(const Load &load, Index i
 	auto v = values.at(load.src);
 	if (load.idx == -1)
 		return v;
-	
-	return load_field(load.src, load.idx, false);
+
+	// Fields which are native vectors are stored as structures
+	auto field = reinterpret_cast <gcc_jit_rvalue *> (load_field(load.src, load.idx, false));
+	auto rv = vector_from_storage(context, field, jitify_type(types[index]));
+
+	return gcc_jit_rvalue_as_object(rv);
 }
 
 template <>
@@ -597,6 +728,14 @@ gcc_jit_object *gcc_jit_function_generator_t::generate(const Operation &operatio
 	auto one = reinterpret_cast <gcc_jit_rvalue *> (values.at(operation.a));
 	auto two = reinterpret_cast <gcc_jit_rvalue *> (values.at(operation.b));
 
+	// Scalar operands of native vector operations are broadcast
+	if (type.storage) {
+		if (!jitify_type(types[operation.a]).storage)
+			one = vector_splat(context, one, type);
+		if (!jitify_type(types[operation.b]).storage)
+			two = vector_splat(context, two, type);
+	}
+
 	return generate_operation(context, operation.code, type.real, one, two);
 }
 
@@ -608,6 +747,15 @@ gcc_jit_object *gcc_jit_function_generator_t::generate(const Intrinsic &intrinsi
 
 	auto args = expand_list_chain(intrinsic.args);
 
+	// Dot products of native vectors are reduced in place
+	if (intrinsic.opn == dot && args.rvalues.size() == 2) {
+		auto vector = jitify_type(QualifiedType::primitive(args.types[0]));
+		if (vector.storage) {
+			auto rv = vector_dot(context, vector, type.real, args.rvalues[0], args.rvalues[1]);
+			return gcc_jit_rvalue_as_object(rv);
+		}
+	}
+
 	auto info = intrinsic_lookup_info {
 		.opn = intrinsic.opn,
 		.types = args.types,
@@ -633,6 +781,7 @@ gcc_jit_object *gcc_jit_function_generator_t::generate(const Return &returns, In
 {
 	auto v = values.at(returns.value);
 	auto rv = reinterpret_cast <gcc_jit_rvalue *> (v);
+	rv = vector_to_storage(context, rv, jitify_type(types[index]));
 	gcc_jit_block_end_with_return(block, LOCATION(context), rv);
 	return nullptr;
 }
@@ -653,7 +802,8 @@ auto gcc_jit_function_generator_t::work_list()
 		if (next == -1)
 			continue;
 
-		auto &atom = atoms[next];	
+		// Addresses are only available from mutable atoms
+		Atom atom = atoms[next];
 		if (atom.is <TypeInformation> () && !marked.contains(next)) {
 			// Unless explicitly requires from the
 			// synthesized list of atoms, we
@@ -687,7 +837,7 @@ void gcc_jit_function_generator_t::begin_function()
 		if (auto qualifier = atom.get <Qualifier> ()) {
 			if (qualifier->kind == parameter) {
 				Index underlying = qualifier->underlying;
-				gcc_jit_type *type = jitify_type(types[underlying]).real;
+				gcc_jit_type *type = jitify_type(types[underlying]).stored();
 
 				size_t loc = qualifier->numerical;
 				size_t size = std::max(parameters.size(), loc + 1);
@@ -701,7 +851,7 @@ void gcc_jit_function_generator_t::begin_function()
 		}
 
 		if (auto returns = atom.get <Return> ())
-			return_type = jitify_type(types[i]).real;
+			return_type = jitify_type(types[i]).stored();
 	}
 
 	function = gcc_jit_context_new_function(context,
@@ -732,4 +882,16 @@ void gcc_jit_function_generator_t::generate()
 	}
 }
 
+bool gcc_jit_supported(const BufferView &view)
+{
+	for (size_t i = 0; i < view.pointer; i++) {
+		auto &atom = view.atoms[i];
+		if (atom.is <Branch> () || atom.is <Call> ()
+			|| atom.is <Storage> () || atom.is <ArrayAccess> ())
+			return false;
+	}
+
+	return true;
+}
+
 } // namespace jvl::thunder::detail
\ No newline at end of file
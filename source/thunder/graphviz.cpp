@@ -146,8 +146,8 @@ std::string instruction_record(const Atom &atom)
 	variant_case(Atom, Call):
 	{
 		auto &call = atom.as <Call> ();
-		auto &buffer= TrackedBuffer::cache_load(call.cid);
-		return buffer.name + " | ";
+		auto buffer = TrackedBuffer::cache_load(call.cid);
+		return buffer->name + " | ";
 	}
 	
 	variant_case(Atom, Load):
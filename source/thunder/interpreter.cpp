@@ -0,0 +1,1632 @@
+#include <cstring>
+
+#include "common/logging.hpp"
+
+#include "thunder/atom.hpp"
+#include "thunder/enumerations.hpp"
+#include "thunder/interpreter.hpp"
+#include "thunder/properties.hpp"
+#include "thunder/qualified_type.hpp"
+
+namespace jvl::thunder {
+
+namespace detail {
+
+MODULE(interpreter);
+
+const char *tbl_interpreter_opcode[__op_end] = {
+#define JVL_INTERPRETER_NAME(name) #name,
+	JVL_INTERPRETER_OPCODES(JVL_INTERPRETER_NAME)
+#undef JVL_INTERPRETER_NAME
+};
+
+// Helper methods for primitive types
+static bool matrix_type(PrimitiveType primitive)
+{
+	switch (primitive) {
+	case mat2:
+	case mat3:
+	case mat4:
+	case mat4x3:
+	case mat3x4:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Column type and count of matrices
+static std::pair <PrimitiveType, uint32_t> matrix_columns(PrimitiveType primitive)
+{
+	switch (primitive) {
+	case mat2:
+		return { vec2, 2 };
+	case mat3:
+		return { vec3, 3 };
+	case mat4:
+		return { vec4, 4 };
+	case mat4x3:
+		return { vec3, 4 };
+	case mat3x4:
+		return { vec4, 3 };
+	default:
+		break;
+	}
+
+	JVL_ABORT("{} is not a matrix type", tbl_primitive_types[primitive]);
+}
+
+static PrimitiveType component_of(PrimitiveType primitive)
+{
+	if (vector_type(primitive))
+		return swizzle_type_of(primitive, SwizzleCode::x);
+
+	if (matrix_type(primitive))
+		return f32;
+
+	return primitive;
+}
+
+static PrimitiveType vector_of(PrimitiveType component, size_t count)
+{
+	static constexpr PrimitiveType floats[] { f32, f32, vec2, vec3, vec4 };
+	static constexpr PrimitiveType ints[] { i32, i32, ivec2, ivec3, ivec4 };
+	static constexpr PrimitiveType uints[] { u32, u32, uvec2, uvec3, uvec4 };
+
+	JVL_ASSERT(count <= 4, "vectors are limited to four components, requested {}", count);
+
+	switch (component) {
+	case f32:
+		return floats[count];
+	case i32:
+		return ints[count];
+	case u32:
+		return uints[count];
+	case boolean:
+		if (count <= 1)
+			return boolean;
+		break;
+	default:
+		break;
+	}
+
+	JVL_ABORT("no vector type with {} components", tbl_primitive_types[component]);
+}
+
+static uint32_t round_up(uint32_t offset, uint32_t align)
+{
+	return align * ((offset + align - 1) / align);
+}
+
+static uint32_t scalar_size(PrimitiveType component)
+{
+	return (component == u64) ? 8 : 4;
+}
+
+// Layouts of primitives follow std430, matching solid_t on the host
+static uint32_t column_stride(uint32_t rows)
+{
+	return (rows == 2) ? 8 : 16;
+}
+
+static interpreter_function_generator_t::layout_info primitive_layout(PrimitiveType item)
+{
+	if (item == none)
+		return { 0, 1 };
+
+	if (matrix_type(item)) {
+		auto [column, count] = matrix_columns(item);
+		return { count * column_stride(vector_component_count(column)), 16 };
+	}
+
+	uint32_t scalar = scalar_size(component_of(item));
+	switch (vector_component_count(item)) {
+	case 0:
+		return { scalar, scalar };
+	case 2:
+		return { 2 * scalar, 2 * scalar };
+	case 3:
+		return { 3 * scalar, 4 * scalar };
+	default:
+		return { 4 * scalar, 4 * scalar };
+	}
+}
+
+// Number of components that element-wise instructions go over;
+// matrices are processed whole, including the padding of columns
+static uint16_t words(PrimitiveType item)
+{
+	return primitive_layout(item).size / scalar_size(component_of(item));
+}
+
+///////////////////////////////////
+// Interpreter function lowering //
+///////////////////////////////////
+
+interpreter_function_generator_t::interpreter_function_generator_t(interpreter_program &program_, const LinkageUnit &unit_, size_t index)
+		: BufferView(unit_.functions[index]),
+		program(program_),
+		unit(unit_),
+		function(unit_.functions[index]),
+		result(program_.functions[index]) {}
+
+// Types and layouts
+QualifiedType interpreter_function_generator_t::resolve(QualifiedType qt) const
+{
+	while (true) {
+		switch (qt.index()) {
+
+		variant_case(QualifiedType, PlainDataType):
+		{
+			auto &pd = qt.as <PlainDataType> ();
+			if (pd.is <PrimitiveType> ())
+				return qt;
+
+			qt = types[pd.as <Index> ()];
+		} break;
+
+		variant_case(QualifiedType, InArgType):
+			qt = static_cast <PlainDataType> (qt.as <InArgType> ());
+			break;
+
+		variant_case(QualifiedType, OutArgType):
+			qt = static_cast <PlainDataType> (qt.as <OutArgType> ());
+			break;
+
+		variant_case(QualifiedType, InOutArgType):
+			qt = static_cast <PlainDataType> (qt.as <InOutArgType> ());
+			break;
+
+		default:
+			return qt;
+		}
+	}
+}
+
+std::vector <QualifiedType> interpreter_function_generator_t::fields(QualifiedType qt) const
+{
+	std::vector <QualifiedType> result;
+
+	while (qt.is <StructFieldType> ()) {
+		auto &sft = qt.as <StructFieldType> ();
+		result.push_back(sft.base());
+		qt = types[sft.next];
+	}
+
+	JVL_ASSERT(qt.is <NilType> (), "failed to reach nil marker for structure, got {} instead", qt);
+
+	return result;
+}
+
+PrimitiveType interpreter_function_generator_t::primitive(Index i) const
+{
+	auto qt = resolve(types[i]);
+	JVL_ASSERT(qt.is_primitive(), "expected a primitive type for @{}, got {} instead", i, qt);
+	return qt.as <PlainDataType> ().as <PrimitiveType> ();
+}
+
+interpreter_function_generator_t::layout_info interpreter_function_generator_t::layout(const QualifiedType &original) const
+{
+	auto qt = resolve(original);
+
+	if (qt.is <NilType> ())
+		return { 0, 1 };
+
+	if (qt.is_primitive())
+		return primitive_layout(qt.as <PlainDataType> ().as <PrimitiveType> ());
+
+	if (auto at = qt.get <ArrayType> ()) {
+		auto info = layout(at->element());
+		uint32_t stride = round_up(info.size, info.align);
+		uint32_t count = std::max <int32_t> (at->size, 0);
+		return { count * stride, info.align };
+	}
+
+	if (qt.is <StructFieldType> ()) {
+		uint32_t offset = 0;
+		uint32_t align = 1;
+		for (auto &field : fields(qt)) {
+			auto info = layout(field);
+			offset = round_up(offset, info.align) + info.size;
+			align = std::max(align, info.align);
+		}
+
+		return { round_up(offset, align), align };
+	}
+
+	JVL_ABORT("failed to compute the memory layout of {}", original);
+}
+
+uint32_t interpreter_function_generator_t::field_offset(const QualifiedType &original, Index idx) const
+{
+	auto members = fields(resolve(original));
+
+	JVL_ASSERT(idx >= 0 && size_t(idx) < members.size(),
+		"field index {} is out of bounds for {}", idx, original);
+
+	uint32_t offset = 0;
+	for (Index k = 0; k < idx; k++) {
+		auto info = layout(members[k]);
+		offset = round_up(offset, info.align) + info.size;
+	}
+
+	return round_up(offset, layout(members[idx]).align);
+}
+
+uint32_t interpreter_function_generator_t::element_stride(const QualifiedType &original) const
+{
+	auto qt = resolve(original);
+
+	if (auto at = qt.get <ArrayType> ()) {
+		auto info = layout(at->element());
+		return round_up(info.size, info.align);
+	}
+
+	if (qt.is_primitive()) {
+		auto item = qt.as <PlainDataType> ().as <PrimitiveType> ();
+		if (matrix_type(item))
+			return column_stride(vector_component_count(matrix_columns(item).first));
+
+		if (vector_type(item))
+			return scalar_size(component_of(item));
+	}
+
+	JVL_ABORT("{} cannot be indexed", original);
+}
+
+// Frame allocation and instructions
+uint32_t interpreter_function_generator_t::allocate(const layout_info &info)
+{
+	uint32_t offset = round_up(result.frame, std::max <uint32_t> (info.align, 1));
+	result.frame = offset + info.size;
+	return offset;
+}
+
+uint32_t interpreter_function_generator_t::allocate(const QualifiedType &qt)
+{
+	return allocate(layout(qt));
+}
+
+uint32_t interpreter_function_generator_t::slot(Index i)
+{
+	auto it = temporaries.find(i);
+	if (it != temporaries.end())
+		return it->second;
+
+	return (temporaries[i] = allocate(types[i]));
+}
+
+uint32_t interpreter_function_generator_t::constant(const Primitive &primitive)
+{
+	// Booleans only set their first byte
+	uint64_t bits = (primitive.type == boolean) ? uint64_t(primitive.bdata) : uint64_t(primitive.udata);
+
+	auto key = std::make_pair(primitive.type, bits);
+
+	auto it = constants.find(key);
+	if (it != constants.end())
+		return it->second;
+
+	auto info = primitive_layout(primitive.type);
+	uint32_t offset = allocate(info);
+
+	auto &image = result.image;
+	if (image.size() < offset + info.size - result.base)
+		image.resize(offset + info.size - result.base);
+
+	if (info.size == 8) {
+		std::memcpy(image.data() + offset - result.base, &bits, 8);
+	} else {
+		uint32_t word = uint32_t(bits);
+		std::memcpy(image.data() + offset - result.base, &word, 4);
+	}
+
+	return (constants[key] = offset);
+}
+
+uint32_t interpreter_function_generator_t::emit(interpreter_opcode code, uint32_t dst, uint32_t a, uint32_t b, uint32_t c, uint16_t count)
+{
+	interpreter_instruction instruction;
+	instruction.code = code;
+	instruction.count = count;
+	instruction.dst = dst;
+	instruction.a = a;
+	instruction.b = b;
+	instruction.c = c;
+
+	result.code.push_back(instruction);
+
+	return result.code.size() - 1;
+}
+
+uint32_t interpreter_function_generator_t::here() const
+{
+	return result.code.size();
+}
+
+// Jump targets start new blocks
+void interpreter_function_generator_t::label()
+{
+	cache.clear();
+}
+
+void interpreter_function_generator_t::patch(const std::vector <uint32_t> &jumps, uint32_t target)
+{
+	for (uint32_t j : jumps) {
+		auto &instruction = result.code[j];
+		if (instruction.code == op_jump)
+			instruction.a = target;
+		else
+			instruction.b = target;
+	}
+}
+
+void interpreter_function_generator_t::copy(uint32_t dst, uint32_t src, uint32_t size)
+{
+	if (dst != src && size)
+		emit(op_copy, dst, src, 0, size);
+}
+
+void interpreter_function_generator_t::convert(uint32_t dst, uint32_t src, PrimitiveType from, PrimitiveType to)
+{
+	if (from == to)
+		return copy(dst, src, primitive_layout(to).size);
+
+	// Scalars are broadcast to vectors
+	size_t count = vector_component_count(to);
+	if (count && !vector_component_count(from)) {
+		uint32_t scalar = converted(src, from, component_of(to));
+		emit(op_splat32, dst, scalar, 0, 0, count);
+		return;
+	}
+
+	auto source = component_of(from);
+	auto target = component_of(to);
+	uint16_t n = std::max <size_t> (count, 1);
+
+	JVL_ASSERT(!matrix_type(from) && !matrix_type(to) && target != boolean,
+		"unsupported conversion from {} to {}",
+		tbl_primitive_types[from], tbl_primitive_types[to]);
+
+	// Booleans are stored as 0 or 1, same as the integers
+	auto integral = [](PrimitiveType p) {
+		return p == boolean || p == i32 || p == u32;
+	};
+
+	if (source == target || (integral(source) && integral(target)))
+		return copy(dst, src, 4 * n);
+
+	interpreter_opcode code = op_copy;
+	if (source == f32)
+		code = (target == i32) ? op_f32_to_i32 : ((target == u32) ? op_f32_to_u32 : op_f32_to_u64);
+	else if (target == f32)
+		code = (source == i32) ? op_i32_to_f32 : ((source == u64) ? op_u64_to_f32 : op_u32_to_f32);
+	else if (target == u64)
+		code = (source == i32) ? op_i32_to_u64 : op_u32_to_u64;
+	else
+		code = op_u64_to_u32;
+
+	emit(code, dst, src, 0, 0, n);
+}
+
+uint32_t interpreter_function_generator_t::converted(uint32_t src, PrimitiveType from, PrimitiveType to)
+{
+	if (from == to)
+		return src;
+
+	uint32_t dst = allocate(primitive_layout(to));
+	convert(dst, src, from, to);
+	return dst;
+}
+
+uint32_t interpreter_function_generator_t::splat(uint32_t src, PrimitiveType from, PrimitiveType to)
+{
+	size_t count = vector_component_count(to);
+	if (from == to || count == 0 || vector_component_count(from) != 0)
+		return src;
+
+	uint32_t dst = allocate(primitive_layout(to));
+	convert(dst, src, from, to);
+	return dst;
+}
+
+// Values and locations
+uint32_t interpreter_function_generator_t::pointer(const location &loc)
+{
+	uint32_t dst = allocate(layout_info(sizeof(void *), sizeof(void *)));
+
+	if (!loc.indirect) {
+		emit(op_address, dst, loc.slot + loc.offset);
+		return dst;
+	}
+
+	if (!loc.offset)
+		return loc.slot;
+
+	Primitive offset;
+	offset.type = u32;
+	offset.udata = loc.offset;
+
+	emit(op_index, dst, loc.slot, constant(offset), 1);
+
+	return dst;
+}
+
+uint32_t interpreter_function_generator_t::global_variable(Index i)
+{
+	// Memory qualifiers wrap the declaration of the buffer
+	while (true) {
+		auto &qualifier = atoms[i].as <Qualifier> ();
+		if (qualifier.kind != writeonly && qualifier.kind != readonly && qualifier.kind != scalar)
+			break;
+
+		i = qualifier.underlying;
+	}
+
+	auto &qualifier = atoms[i].as <Qualifier> ();
+
+	JVL_ASSERT(qualifier.kind != uniform_buffer,
+		"uniform buffers (std140) are unsupported by the interpreter");
+
+	auto &table = program.globals;
+
+	uint32_t global = 0;
+	while (global < table.size()) {
+		auto &existing = table[global];
+		if (existing.kind == qualifier.kind && existing.binding == qualifier.numerical)
+			break;
+
+		global++;
+	}
+
+	if (global == table.size())
+		table.push_back(interpreter_global(qualifier.kind, qualifier.numerical, layout(types[i]).size));
+
+	auto it = globals.find(global);
+	if (it != globals.end())
+		return it->second;
+
+	uint32_t slot = allocate(layout_info(sizeof(void *), sizeof(void *)));
+	result.bindings.push_back(interpreter_binding(slot, global));
+
+	return (globals[global] = slot);
+}
+
+std::optional <interpreter_function_generator_t::location> interpreter_function_generator_t::address(Index i)
+{
+	auto it = locals.find(i);
+	if (it != locals.end())
+		return location(false, it->second, 0);
+
+	auto &atom = atoms[i];
+
+	switch (atom.index()) {
+
+	// Parameters live in the frame, including output parameters
+	// which the caller copies back once the function returns
+	variant_case(Atom, Qualifier):
+	{
+		auto &qualifier = atom.as <Qualifier> ();
+		if (qualifier.kind == parameter)
+			return location(false, result.parameters[qualifier.numerical], 0);
+
+		return location(true, global_variable(i), 0);
+	}
+
+	variant_case(Atom, Construct):
+	{
+		auto &constructor = atom.as <Construct> ();
+		if (constructor.mode == global)
+			return address(constructor.type);
+	} break;
+
+	variant_case(Atom, Load):
+	{
+		auto &load = atom.as <Load> ();
+
+		auto src = address(load.src);
+		if (src && load.idx != -1)
+			src->offset += field_offset(types[load.src], load.idx);
+
+		return src;
+	}
+
+	variant_case(Atom, ArrayAccess):
+	{
+		auto &access = atom.as <ArrayAccess> ();
+
+		auto src = address(access.src);
+		if (!src)
+			break;
+
+		uint32_t stride = element_stride(types[access.src]);
+
+		// Constant indices are folded into the offset
+		if (auto index = atoms[access.loc].get <Primitive> (); index && !locals.contains(access.loc)) {
+			src->offset += stride * index->udata;
+			return src;
+		}
+
+		uint32_t base = pointer(src.value());
+		uint32_t loc = value(access.loc);
+
+		uint32_t dst = allocate(layout_info(sizeof(void *), sizeof(void *)));
+		emit(op_index, dst, base, loc, stride);
+
+		return location(true, dst, 0);
+	}
+
+	variant_case(Atom, Swizzle):
+	{
+		auto &swizzle = atom.as <Swizzle> ();
+
+		auto src = address(swizzle.src);
+		if (src && swizzle.code <= SwizzleCode::w)
+			src->offset += 4 * uint32_t(swizzle.code);
+
+		return src;
+	}
+
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+void interpreter_function_generator_t::load(const location &src, uint32_t dst, uint32_t size)
+{
+	if (src.indirect)
+		emit(op_load, dst, src.slot, src.offset, size);
+	else
+		copy(dst, src.slot + src.offset, size);
+}
+
+void interpreter_function_generator_t::store(const location &dst, uint32_t src, uint32_t size)
+{
+	if (dst.indirect)
+		emit(op_store, dst.slot, src, dst.offset, size);
+	else
+		copy(dst.slot + dst.offset, src, size);
+
+	// Inlined values may have read the destination
+	cache.clear();
+}
+
+uint32_t interpreter_function_generator_t::value(Index i)
+{
+	JVL_ASSERT(i != -1, "invalid index passed to value");
+
+	auto it = values.find(i);
+	if (it != values.end())
+		return it->second;
+
+	auto &atom = atoms[i];
+	if (auto primitive = atom.get <Primitive> (); primitive && !locals.contains(i))
+		return constant(primitive.value());
+
+	auto cached = cache.find(i);
+	if (cached != cache.end())
+		return cached->second;
+
+	uint32_t result = 0;
+	if (auto loc = address(i)) {
+		// Reading variables in the frame needs no instructions
+		if (loc->indirect) {
+			result = slot(i);
+			load(loc.value(), result, layout(types[i]).size);
+		} else {
+			result = loc->slot + loc->offset;
+		}
+	} else if (auto load = atom.get <Load> ()) {
+		// Fields of values are read where they are
+		result = value(load->src);
+		if (load->idx != -1)
+			result += field_offset(types[load->src], load->idx);
+	} else if (auto swizzle = atom.get <Swizzle> ()) {
+		result = value(swizzle->src);
+		if (swizzle->code <= SwizzleCode::w)
+			result += 4 * uint32_t(swizzle->code);
+	} else {
+		result = slot(i);
+		compute(i, result);
+	}
+
+	return (cache[i] = result);
+}
+
+void interpreter_function_generator_t::compute(Index i, uint32_t dst)
+{
+	auto &atom = atoms[i];
+
+	switch (atom.index()) {
+
+	variant_case(Atom, Primitive):
+	{
+		auto &primitive = atom.as <Primitive> ();
+		return copy(dst, constant(primitive), primitive_layout(primitive.type).size);
+	}
+
+	variant_case(Atom, Operation):
+		return generate_operation(atom.as <Operation> (), i, dst);
+
+	variant_case(Atom, Intrinsic):
+		return generate_intrinsic(atom.as <Intrinsic> (), i, dst);
+
+	variant_case(Atom, Construct):
+		return generate_construct(atom.as <Construct> (), i, dst);
+
+	variant_case(Atom, Call):
+		return generate_call(atom.as <Call> (), i, dst);
+
+	variant_case(Atom, Storage):
+		// Declared without a value
+		return;
+
+	variant_case(Atom, ArrayAccess):
+	{
+		auto &access = atom.as <ArrayAccess> ();
+
+		uint32_t src = value(access.src);
+		uint32_t stride = element_stride(types[access.src]);
+		uint32_t size = layout(types[i]).size;
+
+		if (auto index = atoms[access.loc].get <Primitive> (); index && !locals.contains(access.loc))
+			return copy(dst, src + stride * index->udata, size);
+
+		// Dynamic indexing into values goes through their address
+		uint32_t base = allocate(layout_info(sizeof(void *), sizeof(void *)));
+		emit(op_address, base, src);
+		emit(op_index, base, base, value(access.loc), stride);
+		emit(op_load, dst, base, 0, size);
+	} return;
+
+	default:
+		break;
+	}
+
+	JVL_ABORT("failed to lower value for the interpreter: {} (@{})", atom, i);
+}
+
+// Materialized atoms are evaluated in place
+void interpreter_function_generator_t::define(Index i)
+{
+	auto it = locals.find(i);
+	if (it != locals.end())
+		return compute(i, it->second);
+
+	// Resolved as locations wherever they are used
+	if (lvalues.contains(i))
+		return;
+
+	// Values read from variables are copied, since
+	// the variables may be written to later on
+	uint32_t src = value(i);
+	uint32_t dst = slot(i);
+	copy(dst, src, layout(types[i]).size);
+
+	values[i] = dst;
+}
+
+// Operations
+static std::pair <interpreter_opcode, bool> operation_code(OperationCode code, PrimitiveType component)
+{
+	bool floating = (component == f32);
+	bool sign = (component == i32);
+	bool wide = (component == u64);
+
+	switch (code) {
+	case addition:
+		return { floating ? op_add_f32 : (wide ? op_add_u64 : op_add_u32), false };
+	case subtraction:
+		return { floating ? op_sub_f32 : (wide ? op_sub_u64 : op_sub_u32), false };
+	case multiplication:
+		return { floating ? op_mul_f32 : (wide ? op_mul_u64 : op_mul_u32), false };
+	case division:
+		return { floating ? op_div_f32 : (sign ? op_div_i32 : (wide ? op_div_u64 : op_div_u32)), false };
+	case modulus:
+		return { floating ? op_mod_f32 : (sign ? op_mod_i32 : (wide ? op_mod_u64 : op_mod_u32)), false };
+	case bool_or:
+	case bit_or:
+		return { wide ? op_or_u64 : op_or_u32, false };
+	case bool_and:
+	case bit_and:
+		return { wide ? op_and_u64 : op_and_u32, false };
+	case bit_xor:
+		return { wide ? op_xor_u64 : op_xor_u32, false };
+	case bit_shift_left:
+		return { wide ? op_shl_u64 : op_shl_u32, false };
+	case bit_shift_right:
+		return { sign ? op_shr_i32 : (wide ? op_shr_u64 : op_shr_u32), false };
+	case equals:
+		return { floating ? op_eq_f32 : (wide ? op_eq_u64 : op_eq_u32), false };
+	case not_equals:
+		return { floating ? op_ne_f32 : (wide ? op_ne_u64 : op_ne_u32), false };
+	default:
+		break;
+	}
+
+	// Greater than comparisons swap their operands
+	interpreter_opcode less = floating ? op_lt_f32 : (sign ? op_lt_i32 : (wide ? op_lt_u64 : op_lt_u32));
+	interpreter_opcode equal = floating ? op_le_f32 : (sign ? op_le_i32 : (wide ? op_le_u64 : op_le_u32));
+
+	switch (code) {
+	case cmp_le:
+		return { less, false };
+	case cmp_leq:
+		return { equal, false };
+	case cmp_ge:
+		return { less, true };
+	case cmp_geq:
+		return { equal, true };
+	default:
+		break;
+	}
+
+	JVL_ABORT("unsupported operation for the interpreter: {}", tbl_operation_code[code]);
+}
+
+void interpreter_function_generator_t::generate_operation(const Operation &operation, Index i, uint32_t dst)
+{
+	switch (operation.code) {
+	case swz_x:
+	case swz_y:
+	case swz_z:
+	case swz_w:
+	{
+		uint32_t component = operation.code - swz_x;
+		return copy(dst, value(operation.a) + 4 * component, 4);
+	}
+
+	case unary_negation:
+	{
+		auto pa = primitive(operation.a);
+		auto component = component_of(pa);
+
+		interpreter_opcode code = op_neg_u32;
+		if (component == f32)
+			code = op_neg_f32;
+		else if (component == u64)
+			code = op_neg_u64;
+
+		emit(code, dst, value(operation.a), 0, 0, words(pa));
+	} return;
+
+	case bool_not:
+		emit(op_not_bool, dst, value(operation.a), 0, 0, words(primitive(operation.a)));
+		return;
+
+	default:
+		break;
+	}
+
+	auto pa = primitive(operation.a);
+	auto pb = primitive(operation.b);
+
+	uint32_t a = value(operation.a);
+	uint32_t b = value(operation.b);
+
+	// Linear algebra has a dedicated instruction
+	if (operation.code == multiplication && component_of(pa) == f32) {
+		bool ma = matrix_type(pa);
+		bool mb = matrix_type(pb);
+		bool va = vector_type(pa);
+		bool vb = vector_type(pb);
+
+		auto dimensions = [](PrimitiveType p) -> std::pair <uint32_t, uint32_t> {
+			auto [column, count] = matrix_columns(p);
+			return { vector_component_count(column), count };
+		};
+
+		std::optional <interpreter_matrix_shape> shape;
+		if (ma && mb) {
+			auto [rows, inner] = dimensions(pa);
+			uint32_t columns = dimensions(pb).second;
+			shape = interpreter_matrix_shape {
+				rows, inner, columns,
+				{ column_stride(rows), column_stride(inner), column_stride(rows) }
+			};
+		} else if (ma && vb) {
+			auto [rows, inner] = dimensions(pa);
+			shape = interpreter_matrix_shape {
+				rows, inner, 1,
+				{ column_stride(rows), 4 * inner, 4 * rows }
+			};
+		} else if (va && mb) {
+			auto [inner, columns] = dimensions(pb);
+			shape = interpreter_matrix_shape {
+				1, inner, columns,
+				{ 4, column_stride(inner), 4 }
+			};
+		}
+
+		if (shape) {
+			emit(op_matmul, dst, a, b, shape->packed(), shape->count());
+			return;
+		}
+	}
+
+	// Scalars are broadcast against vectors and matrices
+	auto broadcast = [&](uint32_t src, PrimitiveType from, PrimitiveType to) {
+		uint32_t scalar = converted(src, from, component_of(to));
+		uint32_t dst = allocate(primitive_layout(to));
+		emit(op_splat32, dst, scalar, 0, 0, words(to));
+		return dst;
+	};
+
+	bool sa = vector_type(pa) || matrix_type(pa);
+	bool sb = vector_type(pb) || matrix_type(pb);
+
+	if (sa && !sb) {
+		b = broadcast(b, pb, pa);
+	} else if (sb && !sa) {
+		a = broadcast(a, pa, pb);
+		pa = pb;
+	} else if (component_of(pa) != component_of(pb)) {
+		b = converted(b, pb, pa);
+	}
+
+	auto [code, swap] = operation_code(operation.code, component_of(pa));
+	if (swap)
+		std::swap(a, b);
+
+	emit(code, dst, a, b, 0, words(pa));
+}
+
+// Intrinsics, with their arguments broadcast to the result type
+static interpreter_opcode intrinsic_code(IntrinsicOperation opn, PrimitiveType component, size_t arguments)
+{
+	bool floating = (component == f32);
+	bool sign = (component == i32);
+
+	switch (opn) {
+	case sin:
+		return op_sin;
+	case cos:
+		return op_cos;
+	case tan:
+		return op_tan;
+	case asin:
+		return op_asin;
+	case acos:
+		return op_acos;
+	case atan:
+		return (arguments == 2) ? op_atan2 : op_atan;
+	case sinh:
+		return op_sinh;
+	case cosh:
+		return op_cosh;
+	case tanh:
+		return op_tanh;
+	case pow:
+		return op_pow;
+	case exp:
+		return op_exp;
+	case log:
+		return op_log;
+	case sqrt:
+		return op_sqrt;
+	case floor:
+		return op_floor;
+	case ceil:
+		return op_ceil;
+	case fract:
+		return op_fract;
+	case mix:
+		return op_mix;
+	case smoothstep:
+		return op_smoothstep;
+	case abs:
+		return floating ? op_abs_f32 : op_abs_i32;
+	case min:
+		return floating ? op_min_f32 : (sign ? op_min_i32 : op_min_u32);
+	case max:
+		return floating ? op_max_f32 : (sign ? op_max_i32 : op_max_u32);
+	case clamp:
+		return floating ? op_clamp_f32 : (sign ? op_clamp_i32 : op_clamp_u32);
+	case mod:
+		return operation_code(modulus, component).first;
+	default:
+		break;
+	}
+
+	JVL_ABORT("{} intrinsic is unsupported by the interpreter", tbl_intrinsic_operation[opn]);
+}
+
+void interpreter_function_generator_t::generate_intrinsic(const Intrinsic &intrinsic, Index i, uint32_t dst)
+{
+	switch (intrinsic.opn) {
+
+	// Handled by the linkage unit
+	case layout_local_size:
+	case layout_mesh_shader_sizes:
+		return;
+
+	// Invocations of a workgroup take turns at barriers, so
+	// values read from memory before one are stale after it
+	case glsl_barrier:
+		emit(op_barrier);
+		label();
+		return;
+
+	default:
+		break;
+	}
+
+	auto args = expand_list(intrinsic.args);
+	auto result = primitive(i);
+
+	std::vector <uint32_t> operands;
+	for (auto j : args)
+		operands.push_back(value(j));
+
+	switch (intrinsic.opn) {
+
+	case cast_to_int:
+	case cast_to_ivec2:
+	case cast_to_ivec3:
+	case cast_to_ivec4:
+	case cast_to_uint:
+	case cast_to_uvec2:
+	case cast_to_uvec3:
+	case cast_to_uvec4:
+	case cast_to_float:
+	case cast_to_vec2:
+	case cast_to_vec3:
+	case cast_to_vec4:
+	case cast_to_uint64:
+		return convert(dst, operands[0], primitive(args[0]), result);
+
+	case glsl_floatBitsToInt:
+	case glsl_floatBitsToUint:
+	case glsl_intBitsToFloat:
+	case glsl_uintBitsToFloat:
+		return copy(dst, operands[0], primitive_layout(result).size);
+
+	case dot:
+		emit(op_dot, dst, operands[0], operands[1], 0, words(primitive(args[0])));
+		return;
+
+	case length:
+		emit(op_length, dst, operands[0], 0, 0, words(primitive(args[0])));
+		return;
+
+	case normalize:
+		emit(op_normalize, dst, operands[0], 0, 0, words(result));
+		return;
+
+	case cross:
+		emit(op_cross, dst, operands[0], operands[1], 0, 3);
+		return;
+
+	case reflect:
+		emit(op_reflect, dst, operands[0], operands[1], 0, words(result));
+		return;
+
+	default:
+		break;
+	}
+
+	// Scalar arguments are broadcast for vector results
+	for (size_t j = 0; j < args.size(); j++)
+		operands[j] = splat(operands[j], primitive(args[j]), result);
+
+	operands.resize(3, 0);
+
+	auto code = intrinsic_code(intrinsic.opn, component_of(primitive(args[0])), args.size());
+
+	emit(code, dst, operands[0], operands[1], operands[2], words(result));
+}
+
+// Constructors
+void interpreter_function_generator_t::generate_construct(const Construct &constructor, Index i, uint32_t dst)
+{
+	uint32_t size = layout(types[i]).size;
+
+	if (constructor.mode == global)
+		return copy(dst, value(constructor.type), size);
+
+	// Declarations are zero initialized
+	if (constructor.args == -1) {
+		emit(op_zero, dst, 0, 0, size);
+		return;
+	}
+
+	auto args = expand_list(constructor.args);
+
+	auto qt = resolve(types[i]);
+	if (auto at = qt.get <ArrayType> ()) {
+		uint32_t stride = element_stride(qt);
+		uint32_t element = layout(at->element()).size;
+		for (size_t k = 0; k < args.size(); k++)
+			copy(dst + k * stride, value(args[k]), element);
+
+		return;
+	}
+
+	if (qt.is <StructFieldType> ()) {
+		auto members = fields(qt);
+
+		JVL_ASSERT(members.size() == args.size(),
+			"structure with {} fields constructed from {} arguments",
+			members.size(), args.size());
+
+		uint32_t offset = 0;
+		for (size_t k = 0; k < args.size(); k++) {
+			auto info = layout(members[k]);
+			offset = round_up(offset, info.align);
+			copy(dst + offset, value(args[k]), info.size);
+			offset += info.size;
+		}
+
+		return;
+	}
+
+	auto result = qt.as <PlainDataType> ().as <PrimitiveType> ();
+	auto component = component_of(result);
+
+	// Scalars and splatting
+	if (args.size() == 1) {
+		auto pa = primitive(args[0]);
+		if (!matrix_type(result) || vector_type(pa) || matrix_type(pa))
+			return convert(dst, value(args[0]), pa, result);
+	}
+
+	if (matrix_type(result)) {
+		auto [column, count] = matrix_columns(result);
+		uint32_t rows = vector_component_count(column);
+		uint32_t stride = column_stride(rows);
+
+		if (args.size() == 1) {
+			// Diagonal matrices
+			uint32_t diagonal = converted(value(args[0]), primitive(args[0]), f32);
+
+			emit(op_zero, dst, 0, 0, size);
+			for (uint32_t c = 0; c < std::min(count, rows); c++)
+				copy(dst + c * stride + 4 * c, diagonal, 4);
+		} else if (args.size() == count) {
+			for (uint32_t c = 0; c < count; c++)
+				convert(dst + c * stride, value(args[c]), primitive(args[c]), column);
+		} else {
+			JVL_ASSERT(args.size() == count * rows,
+				"invalid number of arguments for {} constructor",
+				tbl_primitive_types[result]);
+
+			for (uint32_t k = 0; k < args.size(); k++) {
+				uint32_t offset = (k / rows) * stride + 4 * (k % rows);
+				convert(dst + offset, value(args[k]), primitive(args[k]), f32);
+			}
+		}
+
+		return;
+	}
+
+	// Vectors from scalars and smaller vectors
+	uint32_t offset = 0;
+	for (auto j : args) {
+		auto pj = primitive(j);
+		size_t n = std::max <size_t> (vector_component_count(pj), 1);
+		convert(dst + offset, value(j), pj, vector_of(component, n));
+		offset += n * scalar_size(component);
+	}
+}
+
+// Calling other functions in the unit
+void interpreter_function_generator_t::generate_call(const Call &call, Index, uint32_t dst)
+{
+	JVL_ASSERT(unit.loaded.contains(call.cid), "callable ${} is not part of the linkage unit", call.cid);
+
+	uint32_t index = unit.loaded.at(call.cid);
+	auto &callee = unit.functions[index];
+
+	auto args = expand_list(call.args);
+
+	struct writeback {
+		location dst;
+		uint32_t src;
+		uint32_t size;
+	};
+
+	std::vector <writeback> writebacks;
+
+	interpreter_call descriptor;
+	descriptor.function = index;
+
+	for (size_t j = 0; j < args.size(); j++) {
+		auto &qt = callee.args[j];
+		bool output = qt.is <OutArgType> () || qt.is <InOutArgType> ();
+
+		uint32_t size = layout(qt).size;
+		uint32_t caller = 0;
+		if (output) {
+			auto loc = address(args[j]);
+			JVL_ASSERT(loc.has_value(), "output argument (@{}) is not addressable", args[j]);
+
+			// Variables behind pointers are written back through a temporary
+			if (loc->indirect) {
+				caller = allocate(layout(qt));
+				load(loc.value(), caller, size);
+				writebacks.push_back(writeback(loc.value(), caller, size));
+			} else {
+				caller = loc->slot + loc->offset;
+			}
+		} else {
+			caller = value(args[j]);
+		}
+
+		descriptor.arguments.push_back(interpreter_argument(caller, 0, size, output));
+	}
+
+	program.calls.push_back(descriptor);
+
+	emit(op_call, dst, program.calls.size() - 1);
+
+	for (auto &wb : writebacks)
+		store(wb.dst, wb.src, wb.size);
+
+	// Callees may write through their arguments
+	cache.clear();
+}
+
+// Per-atom generator
+template <>
+void interpreter_function_generator_t::generate(const Qualifier &, Index)
+{
+	// Parameters and global variables are addressed where they are used
+}
+
+template <>
+void interpreter_function_generator_t::generate(const TypeInformation &, Index)
+{
+	// Types are only needed for layouts
+}
+
+template <>
+void interpreter_function_generator_t::generate(const List &, Index)
+{
+	// Lists are expanded by their users
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Primitive &, Index index)
+{
+	if (locals.contains(index))
+		define(index);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Operation &, Index index)
+{
+	define(index);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Swizzle &, Index index)
+{
+	define(index);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Load &, Index index)
+{
+	define(index);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const ArrayAccess &, Index index)
+{
+	define(index);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Intrinsic &intrinsic, Index index)
+{
+	auto qt = resolve(types[index]);
+
+	bool voided = qt.is <NilType> ();
+	if (auto pd = qt.get <PlainDataType> ()) {
+		if (auto p = pd->get <PrimitiveType> ())
+			voided |= (p == none);
+	}
+
+	if (voided || side_effects(intrinsic.opn))
+		generate_intrinsic(intrinsic, index, 0);
+	else
+		define(index);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Construct &constructor, Index index)
+{
+	if (constructor.mode == global)
+		return;
+
+	define(index);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Call &call, Index index)
+{
+	if (call.type >= 0)
+		define(index);
+	else
+		generate_call(call, index, 0);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Storage &, Index)
+{
+	// Allocated with the rest of the local variables
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Store &store, Index)
+{
+	uint32_t src = value(store.src);
+
+	auto dst = address(store.dst);
+	JVL_ASSERT(dst.has_value(), "store destination (@{}) is not addressable", store.dst);
+
+	this->store(dst.value(), src, layout(types[store.dst]).size);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Branch &branch, Index)
+{
+	this->branch(branch);
+}
+
+template <>
+void interpreter_function_generator_t::generate(const Return &returns, Index)
+{
+	if (returns.value >= 0)
+		emit(op_ret, 0, value(returns.value), 0, result.returns);
+	else
+		emit(op_ret);
+}
+
+// Control flow, lowered to jumps which are patched once their targets are known
+void interpreter_function_generator_t::branch(const Branch &branch)
+{
+	auto innermost_loop = [&]() -> construct & {
+		for (auto it = constructs.rbegin(); it != constructs.rend(); it++) {
+			if (it->kind == loop_while)
+				return *it;
+		}
+
+		JVL_ABORT("control flow statement outside of a loop");
+	};
+
+	switch (branch.kind) {
+
+	case conditional_if:
+	{
+		construct selection;
+		selection.kind = conditional_if;
+		selection.header = here();
+		selection.next = { emit(op_unless, 0, value(branch.cond)) };
+
+		label();
+
+		constructs.push_back(selection);
+	} break;
+
+	case conditional_else_if:
+	case conditional_else:
+	{
+		JVL_ASSERT(constructs.size() && constructs.back().next.size(),
+			"{} branch without a preceding if", tbl_branch_kind[branch.kind]);
+
+		auto &previous = constructs.back();
+		previous.merge.push_back(emit(op_jump));
+		patch(previous.next, here());
+		previous.next.clear();
+
+		label();
+
+		if (branch.kind == conditional_else_if) {
+			previous.next = { emit(op_unless, 0, value(branch.cond)) };
+			label();
+		}
+	} break;
+
+	case loop_while:
+	case loop_for:
+	{
+		label();
+
+		// Conditions are evaluated again on every iteration
+		construct loop;
+		loop.kind = loop_while;
+		loop.header = here();
+		loop.merge = { emit(op_unless, 0, value(branch.cond)) };
+
+		label();
+
+		constructs.push_back(loop);
+	} break;
+
+	case control_flow_skip:
+		innermost_loop().continuing.push_back(emit(op_jump));
+		break;
+
+	case control_flow_stop:
+		innermost_loop().merge.push_back(emit(op_jump));
+		break;
+
+	case control_flow_end:
+	{
+		JVL_ASSERT(constructs.size(), "end of control flow without an open construct");
+
+		auto current = constructs.back();
+		constructs.pop_back();
+
+		if (current.kind == loop_while) {
+			patch(current.continuing, here());
+			emit(op_jump, 0, current.header);
+		}
+
+		patch(current.next, here());
+		patch(current.merge, here());
+
+		label();
+	} break;
+
+	default:
+		JVL_ABORT("failed to lower branch for the interpreter: {}", branch);
+	}
+}
+
+void interpreter_function_generator_t::generate(Index i)
+{
+	auto ftn = [&](auto atom) { return generate(atom, i); };
+	return std::visit(ftn, atoms[i]);
+}
+
+// Wholistic generation
+void interpreter_function_generator_t::generate()
+{
+	// Parameters lead the frame, followed by the constants
+	for (auto &qt : function.args) {
+		auto info = layout(qt);
+		result.parameters.push_back(allocate(info));
+		result.sizes.push_back(info.size);
+	}
+
+	result.name = function.name;
+	result.returns = layout(function.returns).size;
+	result.base = round_up(result.frame, 16);
+	result.frame = result.base;
+
+	for (size_t i = 0; i < pointer; i++) {
+		if (auto primitive = atoms[i].get <Primitive> ())
+			constant(primitive.value());
+	}
+
+	// Variables are needed for everything that is written to
+	std::set <Index> written;
+
+	auto lvalue = [&](Index i) {
+		Index root = reference_of(i);
+		for (Index j = i; j != root; ) {
+			lvalues.insert(j);
+			if (auto load = atoms[j].get <Load> ())
+				j = load->src;
+			else if (auto access = atoms[j].get <ArrayAccess> ())
+				j = access->src;
+			else
+				j = atoms[j].as <Swizzle> ().src;
+		}
+
+		written.insert(root);
+	};
+
+	for (size_t i = 0; i < pointer; i++) {
+		auto &atom = atoms[i];
+
+		if (auto store = atom.get <Store> ())
+			lvalue(store->dst);
+
+		if (atom.is <Storage> ())
+			written.insert(i);
+
+		if (auto call = atom.get <Call> ()) {
+			if (!unit.loaded.contains(call->cid))
+				continue;
+
+			auto &callee = unit.functions[unit.loaded.at(call->cid)];
+
+			auto args = expand_list(call->args);
+			for (size_t j = 0; j < args.size(); j++) {
+				auto &qt = callee.args[j];
+				if (qt.is <OutArgType> () || qt.is <InOutArgType> ())
+					lvalue(args[j]);
+			}
+		}
+	}
+
+	for (Index i : written) {
+		// Parameters and global variables are already addressable
+		Index root = i;
+		if (auto constructor = atoms[i].get <Construct> (); constructor && constructor->mode == global)
+			root = constructor->type;
+
+		if (atoms[root].is <Qualifier> ())
+			continue;
+
+		locals[i] = allocate(types[i]);
+	}
+
+	for (size_t i = 0; i < pointer; i++) {
+		if (marked.contains(i) || decorations.materialize.contains(i) || locals.contains(i))
+			generate(i);
+	}
+
+	JVL_ASSERT(constructs.empty(), "unterminated control flow in function '{}'", function.name);
+
+	emit(op_ret);
+}
+
+} // namespace detail
+
+/////////////////////////////
+// Interpreter entry point //
+/////////////////////////////
+
+MODULE(interpreter);
+
+Interpreter::Interpreter(const LinkageUnit &unit) : entry(0), synchronized(false)
+{
+	using namespace detail;
+
+	JVL_ASSERT(unit.functions.size(), "cannot interpret an empty linkage unit");
+
+	auto &functions = program.functions;
+
+	functions.resize(unit.functions.size());
+	for (size_t i = 0; i < unit.functions.size(); i++) {
+		interpreter_function_generator_t generator(program, unit, i);
+		generator.generate();
+
+		if (unit.functions[i].name == "main")
+			entry = i;
+	}
+
+	// Arguments are copied straight into the parameters of callees
+	for (auto &call : program.calls) {
+		auto &callee = functions[call.function];
+		for (size_t j = 0; j < call.arguments.size(); j++)
+			call.arguments[j].callee = callee.parameters[j];
+	}
+
+	// Frames of callees are placed after the frame of their caller
+	enum : uint8_t { unvisited, visiting, visited };
+
+	std::vector <uint8_t> state(functions.size(), unvisited);
+
+	program.stack.resize(functions.size(), 0);
+
+	auto depth = [&](auto &self, uint32_t index) -> uint32_t {
+		JVL_ASSERT(state[index] != visiting,
+			"recursive calls through '{}' are unsupported by the interpreter",
+			functions[index].name);
+
+		if (state[index] == visited)
+			return program.stack[index];
+
+		state[index] = visiting;
+
+		uint32_t deepest = 0;
+		for (auto &instruction : functions[index].code) {
+			if (instruction.code == op_call)
+				deepest = std::max(deepest, self(self, program.calls[instruction.a].function));
+		}
+
+		state[index] = visited;
+
+		return (program.stack[index] = interpreter_frame_size(functions[index]) + deepest);
+	};
+
+	for (uint32_t i = 0; i < functions.size(); i++)
+		depth(depth, i);
+
+	// Only the entry point can be suspended at barriers, since
+	// callees run to completion within the frame of their caller
+	for (uint32_t i = 0; i < functions.size(); i++) {
+		for (auto &instruction : functions[i].code) {
+			if (instruction.code != op_barrier)
+				continue;
+
+			JVL_ASSERT(i == entry,
+				"barriers in '{}' are unsupported by the interpreter, "
+				"only the entry point may wait on barriers",
+				functions[i].name);
+
+			synchronized = true;
+		}
+	}
+
+	// Resolving the handlers of each instruction
+	auto handlers = interpreter_handlers();
+	for (auto &function : functions) {
+		for (auto &instruction : function.code)
+			instruction.handler = handlers[instruction.code];
+	}
+}
+
+const detail::interpreter_program &Interpreter::lowered() const
+{
+	return program;
+}
+
+const std::vector <detail::interpreter_global> &Interpreter::globals() const
+{
+	return program.globals;
+}
+
+size_t Interpreter::stack_size() const
+{
+	return program.stack[entry];
+}
+
+bool Interpreter::barriers() const
+{
+	return synchronized;
+}
+
+// Each thread keeps its own stack, which is reused across invocations
+std::byte *Interpreter::stack() const
+{
+	static thread_local std::vector <std::max_align_t> memory;
+
+	size_t words = (stack_size() + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+	if (memory.size() < words)
+		memory.resize(words);
+
+	return reinterpret_cast <std::byte *> (memory.data());
+}
+
+void Interpreter::invoke(void *result, const void *const *args, void *const *globals) const
+{
+	invoke(stack(), result, args, globals);
+}
+
+void Interpreter::invoke(std::byte *stack, void *result, const void *const *args, void *const *globals) const
+{
+	auto &function = program.functions[entry];
+	for (size_t j = 0; j < function.parameters.size(); j++)
+		std::memcpy(stack + function.parameters[j], args[j], function.sizes[j]);
+
+	detail::interpreter_execute(program, entry, stack, result, globals);
+}
+
+uint32_t Interpreter::resume(std::byte *stack, uint32_t point, void *const *globals) const
+{
+	JVL_ASSERT(program.functions[entry].parameters.empty(),
+		"only entry points without parameters can be resumed");
+
+	return detail::interpreter_execute(program, entry, stack, nullptr, globals, point);
+}
+
+std::string Interpreter::disassemble() const
+{
+	using namespace detail;
+
+	std::string result;
+	for (auto &function : program.functions) {
+		result += fmt::format("{} (frame: {} bytes, constants at {})\n",
+			function.name, function.frame, function.base);
+
+		for (size_t i = 0; i < function.code.size(); i++) {
+			auto &instruction = function.code[i];
+			result += fmt::format("  {:4}: {:<12} dst={} a={} b={} c={} count={}\n",
+				i, tbl_interpreter_opcode[instruction.code],
+				instruction.dst, instruction.a, instruction.b,
+				instruction.c, instruction.count);
+		}
+	}
+
+	return result;
+}
+
+} // namespace jvl::thunder
@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "thunder/interpreter.hpp"
+
+namespace jvl::thunder::detail {
+
+// Frames are untyped, so values are moved in and out with memcpy
+template <typename T>
+static inline T read(const std::byte *ptr)
+{
+	T value;
+	std::memcpy(&value, ptr, sizeof(T));
+	return value;
+}
+
+template <typename T>
+static inline void write(std::byte *ptr, const T &value)
+{
+	std::memcpy(ptr, &value, sizeof(T));
+}
+
+// Dispatch is threaded through the handler addresses of the instructions
+// (computed goto); called without a program, returns the handler table
+[[gnu::noinline, gnu::noclone]]
+static const void *const *run(const interpreter_program *program,
+			      uint32_t index,
+			      std::byte *frame,
+			      void *result,
+			      void *const *globals,
+			      uint32_t *resume)
+{
+	static const void *const handlers[] = {
+#define JVL_INTERPRETER_LABEL(name) &&label_##name,
+		JVL_INTERPRETER_OPCODES(JVL_INTERPRETER_LABEL)
+#undef JVL_INTERPRETER_LABEL
+	};
+
+	static_assert(sizeof(handlers) / sizeof(handlers[0]) == __op_end);
+
+	if (!program)
+		return handlers;
+
+	auto &function = program->functions[index];
+
+	// Suspended invocations keep their frames
+	if (!*resume) {
+		std::memcpy(frame + function.base, function.image.data(), function.image.size());
+		for (auto &binding : function.bindings)
+			write(frame + binding.slot, globals[binding.global]);
+	}
+
+	const interpreter_instruction *const code = function.code.data();
+	const interpreter_instruction *ip = code + *resume;
+
+#define DISPATCH()	goto *ip->handler
+#define NEXT()		do { ip++; DISPATCH(); } while (0)
+
+#define A(T, k)		read <T> (frame + ip->a + (k) * sizeof(T))
+#define B(T, k)		read <T> (frame + ip->b + (k) * sizeof(T))
+#define C(T, k)		read <T> (frame + ip->c + (k) * sizeof(T))
+#define D(T, k, v)	write <T> (frame + ip->dst + (k) * sizeof(T), (v))
+
+#define UNARY(name, T, expr)					\
+	label_##name:						\
+	for (uint32_t k = 0; k < ip->count; k++) {		\
+		T x = A(T, k);					\
+		D(T, k, T(expr));				\
+	}							\
+	NEXT();
+
+#define BINARY(name, T, expr)					\
+	label_##name:						\
+	for (uint32_t k = 0; k < ip->count; k++) {		\
+		T x = A(T, k);					\
+		T y = B(T, k);					\
+		D(T, k, T(expr));				\
+	}							\
+	NEXT();
+
+#define TERNARY(name, T, expr)					\
+	label_##name:						\
+	for (uint32_t k = 0; k < ip->count; k++) {		\
+		T x = A(T, k);					\
+		T y = B(T, k);					\
+		T z = C(T, k);					\
+		D(T, k, T(expr));				\
+	}							\
+	NEXT();
+
+#define CONVERT(name, S, T)					\
+	label_##name:						\
+	for (uint32_t k = 0; k < ip->count; k++)		\
+		D(T, k, T(A(S, k)));				\
+	NEXT();
+
+#define COMPARE(name, T, expr, all)				\
+	label_##name:						\
+	{							\
+		bool result = true;				\
+		for (uint32_t k = 0; k < ip->count; k++) {	\
+			T x = A(T, k);				\
+			T y = B(T, k);				\
+			result &= bool(expr);			\
+		}						\
+		D(uint32_t, 0, uint32_t(result == all));	\
+	}							\
+	NEXT();
+
+	DISPATCH();
+
+	// Moving data
+label_copy:
+	std::memmove(frame + ip->dst, frame + ip->a, ip->c);
+	NEXT();
+
+label_zero:
+	std::memset(frame + ip->dst, 0, ip->c);
+	NEXT();
+
+label_splat32:
+	{
+		uint32_t value = A(uint32_t, 0);
+		for (uint32_t k = 0; k < ip->count; k++)
+			D(uint32_t, k, value);
+	}
+	NEXT();
+
+label_splat64:
+	{
+		uint64_t value = A(uint64_t, 0);
+		for (uint32_t k = 0; k < ip->count; k++)
+			D(uint64_t, k, value);
+	}
+	NEXT();
+
+	// Pointers and memory
+label_address:
+	D(std::byte *, 0, frame + ip->a);
+	NEXT();
+
+label_index:
+	D(std::byte *, 0, A(std::byte *, 0) + size_t(B(uint32_t, 0)) * ip->c);
+	NEXT();
+
+label_load:
+	std::memcpy(frame + ip->dst, read <std::byte *> (frame + ip->a) + ip->b, ip->c);
+	NEXT();
+
+label_store:
+	std::memcpy(read <std::byte *> (frame + ip->dst) + ip->b, frame + ip->a, ip->c);
+	NEXT();
+
+	// Control flow
+label_jump:
+	ip = code + ip->a;
+	DISPATCH();
+
+label_unless:
+	if (!A(uint32_t, 0)) {
+		ip = code + ip->b;
+		DISPATCH();
+	}
+
+	NEXT();
+
+label_call:
+	{
+		auto &call = program->calls[ip->a];
+
+		std::byte *inner = frame + interpreter_frame_size(function);
+		for (auto &argument : call.arguments)
+			std::memcpy(inner + argument.callee, frame + argument.caller, argument.size);
+
+		// Callees are free of barriers, see Interpreter
+		uint32_t nested = 0;
+		run(program, call.function, inner, frame + ip->dst, globals, &nested);
+
+		for (auto &argument : call.arguments) {
+			if (argument.writeback)
+				std::memcpy(frame + argument.caller, inner + argument.callee, argument.size);
+		}
+	}
+	NEXT();
+
+label_ret:
+	if (ip->c)
+		std::memcpy(result, frame + ip->a, ip->c);
+
+	*resume = 0;
+	return nullptr;
+
+label_barrier:
+	*resume = uint32_t(ip - code) + 1;
+	return nullptr;
+
+	// Conversions
+	CONVERT(f32_to_i32, float, int32_t)
+	CONVERT(f32_to_u32, float, uint32_t)
+	CONVERT(i32_to_f32, int32_t, float)
+	CONVERT(u32_to_f32, uint32_t, float)
+	CONVERT(i32_to_u64, int32_t, uint64_t)
+	CONVERT(u32_to_u64, uint32_t, uint64_t)
+	CONVERT(u64_to_u32, uint64_t, uint32_t)
+	CONVERT(f32_to_u64, float, uint64_t)
+	CONVERT(u64_to_f32, uint64_t, float)
+
+	// Arithmetic; signed integers wrap around like the unsigned ones
+	BINARY(add_u32, uint32_t, x + y)
+	BINARY(sub_u32, uint32_t, x - y)
+	BINARY(mul_u32, uint32_t, x * y)
+	UNARY(neg_u32, uint32_t, 0u - x)
+
+	BINARY(add_u64, uint64_t, x + y)
+	BINARY(sub_u64, uint64_t, x - y)
+	BINARY(mul_u64, uint64_t, x * y)
+	UNARY(neg_u64, uint64_t, uint64_t(0) - x)
+
+	BINARY(add_f32, float, x + y)
+	BINARY(sub_f32, float, x - y)
+	BINARY(mul_f32, float, x * y)
+	UNARY(neg_f32, float, -x)
+
+	// Integer division by zero is undefined rather than a fault
+	BINARY(div_i32, int32_t, (y == 0) ? 0 : ((y == -1) ? int32_t(0u - uint32_t(x)) : x / y))
+	BINARY(div_u32, uint32_t, y ? x / y : 0u)
+	BINARY(div_u64, uint64_t, y ? x / y : uint64_t(0))
+	BINARY(div_f32, float, x / y)
+
+	BINARY(mod_i32, int32_t, (y == 0 || y == -1) ? 0 : x % y)
+	BINARY(mod_u32, uint32_t, y ? x % y : 0u)
+	BINARY(mod_u64, uint64_t, y ? x % y : uint64_t(0))
+	BINARY(mod_f32, float, x - y * std::floor(x / y))
+
+	// Bitwise and logical operations
+	BINARY(and_u32, uint32_t, x & y)
+	BINARY(or_u32, uint32_t, x | y)
+	BINARY(xor_u32, uint32_t, x ^ y)
+	UNARY(not_bool, uint32_t, x ^ 1u)
+
+	BINARY(and_u64, uint64_t, x & y)
+	BINARY(or_u64, uint64_t, x | y)
+	BINARY(xor_u64, uint64_t, x ^ y)
+
+	BINARY(shl_u32, uint32_t, x << (y & 31))
+	BINARY(shr_i32, int32_t, x >> (y & 31))
+	BINARY(shr_u32, uint32_t, x >> (y & 31))
+	BINARY(shl_u64, uint64_t, x << (y & 63))
+	BINARY(shr_u64, uint64_t, x >> (y & 63))
+
+	// Comparisons
+	COMPARE(eq_u32, uint32_t, x == y, true)
+	COMPARE(eq_u64, uint64_t, x == y, true)
+	COMPARE(eq_f32, float, x == y, true)
+
+	COMPARE(ne_u32, uint32_t, x == y, false)
+	COMPARE(ne_u64, uint64_t, x == y, false)
+	COMPARE(ne_f32, float, x == y, false)
+
+	COMPARE(lt_i32, int32_t, x < y, true)
+	COMPARE(lt_u32, uint32_t, x < y, true)
+	COMPARE(lt_u64, uint64_t, x < y, true)
+	COMPARE(lt_f32, float, x < y, true)
+
+	COMPARE(le_i32, int32_t, x <= y, true)
+	COMPARE(le_u32, uint32_t, x <= y, true)
+	COMPARE(le_u64, uint64_t, x <= y, true)
+	COMPARE(le_f32, float, x <= y, true)
+
+	// Component-wise intrinsics
+	UNARY(abs_i32, int32_t, x < 0 ? int32_t(0u - uint32_t(x)) : x)
+	UNARY(abs_f32, float, std::fabs(x))
+
+	BINARY(min_i32, int32_t, std::min(x, y))
+	BINARY(min_u32, uint32_t, std::min(x, y))
+	BINARY(min_f32, float, y < x ? y : x)
+
+	BINARY(max_i32, int32_t, std::max(x, y))
+	BINARY(max_u32, uint32_t, std::max(x, y))
+	BINARY(max_f32, float, x < y ? y : x)
+
+	TERNARY(clamp_i32, int32_t, std::min(std::max(x, y), z))
+	TERNARY(clamp_u32, uint32_t, std::min(std::max(x, y), z))
+	TERNARY(clamp_f32, float, std::min(std::max(x, y), z))
+
+	UNARY(sin, float, std::sin(x))
+	UNARY(cos, float, std::cos(x))
+	UNARY(tan, float, std::tan(x))
+	UNARY(asin, float, std::asin(x))
+	UNARY(acos, float, std::acos(x))
+	UNARY(atan, float, std::atan(x))
+	UNARY(sinh, float, std::sinh(x))
+	UNARY(cosh, float, std::cosh(x))
+	UNARY(tanh, float, std::tanh(x))
+	UNARY(sqrt, float, std::sqrt(x))
+	UNARY(exp, float, std::exp(x))
+	UNARY(log, float, std::log(x))
+	UNARY(floor, float, std::floor(x))
+	UNARY(ceil, float, std::ceil(x))
+	UNARY(fract, float, x - std::floor(x))
+
+	BINARY(pow, float, std::pow(x, y))
+	BINARY(atan2, float, std::atan2(x, y))
+	TERNARY(mix, float, x * (1.0f - z) + y * z)
+
+label_smoothstep:
+	for (uint32_t k = 0; k < ip->count; k++) {
+		float t = (C(float, k) - A(float, k)) / (B(float, k) - A(float, k));
+		t = std::clamp(t, 0.0f, 1.0f);
+		D(float, k, t * t * (3.0f - 2.0f * t));
+	}
+	NEXT();
+
+	// Geometric intrinsics
+label_dot:
+	{
+		float sum = 0.0f;
+		for (uint32_t k = 0; k < ip->count; k++)
+			sum += A(float, k) * B(float, k);
+
+		D(float, 0, sum);
+	}
+	NEXT();
+
+label_length:
+	{
+		float sum = 0.0f;
+		for (uint32_t k = 0; k < ip->count; k++)
+			sum += A(float, k) * A(float, k);
+
+		D(float, 0, std::sqrt(sum));
+	}
+	NEXT();
+
+label_normalize:
+	{
+		float sum = 0.0f;
+		for (uint32_t k = 0; k < ip->count; k++)
+			sum += A(float, k) * A(float, k);
+
+		float inverse = 1.0f / std::sqrt(sum);
+		for (uint32_t k = 0; k < ip->count; k++)
+			D(float, k, A(float, k) * inverse);
+	}
+	NEXT();
+
+label_cross:
+	{
+		float x[3] = { A(float, 0), A(float, 1), A(float, 2) };
+		float y[3] = { B(float, 0), B(float, 1), B(float, 2) };
+
+		D(float, 0, x[1] * y[2] - x[2] * y[1]);
+		D(float, 1, x[2] * y[0] - x[0] * y[2]);
+		D(float, 2, x[0] * y[1] - x[1] * y[0]);
+	}
+	NEXT();
+
+label_reflect:
+	{
+		float d = 0.0f;
+		for (uint32_t k = 0; k < ip->count; k++)
+			d += A(float, k) * B(float, k);
+
+		for (uint32_t k = 0; k < ip->count; k++)
+			D(float, k, A(float, k) - 2.0f * d * B(float, k));
+	}
+	NEXT();
+
+	// Matrix products, see interpreter_matrix_shape
+label_matmul:
+	{
+		uint32_t rows = ip->count & 0xf;
+		uint32_t inner = (ip->count >> 4) & 0xf;
+		uint32_t columns = (ip->count >> 8) & 0xf;
+
+		uint32_t sa = ip->c & 0xff;
+		uint32_t sb = (ip->c >> 8) & 0xff;
+		uint32_t sd = (ip->c >> 16) & 0xff;
+
+		for (uint32_t j = 0; j < columns; j++) {
+			for (uint32_t i = 0; i < rows; i++) {
+				float sum = 0.0f;
+				for (uint32_t p = 0; p < inner; p++) {
+					float x = read <float> (frame + ip->a + p * sa + 4 * i);
+					float y = read <float> (frame + ip->b + j * sb + 4 * p);
+					sum += x * y;
+				}
+
+				write <float> (frame + ip->dst + j * sd + 4 * i, sum);
+			}
+		}
+	}
+	NEXT();
+
+#undef DISPATCH
+#undef NEXT
+#undef A
+#undef B
+#undef C
+#undef D
+#undef UNARY
+#undef BINARY
+#undef TERNARY
+#undef CONVERT
+#undef COMPARE
+}
+
+const void *const *interpreter_handlers()
+{
+	return run(nullptr, 0, nullptr, nullptr, nullptr, nullptr);
+}
+
+uint32_t interpreter_execute(const interpreter_program &program,
+			     uint32_t index,
+			     std::byte *frame,
+			     void *result,
+			     void *const *globals,
+			     uint32_t resume)
+{
+	run(&program, index, frame, result, globals, &resume);
+	return resume;
+}
+
+} // namespace jvl::thunder::detail
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "common/logging.hpp"
 
 #include "ire/emitter.hpp"
@@ -38,6 +40,37 @@ PrimitiveType primitive_type_of(const Buffer &buffer, Index i)
 	JVL_ABORT("unhandled case in primitive_type_of: {}", qt);
 }
 
+// Vectors which map to native vector types, with lanes of the same
+// type; two and four components match the layout of solid_t
+bool legalize_for_cc_native_vector(PrimitiveType type)
+{
+	size_t ccount = vector_component_count(type);
+	return vector_type(type) && (ccount == 2 || ccount == 4);
+}
+
+// Overloads on native vectors are kept if every operand is either a
+// vector of the same type or a scalar of its component type; gives
+// the vector type in that case, and bad otherwise
+PrimitiveType legalize_for_cc_native_overload(const std::vector <PrimitiveType> &types)
+{
+	PrimitiveType vector = bad;
+	for (auto type : types) {
+		if (vector_type(type))
+			vector = type;
+	}
+
+	if (!legalize_for_cc_native_vector(vector))
+		return bad;
+
+	PrimitiveType component = swizzle_type_of(vector, SwizzleCode::x);
+	for (auto type : types) {
+		if (type != vector && type != component)
+			return bad;
+	}
+
+	return vector;
+}
+
 void legalize_for_cc_operation_vector_overload(mapped_instruction_t &mapped,
 					       OperationCode code,
 					       Index a,
@@ -226,13 +259,15 @@ bool legalize_for_cc_intrinsic(mapped_instruction_t &mapped,
 }
 
 // TODO: legalization context...
-void legalize_for_cc(Buffer &buffer)
+void legalize_for_cc(Buffer &buffer, LegalizationFlags flags)
 {
 	JVL_STAGE();
 
 	auto &em = ire::Emitter::active;
 	auto &atoms = buffer.atoms;
 
+	bool native = has(flags, LegalizationFlags::eNativeVectors);
+
 	std::vector <mapped_instruction_t> mapped(buffer.pointer);
 
 	for (size_t i = 0; i < mapped.size(); i++) {
@@ -269,7 +304,12 @@ void legalize_for_cc(Buffer &buffer)
 				types.push_back(ptype);
 			}
 
-			if (vector_type(types[0]) || vector_type(types[1])) {
+			// Arithmetic on native vectors is left to the target
+			bool vectorized = std::ranges::any_of(types, vector_type);
+			if (native && legalize_for_cc_native_overload(types) == primitive_type_of(buffer, i))
+				vectorized = false;
+
+			if (vectorized) {
 				transformed = true;
 				legalize_for_cc_operation_vector_overload(mapped[i],
 					operation->code,
@@ -292,7 +332,13 @@ void legalize_for_cc(Buffer &buffer)
 					types.push_back(ptype);
 				}
 
-				if (types.size() == 1) {
+				// Native vectors can be filled from a single scalar
+				bool splat = native
+					&& legalize_for_cc_native_vector(ptype)
+					&& types.size() == 1
+					&& !vector_type(types[0]);
+
+				if (types.size() == 1 && !splat) {
 					if (legalize_for_cc_vector_constructor(mapped[i], ptype, args, types))
 						transformed = true;
 				}
@@ -309,7 +355,12 @@ void legalize_for_cc(Buffer &buffer)
 				types.push_back(ptype);
 			}
 
-			if (legalize_for_cc_intrinsic(mapped[i], intrinsic->opn, args, types))
+			// Dot products of native vectors are reduced by the target
+			bool reduced = native
+				&& intrinsic->opn == dot
+				&& legalize_for_cc_native_overload(types) != bad;
+
+			if (!reduced && legalize_for_cc_intrinsic(mapped[i], intrinsic->opn, args, types))
 				transformed = true;
 		}
 
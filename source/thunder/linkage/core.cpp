@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include "common/hash.hpp"
 #include "common/logging.hpp"
 
 #include "thunder/enumerations.hpp"
@@ -35,8 +36,8 @@ bool Aggregate::operator==(const Aggregate &other) const
 }
 
 // Functions
-Function::Function(const Buffer &buffer, const std::string &name_, size_t cid_)
-		: Buffer(buffer), cid(cid_), name(name_) {}
+Function::Function(const Snapshot &snapshot_, size_t cid_)
+		: BufferView(*snapshot_), snapshot(snapshot_), cid(cid_), name(snapshot_->name) {}
 
 // Linkage unit methods
 Index LinkageUnit::new_aggregate(size_t ftn, bool phantom, const std::string &name, const std::vector <Field> &fields)
@@ -336,14 +337,14 @@ void LinkageUnit::process_function_aggregate(TypeMap &map, const Function &funct
 }
 
 // TODO: check for duplicate names... shouldnt exist in linkage unit
-LinkageUnit::function_result_t LinkageUnit::process_function(const Function &ftn)
+LinkageUnit::function_result_t LinkageUnit::process_function(Function &&ftn)
 {
 	std::set <Index> referenced;
 
 	// TODO: run validation here as well
 	Index fidx = functions.size();
 
-	functions.emplace_back(ftn);
+	functions.emplace_back(std::move(ftn));
 	types.emplace_back();
 
 	auto &function = functions.back();
@@ -390,8 +391,8 @@ LinkageUnit::function_result_t LinkageUnit::process_function(const Function &ftn
 
 	// Gather extensions from instructions
 	// TODO: enums for extensions/capabilities/features
-	for (size_t i = 0; i < ftn.pointer; i++) {
-		auto &atom = ftn.atoms[i];
+	for (size_t i = 0; i < function.pointer; i++) {
+		auto &atom = function.atoms[i];
 
 		// From intrinsics...
 		// TODO: methods?
@@ -430,25 +431,23 @@ LinkageUnit::function_result_t LinkageUnit::process_function(const Function &ftn
 	return std::make_pair(fidx, referenced);
 }
 
-Index LinkageUnit::add(uint32_t cid, const NamedBuffer &callable)
+Index LinkageUnit::add(uint32_t cid, const Snapshot &callable)
 {
 	if (loaded.contains(cid))
 		return loaded[cid];
 
-	Function converted {
-		callable,
-		callable.name,
-		cid
-	};
-
-	auto [fidx, referenced] = process_function(converted);
+	// Shares the contents of the callable, which code generators view
+	auto [fidx, referenced] = process_function(Function(callable, cid));
 
 	loaded[cid] = fidx;
 
 	std::set <Index> translated;
 	for (Index i : referenced) {
-		Index j = add(i, TrackedBuffer::cache_load(i));
-		translated.insert(j);
+		auto it = substitutes.find(i);
+		if (it != substitutes.end())
+			translated.insert(add(i, it->second));
+		else
+			translated.insert(add(i, TrackedBuffer::cache_load(i)));
 	}
 
 	// Mark the dependencies
@@ -459,7 +458,7 @@ Index LinkageUnit::add(uint32_t cid, const NamedBuffer &callable)
 
 Index LinkageUnit::add(const TrackedBuffer &callable)
 {
-	return add(callable.cid, callable);
+	return add(callable.cid, callable.snapshot);
 }
 
 // Translating target stages into Vulkan counterparts
@@ -509,7 +508,7 @@ vk::ShaderStageFlagBits to_vulkan(Stage stage)
 	JVL_ABORT("unsupported stage {}", tbl_stage[(int) stage]);
 }
 
-GeneratedResult LinkageUnit::generate(const Target &target, const Stage &stage) const
+GeneratedResult LinkageUnit::generate(const Target &target, const Stage &stage, const JitOptions &options) const
 {
 	static constexpr const char *tbl_targets[] {
 		"glsl",
@@ -520,6 +519,7 @@ GeneratedResult LinkageUnit::generate(const Target &target, const Stage &stage)
 		"spirv (assembly)",
 		"spirv (binary)",
 		"spirv (binary via glsl)",
+		"jit (gcc)",
 	};
 
 	switch (target) {
@@ -527,8 +527,14 @@ GeneratedResult LinkageUnit::generate(const Target &target, const Stage &stage)
 		return generate_glsl();
 	case Target::cplusplus:
 		return generate_cpp();
+	case Target::spirv_assembly:
+		return generate_spirv_assembly(to_vulkan(stage));
+	case Target::spirv_binary:
+		return generate_spirv(to_vulkan(stage));
 	case Target::spirv_binary_via_glsl:
 		return generate_spirv_via_glsl(to_vulkan(stage));
+	case Target::jit_gcc:
+		return generate_jit_gcc(options);
 	default:
 		break;
 	}
@@ -536,6 +542,86 @@ GeneratedResult LinkageUnit::generate(const Target &target, const Stage &stage)
 	JVL_ABORT("generation target {} is currently unsupported", tbl_targets[(int) target]);
 }
 
+// Field types of a structure, expanded through nested structures
+static void hash_layout(Hasher &hasher, const Function &ftn, const QualifiedType &qt)
+{
+	auto plain = qt.get <PlainDataType> ();
+	if (plain && plain->is <Index> ())
+		return hash_layout(hasher, ftn, ftn.types[plain->as <Index> ()]);
+
+	QualifiedType current = qt;
+	while (auto field = current.get <StructFieldType> ()) {
+		auto base = field->base();
+		Index next = field->next;
+
+		if (base.is <Index> ())
+			hash_layout(hasher, ftn, ftn.types[base.as <Index> ()]);
+		else
+			hasher << base.as <PrimitiveType> ();
+
+		current = ftn.types[next];
+	}
+
+	hasher << current.to_string();
+}
+
+// Content hash of the linked functions, for keying persistent caches
+uint64_t LinkageUnit::hash() const
+{
+	Hasher hasher;
+
+	// Callees are identified by their position in the unit rather than
+	// their global ids, which depend on the order of emission
+	auto local = [&](const Atom &atom) {
+		auto call = atom.get <Call> ();
+		if (!call || !loaded.contains(call->cid))
+			return atom.hash();
+
+		Call relative = atom.as <Call> ();
+		relative.cid = loaded.at(call->cid);
+		return Atom(relative).hash();
+	};
+
+	hasher << functions.size();
+	for (auto &ftn : functions) {
+		hasher << ftn.name << ftn.pointer;
+		for (size_t i = 0; i < ftn.pointer; i++)
+			hasher << local(ftn.atoms[i]);
+
+		auto &decorations = ftn.decorations;
+
+		// Structures are keyed by their layouts, as the ids
+		// of type hints are only unique within a process
+		hasher << decorations.type.size();
+		for (auto &[i, hint] : decorations.type) {
+			hasher << i << hint.name << hint.fields.size();
+			for (auto &field : hint.fields)
+				hasher << field;
+
+			hash_layout(hasher, ftn, ftn.types[i]);
+		}
+
+		hasher << decorations.phantom.size();
+		for (auto i : decorations.phantom)
+			hasher << i;
+
+		hasher << decorations.materialize.size();
+		for (auto i : decorations.materialize)
+			hasher << i;
+	}
+
+	hasher << aggregates.size();
+	for (auto &aggregate : aggregates) {
+		hasher << aggregate.function << aggregate.phantom << aggregate.name;
+		for (auto &field : aggregate.fields) {
+			hasher << field.name;
+			hash_layout(hasher, functions[aggregate.function], field);
+		}
+	}
+
+	return hasher.value();
+}
+
 // Serialization
 void LinkageUnit::write(const std::filesystem::path &path) const
 {
@@ -558,7 +644,7 @@ void LinkageUnit::write(const std::filesystem::path &path) const
 
 	for (auto &ftn : functions) {
 		write_string(ftn.name);
-		ftn.write(file);
+		ftn.snapshot->write(file);
 	}
 
 	file.close();
@@ -574,7 +660,7 @@ void LinkageUnit::write_assembly(const std::filesystem::path &path) const
 
 	for (auto &ftn : functions) {
 		file << ftn.name << '.' << ftn.cid << ":\n";
-		file << ftn.to_string_assembly() << '\n';
+		file << ftn.snapshot->to_string_assembly() << '\n';
 	}
 
 	return file.close();
@@ -122,7 +122,7 @@ auto used_primitives(const std::vector <Function> &functions)
 {
 	std::set <PrimitiveType> used_primitives;
 	for (auto &function : functions) {
-		for (auto &qt : function.types) {
+		for (auto &qt : function.types.interned()) {
 			if (!qt.is <PlainDataType> ())
 				continue;
 
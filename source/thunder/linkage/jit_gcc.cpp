@@ -1,6 +1,14 @@
+#include <atomic>
+#include <fstream>
+
 // Native JIT libraries
+#include <dlfcn.h>
+#include <unistd.h>
+
 #include <libgccjit.h>
 
+#include "common/hash.hpp"
+
 #include "thunder/gcc_jit_generator.hpp"
 #include "thunder/linkage_unit.hpp"
 
@@ -12,28 +20,166 @@ MODULE(linkage-unit);
 // Generation: JIT compilation with GCC //
 //////////////////////////////////////////
 
-void *LinkageUnit::generate_jit_gcc() const
+// Revised whenever the generated code changes for the same linked IR
+static constexpr uint64_t jit_cache_version = 2;
+
+// Description of the host processor, which -march=native builds
+// depend on; empty if it cannot be determined
+const std::string &jit_host_cpu()
+{
+	static const std::string cpu = []() {
+		static constexpr const char *keys[] {
+			"model name",
+			"flags",
+			"Features",
+			"CPU implementer",
+			"CPU part",
+		};
+
+		std::map <std::string, std::string> found;
+
+		std::ifstream file("/proc/cpuinfo");
+
+		std::string line;
+		while (std::getline(file, line)) {
+			for (auto key : keys) {
+				if (line.starts_with(key) && !found.contains(key))
+					found[key] = line;
+			}
+		}
+
+		std::string result;
+		for (auto &[key, line] : found)
+			result += line + "\n";
+
+		return result;
+	}();
+
+	return cpu;
+}
+
+std::filesystem::path jit_cache_entry(const LinkageUnit &unit, const JitOptions &options)
+{
+	Hasher hasher;
+
+	hasher << jit_cache_version << unit.hash();
+	hasher << options.optimization << options.debug_info << options.native;
+
+	// Native builds are only valid on the same kind of processor
+	if (options.native)
+		hasher << jit_host_cpu();
+
+	hasher << options.driver.size();
+	for (auto &option : options.driver)
+		hasher << option;
+
+	return options.cache / fmt::format("{:016x}.so", hasher.value());
+}
+
+void *jit_cache_load(const std::filesystem::path &path)
 {
+	void *library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!library) {
+		JVL_WARNING("failed to open cached shared object '{}': {}", path.string(), dlerror());
+		return nullptr;
+	}
+
+	void *ftn = dlsym(library, "function");
+	if (!ftn) {
+		JVL_WARNING("cached shared object '{}' is missing the compiled function", path.string());
+		dlclose(library);
+	}
+
+	return ftn;
+}
+
+void *LinkageUnit::generate_jit_gcc(const JitOptions &options) const
+{
+	// Native builds skip the cache unless the host can be identified
+	bool cached = !options.cache.empty()
+		&& !(options.native && jit_host_cpu().empty());
+
+	std::filesystem::path entry;
+	if (cached) {
+		entry = jit_cache_entry(*this, options);
+
+		if (std::filesystem::exists(entry)) {
+			if (void *ftn = jit_cache_load(entry)) {
+				JVL_INFO("loaded JIT-ed linkage unit from cache ({})", entry.string());
+				return ftn;
+			}
+		}
+	}
+
 	JVL_INFO("compiling linkage atoms with gcc jit");
 
 	gcc_jit_context *context = gcc_jit_context_acquire();
 	JVL_ASSERT(context, "failed to acquire context");
 
-	// TODO: pass options
-	gcc_jit_context_set_int_option(context, GCC_JIT_INT_OPTION_OPTIMIZATION_LEVEL, 0);
-	gcc_jit_context_set_bool_option(context, GCC_JIT_BOOL_OPTION_DEBUGINFO, true);
+	JVL_ASSERT(options.optimization >= 0 && options.optimization <= 3,
+		"invalid optimization level for gcc jit: {}", options.optimization);
+
+	gcc_jit_context_set_int_option(context, GCC_JIT_INT_OPTION_OPTIMIZATION_LEVEL, options.optimization);
+	gcc_jit_context_set_bool_option(context, GCC_JIT_BOOL_OPTION_DEBUGINFO, options.debug_info);
 	// gcc_jit_context_set_bool_option(context, GCC_JIT_BOOL_OPTION_DUMP_INITIAL_GIMPLE, true);
 	// gcc_jit_context_set_bool_option(context, GCC_JIT_BOOL_OPTION_DUMP_INITIAL_TREE, true);
 	// gcc_jit_context_set_bool_option(context, GCC_JIT_BOOL_OPTION_DUMP_SUMMARY, true);
 	// gcc_jit_context_set_bool_option(context, GCC_JIT_BOOL_OPTION_DUMP_GENERATED_CODE, true);
 
+	if (options.native)
+		gcc_jit_context_add_command_line_option(context, "-march=native");
+
+	for (auto &option : options.driver)
+		gcc_jit_context_add_driver_option(context, option.c_str());
+
 	for (auto &function : functions) {
 		// detail::unnamed_body_t body(block);
 		detail::gcc_jit_function_generator_t generator(context, function);
 		generator.generate();
 	}
 
-	gcc_jit_context_dump_to_file(context, "gcc_jit_result.c", true);
+	if (!options.dump.empty())
+		gcc_jit_context_dump_to_file(context, options.dump.c_str(), true);
+
+	// Shared objects are written under a temporary name and then
+	// renamed, so that concurrent compilations (in this process or
+	// others) never load or overwrite each other's partial files
+	if (!entry.empty()) {
+		static std::atomic <size_t> sequence = 0;
+
+		std::error_code error;
+		std::filesystem::create_directories(options.cache, error);
+
+		auto partial = entry;
+		partial += fmt::format(".{}.{}.tmp", getpid(), sequence++);
+
+		gcc_jit_context_compile_to_file(context,
+			GCC_JIT_OUTPUT_KIND_DYNAMIC_LIBRARY,
+			partial.c_str());
+
+		const char *first = gcc_jit_context_get_first_error(context);
+		std::string message = first ? first : "";
+		if (message.empty())
+			std::filesystem::rename(partial, entry, error);
+
+		gcc_jit_context_release(context);
+
+		// Failed writes leave nothing behind in the cache
+		if (!message.empty() || error) {
+			std::error_code ignored;
+			std::filesystem::remove(partial, ignored);
+		}
+
+		JVL_ASSERT(message.empty(), "failed to compile function: {}", message);
+		JVL_ASSERT(!error, "failed to write cache entry '{}': {}", entry.string(), error.message());
+
+		void *ftn = jit_cache_load(entry);
+		JVL_ASSERT(ftn, "failed to load function result");
+
+		JVL_INFO("successfully JIT-ed linkage unit (cached as {})", entry.string());
+
+		return ftn;
+	}
 
 	gcc_jit_result *result = gcc_jit_context_compile(context);
 	JVL_ASSERT(result, "failed to compile function");
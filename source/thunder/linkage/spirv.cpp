@@ -0,0 +1,376 @@
+#include "common/logging.hpp"
+
+#include "thunder/linkage_unit.hpp"
+#include "thunder/spirv_generator.hpp"
+
+namespace jvl::thunder {
+
+MODULE(linkage-unit);
+
+/////////////////////////////////////////
+// Generation: SPIRV binary (directly) //
+/////////////////////////////////////////
+
+static uint32_t execution_model(const vk::ShaderStageFlagBits &stage)
+{
+	switch (stage) {
+	case vk::ShaderStageFlagBits::eVertex:
+		return 0;
+	case vk::ShaderStageFlagBits::eFragment:
+		return 4;
+	case vk::ShaderStageFlagBits::eCompute:
+		return 5;
+	default:
+		break;
+	}
+
+	JVL_ABORT("shader stage {} is unsupported by the SPIR-V backend", vk::to_string(stage));
+}
+
+BinaryResult LinkageUnit::generate_spirv(const vk::ShaderStageFlagBits &flags) const
+{
+	using namespace detail;
+
+	spirv_module_t module(*this);
+
+	std::optional <uint32_t> entry;
+	for (size_t i = 0; i < functions.size(); i++) {
+		auto &function = functions[i];
+
+		spirv_function_generator_t generator(module, i);
+		generator.generate();
+
+		if (function.name == "main")
+			entry = module.functions[i];
+	}
+
+	JVL_ASSERT(entry.has_value(), "no entry point (main) in the linkage unit");
+
+	uint32_t model = execution_model(flags);
+
+	std::vector <uint32_t> words { model, entry.value() };
+	for (auto word : module.literal("main"))
+		words.push_back(word);
+	for (auto id : module.interface)
+		words.push_back(id);
+
+	module.emit(module.entries, spv::OpEntryPoint, words);
+
+	if (flags == vk::ShaderStageFlagBits::eCompute) {
+		glm::uvec3 size = local_size.value_or(glm::uvec3(1, 1, 1));
+		module.emit(module.entries, spv::OpExecutionMode, { entry.value(), 17, size.x, size.y, size.z });
+	}
+
+	if (flags == vk::ShaderStageFlagBits::eFragment) {
+		module.emit(module.entries, spv::OpExecutionMode, { entry.value(), 7 });
+		if (module.depth_replacing)
+			module.emit(module.entries, spv::OpExecutionMode, { entry.value(), 12 });
+	}
+
+	return module.assemble();
+}
+
+SourceResult LinkageUnit::generate_spirv_assembly(const vk::ShaderStageFlagBits &flags) const
+{
+	return detail::spirv_disassemble(generate_spirv(flags));
+}
+
+namespace detail {
+
+// Operand formats for disassembly:
+//
+//   i: id, l: literal, s: string, I/L: remaining ids/literals
+//   c: capability, m: execution model, e: execution mode,
+//   t: storage class, d: decoration (remaining literals)
+struct spirv_instruction_info {
+	const char *name;
+	bool type;
+	bool result;
+	const char *operands;
+};
+
+static spirv_instruction_info instruction_info(uint16_t op)
+{
+	switch (op) {
+	case spv::OpName:			return { "OpName", false, false, "is" };
+	case spv::OpExtInstImport:		return { "OpExtInstImport", false, true, "s" };
+	case spv::OpExtInst:			return { "OpExtInst", true, true, "ilI" };
+	case spv::OpMemoryModel:		return { "OpMemoryModel", false, false, "ll" };
+	case spv::OpEntryPoint:			return { "OpEntryPoint", false, false, "misI" };
+	case spv::OpExecutionMode:		return { "OpExecutionMode", false, false, "ieL" };
+	case spv::OpCapability:			return { "OpCapability", false, false, "c" };
+	case spv::OpTypeVoid:			return { "OpTypeVoid", false, true, "" };
+	case spv::OpTypeBool:			return { "OpTypeBool", false, true, "" };
+	case spv::OpTypeInt:			return { "OpTypeInt", false, true, "ll" };
+	case spv::OpTypeFloat:			return { "OpTypeFloat", false, true, "l" };
+	case spv::OpTypeVector:			return { "OpTypeVector", false, true, "il" };
+	case spv::OpTypeMatrix:			return { "OpTypeMatrix", false, true, "il" };
+	case spv::OpTypeArray:			return { "OpTypeArray", false, true, "ii" };
+	case spv::OpTypeRuntimeArray:		return { "OpTypeRuntimeArray", false, true, "i" };
+	case spv::OpTypeStruct:			return { "OpTypeStruct", false, true, "I" };
+	case spv::OpTypePointer:		return { "OpTypePointer", false, true, "ti" };
+	case spv::OpTypeFunction:		return { "OpTypeFunction", false, true, "I" };
+	case spv::OpConstantTrue:		return { "OpConstantTrue", true, true, "" };
+	case spv::OpConstantFalse:		return { "OpConstantFalse", true, true, "" };
+	case spv::OpConstant:			return { "OpConstant", true, true, "L" };
+	case spv::OpConstantNull:		return { "OpConstantNull", true, true, "" };
+	case spv::OpFunction:			return { "OpFunction", true, true, "li" };
+	case spv::OpFunctionParameter:		return { "OpFunctionParameter", true, true, "" };
+	case spv::OpFunctionEnd:		return { "OpFunctionEnd", false, false, "" };
+	case spv::OpFunctionCall:		return { "OpFunctionCall", true, true, "I" };
+	case spv::OpVariable:			return { "OpVariable", true, true, "t" };
+	case spv::OpLoad:			return { "OpLoad", true, true, "i" };
+	case spv::OpStore:			return { "OpStore", false, false, "ii" };
+	case spv::OpAccessChain:		return { "OpAccessChain", true, true, "I" };
+	case spv::OpDecorate:			return { "OpDecorate", false, false, "id" };
+	case spv::OpMemberDecorate:		return { "OpMemberDecorate", false, false, "ild" };
+	case spv::OpVectorExtractDynamic:	return { "OpVectorExtractDynamic", true, true, "ii" };
+	case spv::OpVectorShuffle:		return { "OpVectorShuffle", true, true, "iiL" };
+	case spv::OpCompositeConstruct:		return { "OpCompositeConstruct", true, true, "I" };
+	case spv::OpCompositeExtract:		return { "OpCompositeExtract", true, true, "iL" };
+	case spv::OpConvertFToU:		return { "OpConvertFToU", true, true, "i" };
+	case spv::OpConvertFToS:		return { "OpConvertFToS", true, true, "i" };
+	case spv::OpConvertSToF:		return { "OpConvertSToF", true, true, "i" };
+	case spv::OpConvertUToF:		return { "OpConvertUToF", true, true, "i" };
+	case spv::OpUConvert:			return { "OpUConvert", true, true, "i" };
+	case spv::OpSConvert:			return { "OpSConvert", true, true, "i" };
+	case spv::OpBitcast:			return { "OpBitcast", true, true, "i" };
+	case spv::OpSNegate:			return { "OpSNegate", true, true, "i" };
+	case spv::OpFNegate:			return { "OpFNegate", true, true, "i" };
+	case spv::OpIAdd:			return { "OpIAdd", true, true, "ii" };
+	case spv::OpFAdd:			return { "OpFAdd", true, true, "ii" };
+	case spv::OpISub:			return { "OpISub", true, true, "ii" };
+	case spv::OpFSub:			return { "OpFSub", true, true, "ii" };
+	case spv::OpIMul:			return { "OpIMul", true, true, "ii" };
+	case spv::OpFMul:			return { "OpFMul", true, true, "ii" };
+	case spv::OpUDiv:			return { "OpUDiv", true, true, "ii" };
+	case spv::OpSDiv:			return { "OpSDiv", true, true, "ii" };
+	case spv::OpFDiv:			return { "OpFDiv", true, true, "ii" };
+	case spv::OpUMod:			return { "OpUMod", true, true, "ii" };
+	case spv::OpSMod:			return { "OpSMod", true, true, "ii" };
+	case spv::OpFMod:			return { "OpFMod", true, true, "ii" };
+	case spv::OpVectorTimesScalar:		return { "OpVectorTimesScalar", true, true, "ii" };
+	case spv::OpMatrixTimesScalar:		return { "OpMatrixTimesScalar", true, true, "ii" };
+	case spv::OpVectorTimesMatrix:		return { "OpVectorTimesMatrix", true, true, "ii" };
+	case spv::OpMatrixTimesVector:		return { "OpMatrixTimesVector", true, true, "ii" };
+	case spv::OpMatrixTimesMatrix:		return { "OpMatrixTimesMatrix", true, true, "ii" };
+	case spv::OpDot:			return { "OpDot", true, true, "ii" };
+	case spv::OpLogicalEqual:		return { "OpLogicalEqual", true, true, "ii" };
+	case spv::OpLogicalNotEqual:		return { "OpLogicalNotEqual", true, true, "ii" };
+	case spv::OpLogicalOr:			return { "OpLogicalOr", true, true, "ii" };
+	case spv::OpLogicalAnd:			return { "OpLogicalAnd", true, true, "ii" };
+	case spv::OpLogicalNot:			return { "OpLogicalNot", true, true, "i" };
+	case spv::OpSelect:			return { "OpSelect", true, true, "iii" };
+	case spv::OpIEqual:			return { "OpIEqual", true, true, "ii" };
+	case spv::OpINotEqual:			return { "OpINotEqual", true, true, "ii" };
+	case spv::OpUGreaterThan:		return { "OpUGreaterThan", true, true, "ii" };
+	case spv::OpSGreaterThan:		return { "OpSGreaterThan", true, true, "ii" };
+	case spv::OpUGreaterThanEqual:		return { "OpUGreaterThanEqual", true, true, "ii" };
+	case spv::OpSGreaterThanEqual:		return { "OpSGreaterThanEqual", true, true, "ii" };
+	case spv::OpULessThan:			return { "OpULessThan", true, true, "ii" };
+	case spv::OpSLessThan:			return { "OpSLessThan", true, true, "ii" };
+	case spv::OpULessThanEqual:		return { "OpULessThanEqual", true, true, "ii" };
+	case spv::OpSLessThanEqual:		return { "OpSLessThanEqual", true, true, "ii" };
+	case spv::OpFOrdEqual:			return { "OpFOrdEqual", true, true, "ii" };
+	case spv::OpFUnordNotEqual:		return { "OpFUnordNotEqual", true, true, "ii" };
+	case spv::OpFOrdLessThan:		return { "OpFOrdLessThan", true, true, "ii" };
+	case spv::OpFOrdGreaterThan:		return { "OpFOrdGreaterThan", true, true, "ii" };
+	case spv::OpFOrdLessThanEqual:		return { "OpFOrdLessThanEqual", true, true, "ii" };
+	case spv::OpFOrdGreaterThanEqual:	return { "OpFOrdGreaterThanEqual", true, true, "ii" };
+	case spv::OpShiftRightLogical:		return { "OpShiftRightLogical", true, true, "ii" };
+	case spv::OpShiftRightArithmetic:	return { "OpShiftRightArithmetic", true, true, "ii" };
+	case spv::OpShiftLeftLogical:		return { "OpShiftLeftLogical", true, true, "ii" };
+	case spv::OpBitwiseOr:			return { "OpBitwiseOr", true, true, "ii" };
+	case spv::OpBitwiseXor:			return { "OpBitwiseXor", true, true, "ii" };
+	case spv::OpBitwiseAnd:			return { "OpBitwiseAnd", true, true, "ii" };
+	case spv::OpDPdx:			return { "OpDPdx", true, true, "i" };
+	case spv::OpDPdy:			return { "OpDPdy", true, true, "i" };
+	case spv::OpDPdxFine:			return { "OpDPdxFine", true, true, "i" };
+	case spv::OpDPdyFine:			return { "OpDPdyFine", true, true, "i" };
+	case spv::OpControlBarrier:		return { "OpControlBarrier", false, false, "iii" };
+	case spv::OpLoopMerge:			return { "OpLoopMerge", false, false, "iiL" };
+	case spv::OpSelectionMerge:		return { "OpSelectionMerge", false, false, "iL" };
+	case spv::OpLabel:			return { "OpLabel", false, true, "" };
+	case spv::OpBranch:			return { "OpBranch", false, false, "i" };
+	case spv::OpBranchConditional:		return { "OpBranchConditional", false, false, "iiiL" };
+	case spv::OpKill:			return { "OpKill", false, false, "" };
+	case spv::OpReturn:			return { "OpReturn", false, false, "" };
+	case spv::OpReturnValue:		return { "OpReturnValue", false, false, "i" };
+	case spv::OpUnreachable:		return { "OpUnreachable", false, false, "" };
+	case spv::OpCopyLogical:		return { "OpCopyLogical", true, true, "i" };
+	default:
+		break;
+	}
+
+	return { nullptr, false, false, "L" };
+}
+
+static std::string enumerant(char kind, uint32_t value)
+{
+	switch (kind) {
+	case 'c':
+	{
+		switch (value) {
+		case spv::Matrix: return "Matrix";
+		case spv::Shader: return "Shader";
+		case spv::Int64: return "Int64";
+		case spv::DerivativeControl: return "DerivativeControl";
+		case spv::GroupNonUniform: return "GroupNonUniform";
+		}
+	} break;
+
+	case 'm':
+	{
+		switch (value) {
+		case 0: return "Vertex";
+		case 4: return "Fragment";
+		case 5: return "GLCompute";
+		}
+	} break;
+
+	case 'e':
+	{
+		switch (value) {
+		case 7: return "OriginUpperLeft";
+		case 12: return "DepthReplacing";
+		case 17: return "LocalSize";
+		}
+	} break;
+
+	case 't':
+	{
+		switch (value) {
+		case spv::Input: return "Input";
+		case spv::Uniform: return "Uniform";
+		case spv::Output: return "Output";
+		case spv::Workgroup: return "Workgroup";
+		case spv::Function: return "Function";
+		case spv::PushConstant: return "PushConstant";
+		case spv::StorageBuffer: return "StorageBuffer";
+		}
+	} break;
+
+	case 'd':
+	{
+		switch (value) {
+		case spv::Block: return "Block";
+		case spv::ColMajor: return "ColMajor";
+		case spv::ArrayStride: return "ArrayStride";
+		case spv::MatrixStride: return "MatrixStride";
+		case spv::BuiltIn: return "BuiltIn";
+		case spv::NoPerspective: return "NoPerspective";
+		case spv::Flat: return "Flat";
+		case spv::NonWritable: return "NonWritable";
+		case spv::NonReadable: return "NonReadable";
+		case spv::Location: return "Location";
+		case spv::Binding: return "Binding";
+		case spv::DescriptorSet: return "DescriptorSet";
+		case spv::Offset: return "Offset";
+		}
+	} break;
+
+	default:
+		break;
+	}
+
+	return std::to_string(value);
+}
+
+std::string spirv_disassemble(const std::vector <uint32_t> &binary)
+{
+	JVL_ASSERT(binary.size() >= 5 && binary[0] == spv::magic, "invalid SPIR-V binary");
+
+	std::string result;
+	result += fmt::format("; SPIR-V\n");
+	result += fmt::format("; Version: {}.{}\n", (binary[1] >> 16) & 0xff, (binary[1] >> 8) & 0xff);
+	result += fmt::format("; Bound: {}\n", binary[3]);
+	result += fmt::format("; Schema: {}\n", binary[4]);
+
+	size_t offset = 5;
+	while (offset < binary.size()) {
+		uint32_t count = binary[offset] >> 16;
+		uint16_t op = binary[offset] & 0xffff;
+
+		JVL_ASSERT(count > 0 && offset + count <= binary.size(),
+			"malformed instruction at word {} of SPIR-V binary", offset);
+
+		auto info = instruction_info(op);
+
+		size_t word = offset + 1;
+		size_t end = offset + count;
+
+		std::string type;
+		if (info.type)
+			type = fmt::format(" %{}", binary[word++]);
+
+		std::string line;
+		if (info.result)
+			line = fmt::format("%{} = ", binary[word++]);
+
+		if (info.name)
+			line += info.name;
+		else
+			line += fmt::format("Op<{}>", op);
+
+		line += type;
+
+		for (const char *c = info.operands; *c && word < end; c++) {
+			switch (*c) {
+			case 'i':
+				line += fmt::format(" %{}", binary[word++]);
+				break;
+			case 'l':
+				line += fmt::format(" {}", binary[word++]);
+				break;
+			case 's':
+			{
+				std::string string;
+				while (word < end) {
+					uint32_t w = binary[word++];
+
+					bool terminated = false;
+					for (size_t b = 0; b < 4; b++) {
+						char ch = (w >> (8 * b)) & 0xff;
+						if (!ch) {
+							terminated = true;
+							break;
+						}
+
+						string += ch;
+					}
+
+					if (terminated)
+						break;
+				}
+
+				line += fmt::format(" \"{}\"", string);
+			} break;
+			case 'I':
+				while (word < end)
+					line += fmt::format(" %{}", binary[word++]);
+				break;
+			case 'L':
+				while (word < end)
+					line += fmt::format(" {}", binary[word++]);
+				break;
+			case 'd':
+				line += " " + enumerant(*c, binary[word++]);
+				while (word < end)
+					line += fmt::format(" {}", binary[word++]);
+				break;
+			default:
+				line += " " + enumerant(*c, binary[word++]);
+				break;
+			}
+		}
+
+		result += line + "\n";
+		offset = end;
+	}
+
+	return result;
+}
+
+} // namespace detail
+
+} // namespace jvl::thunder
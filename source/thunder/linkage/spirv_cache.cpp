@@ -0,0 +1,119 @@
+#include <fstream>
+
+#include <fmt/format.h>
+
+#include <unistd.h>
+
+#include "common/logging.hpp"
+
+#include "thunder/spirv_cache.hpp"
+
+namespace jvl::thunder {
+
+MODULE(spirv-cache);
+
+SpirvCache::SpirvCache(const std::filesystem::path &directory_) : directory(directory_)
+{
+	if (directory.empty())
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error)
+		JVL_WARNING("failed to create cache directory '{}': {}", directory.string(), error.message());
+}
+
+std::filesystem::path SpirvCache::entry(uint64_t key) const
+{
+	return directory / fmt::format("{:016x}.spv", key);
+}
+
+std::optional <BinaryResult> SpirvCache::find(uint64_t key)
+{
+	{
+		std::lock_guard guard(mutex);
+
+		auto it = entries.find(key);
+		if (it != entries.end()) {
+			hit_count++;
+			return it->second;
+		}
+	}
+
+	if (!directory.empty()) {
+		std::ifstream file(entry(key), std::ios::binary | std::ios::ate);
+
+		size_t size = file.is_open() ? size_t(file.tellg()) : 0;
+		if (size > 0 && size % sizeof(uint32_t) == 0) {
+			BinaryResult binary(size / sizeof(uint32_t));
+
+			file.seekg(0);
+			file.read(reinterpret_cast <char *> (binary.data()), size);
+
+			if (file) {
+				std::lock_guard guard(mutex);
+				entries[key] = binary;
+				hit_count++;
+				return binary;
+			}
+		}
+	}
+
+	miss_count++;
+
+	return std::nullopt;
+}
+
+void SpirvCache::insert(uint64_t key, const BinaryResult &binary)
+{
+	{
+		std::lock_guard guard(mutex);
+		entries[key] = binary;
+	}
+
+	if (directory.empty())
+		return;
+
+	// Written under a temporary name first so that
+	// readers never observe a partial entry
+	static std::atomic <size_t> sequence = 0;
+
+	auto path = entry(key);
+	auto partial = path;
+	partial += fmt::format(".{}.{}.tmp", getpid(), sequence++);
+
+	std::ofstream file(partial, std::ios::binary);
+	if (!file.is_open()) {
+		JVL_WARNING("failed to open file '{}' for writing", partial.string());
+		return;
+	}
+
+	file.write(reinterpret_cast <const char *> (binary.data()), binary.size() * sizeof(uint32_t));
+	file.close();
+
+	std::error_code error;
+	std::filesystem::rename(partial, path, error);
+	if (error)
+		JVL_WARNING("failed to write cache entry '{}': {}", path.string(), error.message());
+}
+
+// Only drops the entries held in memory
+void SpirvCache::clear()
+{
+	std::lock_guard guard(mutex);
+	entries.clear();
+	hit_count = 0;
+	miss_count = 0;
+}
+
+size_t SpirvCache::hits() const
+{
+	return hit_count;
+}
+
+size_t SpirvCache::misses() const
+{
+	return miss_count;
+}
+
+} // namespace jvl::thunder
@@ -1,8 +1,11 @@
+#include <cstdlib>
+
 // Glslang and SPIRV-Tools
 #include <glslang/Public/ResourceLimits.h>
 #include <glslang/Public/ShaderLang.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
 
+#include "common/hash.hpp"
 #include "common/logging.hpp"
 #include "common/io.hpp"
 
@@ -56,16 +59,44 @@ constexpr EShLanguage translate_shader_stage(const vk::ShaderStageFlagBits &stag
 	return EShLangVertex;
 }
 
-std::vector <uint32_t> LinkageUnit::generate_spirv_via_glsl(const vk::ShaderStageFlagBits &flags) const
+// Revised whenever the compilation changes for the same source
+static constexpr uint64_t spirv_cache_version = 1;
+
+// Glslang's process state is set up once, by whichever thread compiles
+// first, and is torn down at exit rather than after each compilation
+static void glslang_initialize()
+{
+	static const bool initialized = []() {
+		bool result = glslang::InitializeProcess();
+		std::atexit([]() { glslang::FinalizeProcess(); });
+		return result;
+	} ();
+
+	JVL_ASSERT(initialized, "failed to initialize glslang");
+}
+
+std::vector <uint32_t> LinkageUnit::generate_spirv_via_glsl(const vk::ShaderStageFlagBits &flags, const SpirvOptions &spirv_options) const
 {
 	EShLanguage stage = translate_shader_stage(flags);
 
 	std::string glsl = generate_glsl();
 
+	uint64_t key = 0;
+	if (auto cache = spirv_options.cache) {
+		Hasher hasher;
+		hasher << spirv_cache_version << glsl << uint32_t(flags) << spirv_options.debug_info;
+		key = hasher.value();
+
+		if (auto binary = cache->find(key))
+			return binary.value();
+	}
+
+	glslang_initialize();
+
 	const char *shaderStrings[] { glsl.c_str() };
 
 	glslang::SpvOptions options;
-	options.generateDebugInfo = true;
+	options.generateDebugInfo = spirv_options.debug_info;
 
 	glslang::TShader shader(stage);
 
@@ -74,7 +105,9 @@ std::vector <uint32_t> LinkageUnit::generate_spirv_via_glsl(const vk::ShaderStag
 			    glslang::EShTargetLanguageVersion::EShTargetSpv_1_6);
 
 	// Enable SPIR-V and Vulkan rules when parsing GLSL
-	EShMessages messages = (EShMessages) (EShMsgDefault | EShMsgSpvRules | EShMsgVulkanRules | EShMsgDebugInfo);
+	EShMessages messages = (EShMessages) (EShMsgDefault | EShMsgSpvRules | EShMsgVulkanRules);
+	if (spirv_options.debug_info)
+		messages = (EShMessages) (messages | EShMsgDebugInfo);
 
 	if (!shader.parse(GetDefaultResources(), 460, false, messages)) {
 		std::string log = shader.getInfoLog();
@@ -99,6 +132,10 @@ std::vector <uint32_t> LinkageUnit::generate_spirv_via_glsl(const vk::ShaderStag
 	{
 		glslang::GlslangToSpv(*program.getIntermediate(stage), spirv, &options);
 	}
+
+	if (auto cache = spirv_options.cache)
+		cache->insert(key, spirv);
+
 	return spirv;
 }
 
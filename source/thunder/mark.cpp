@@ -3,7 +3,12 @@
 
 namespace jvl::thunder {
 
-Index Buffer::reference_of(Index i)
+Index Buffer::reference_of(Index i) const
+{
+	return BufferView(*this).reference_of(i);
+}
+
+Index BufferView::reference_of(Index i) const
 {
 	auto &atom = atoms[i];
 
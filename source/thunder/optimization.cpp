@@ -1,9 +1,13 @@
-#include <queue>
+#include <cmath>
+#include <limits>
 #include <unordered_set>
 
 #include "common/logging.hpp"
 
+#include "thunder/cfg.hpp"
 #include "thunder/optimization.hpp"
+#include "thunder/properties.hpp"
+#include "thunder/value_table.hpp"
 
 namespace jvl::thunder {
 
@@ -33,17 +37,547 @@ bool is_casting_intrinsic(const Intrinsic &intr)
 	return false;
 }
 
+// Global constructions whose values do not change during an invocation
+bool invariant_global(const Buffer &buffer, const Construct &ctor)
+{
+	Index i = ctor.type;
+	while (i != -1 && buffer.atoms[i].is <Qualifier> ()) {
+		auto &qualifier = buffer.atoms[i].as <Qualifier> ();
+		if (qualifier.kind != arrays)
+			return invariant_kind(qualifier.kind);
+
+		i = qualifier.underlying;
+	}
+
+	return false;
+}
+
+// Values which depend only on other stable values
+bool stable_value(Buffer &buffer, const std::vector <bool> &stable, Index i)
+{
+	auto operand = [&](Index k) { return (k == -1) || (k >= 0 && stable[k]); };
+
+	auto &atom = buffer.atoms[i];
+
+	switch (atom.index()) {
+
+	// Types are always available, but are deduplicated separately
+	variant_case(Atom, Qualifier):
+	variant_case(Atom, TypeInformation):
+	variant_case(Atom, Primitive):
+		return true;
+
+	variant_case(Atom, Swizzle):
+		return operand(atom.as <Swizzle> ().src);
+
+	variant_case(Atom, Operation):
+	{
+		auto &operation = atom.as <Operation> ();
+		return operand(operation.a) && operand(operation.b);
+	}
+
+	variant_case(Atom, Intrinsic):
+	{
+		auto &intrinsic = atom.as <Intrinsic> ();
+		return pure(intrinsic.opn) && operand(intrinsic.args);
+	}
+
+	variant_case(Atom, List):
+	{
+		auto &list = atom.as <List> ();
+		return operand(list.item) && operand(list.next);
+	}
+
+	variant_case(Atom, Construct):
+	{
+		auto &ctor = atom.as <Construct> ();
+		if (ctor.mode == global)
+			return invariant_global(buffer, ctor);
+		
+		return (ctor.mode == normal)
+			&& !buffer.naturally_forced(atom)
+			&& operand(ctor.type)
+			&& operand(ctor.args);
+	}
+
+	variant_case(Atom, Load):
+		return operand(atom.as <Load> ().src);
+
+	variant_case(Atom, ArrayAccess):
+	{
+		auto &access = atom.as <ArrayAccess> ();
+		return operand(access.src) && operand(access.loc);
+	}
+
+	default:
+		break;
+	}
+
+	return false;
+}
+
+// Constant evaluation of scalar operations, following GLSL semantics;
+// cases which are undefined or trap at runtime are left untouched
+template <typename T>
+std::optional <T> fold_integral(OperationCode code, T a, T b)
+{
+	using U = std::make_unsigned_t <T>;
+
+	constexpr T bits = 8 * sizeof(T);
+
+	switch (code) {
+	case unary_negation:
+		return T(U(0) - U(a));
+	case addition:
+		return T(U(a) + U(b));
+	case subtraction:
+		return T(U(a) - U(b));
+	case multiplication:
+		return T(U(a) * U(b));
+	case division:
+	case modulus:
+		if (b == 0)
+			return std::nullopt;
+
+		if constexpr (std::is_signed_v <T>) {
+			if (a == std::numeric_limits <T> ::min() && b == -1)
+				return std::nullopt;
+			if (code == modulus && (a < 0 || b < 0))
+				return std::nullopt;
+		}
+
+		return (code == division) ? T(a / b) : T(a % b);
+	case bit_and:
+		return T(a & b);
+	case bit_or:
+		return T(a | b);
+	case bit_xor:
+		return T(a ^ b);
+	case bit_shift_left:
+		if (b < 0 || b >= bits)
+			return std::nullopt;
+		return T(U(a) << b);
+	case bit_shift_right:
+		if (b < 0 || b >= bits)
+			return std::nullopt;
+		return T(a >> b);
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+std::optional <float> fold_floating(OperationCode code, float a, float b)
+{
+	float result;
+	switch (code) {
+	case unary_negation:
+		result = -a;
+		break;
+	case addition:
+		result = a + b;
+		break;
+	case subtraction:
+		result = a - b;
+		break;
+	case multiplication:
+		result = a * b;
+		break;
+	case division:
+		result = a / b;
+		break;
+	default:
+		return std::nullopt;
+	}
+
+	if (!std::isfinite(result))
+		return std::nullopt;
+
+	return result;
+}
+
+std::optional <bool> fold_boolean(OperationCode code, bool a, bool b)
+{
+	switch (code) {
+	case bool_not:
+		return !a;
+	case bool_and:
+		return a && b;
+	case bool_or:
+		return a || b;
+	case equals:
+		return a == b;
+	case not_equals:
+		return a != b;
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+template <typename T>
+std::optional <bool> fold_comparison(OperationCode code, T a, T b)
+{
+	switch (code) {
+	case equals:
+		return a == b;
+	case not_equals:
+		return a != b;
+	case cmp_ge:
+		return a > b;
+	case cmp_geq:
+		return a >= b;
+	case cmp_le:
+		return a < b;
+	case cmp_leq:
+		return a <= b;
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+// Constructing primitives of a given type; fails for values which
+// cannot be represented (u64 primitives only carry the lower 32 bits)
+template <typename T>
+std::optional <Primitive> make_primitive(PrimitiveType type, std::optional <T> value)
+{
+	if (!value)
+		return std::nullopt;
+
+	Primitive p;
+	p.type = type;
+
+	switch (type) {
+	case boolean:
+		p.bdata = bool(*value);
+		break;
+	case i32:
+		p.idata = int32_t(*value);
+		break;
+	case u32:
+		p.udata = uint32_t(*value);
+		break;
+	case u64:
+		if (uint64_t(*value) > std::numeric_limits <uint32_t> ::max())
+			return std::nullopt;
+		p.udata = uint32_t(*value);
+		break;
+	case f32:
+		p.fdata = float(*value);
+		break;
+	default:
+		return std::nullopt;
+	}
+
+	return p;
+}
+
+std::optional <Primitive> fold_operation(OperationCode code, const Primitive &a, const Primitive &b, PrimitiveType result)
+{
+	auto integral = [](PrimitiveType type) {
+		return type == i32 || type == u32 || type == u64;
+	};
+
+	// Shift amounts may be of another integer type, as in the
+	// u64 << u32 emitted for every 64-bit literal; amounts which
+	// are negative or too wide are rejected when folding the shift
+	if (a.type != b.type) {
+		bool shift = (code == bit_shift_left || code == bit_shift_right);
+		if (!shift || !integral(a.type) || !integral(b.type))
+			return std::nullopt;
+
+		Primitive amount = b;
+		amount.type = a.type;
+
+		return fold_operation(code, a, amount, result);
+	}
+
+	// Comparisons on non-boolean operands
+	if (result == boolean && a.type != boolean) {
+		switch (a.type) {
+		case i32:
+			return make_primitive(boolean, fold_comparison(code, a.idata, b.idata));
+		case u32:
+		case u64:
+			return make_primitive(boolean, fold_comparison(code, a.udata, b.udata));
+		case f32:
+			return make_primitive(boolean, fold_comparison(code, a.fdata, b.fdata));
+		default:
+			return std::nullopt;
+		}
+	}
+
+	if (result != a.type)
+		return std::nullopt;
+
+	switch (result) {
+	case boolean:
+		return make_primitive(boolean, fold_boolean(code, a.bdata, b.bdata));
+	case i32:
+		return make_primitive(i32, fold_integral(code, a.idata, b.idata));
+	case u32:
+		return make_primitive(u32, fold_integral(code, a.udata, b.udata));
+	case u64:
+		return make_primitive(u64, fold_integral <uint64_t> (code, a.udata, b.udata));
+	case f32:
+		return make_primitive(f32, fold_floating(code, a.fdata, b.fdata));
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+std::optional <Primitive> fold_cast(const Primitive &a, PrimitiveType result)
+{
+	// Conversions from floating point values outside
+	// of the range of the target type are undefined
+	auto bounded = [&](double low, double high) -> std::optional <double> {
+		double v = std::trunc(a.fdata);
+		if (!std::isfinite(v) || v < low || v >= high)
+			return std::nullopt;
+
+		return v;
+	};
+
+	switch (result) {
+	case i32:
+		switch (a.type) {
+		case boolean:
+			return make_primitive(i32, std::optional <int32_t> (a.bdata));
+		case i32:
+		case u32:
+		case u64:
+			return make_primitive(i32, std::optional <int32_t> (a.idata));
+		case f32:
+			return make_primitive(i32, bounded(-0x1p31, 0x1p31));
+		default:
+			break;
+		}
+
+		break;
+	case u32:
+		switch (a.type) {
+		case boolean:
+			return make_primitive(u32, std::optional <uint32_t> (a.bdata));
+		case i32:
+		case u32:
+		case u64:
+			return make_primitive(u32, std::optional <uint32_t> (a.udata));
+		case f32:
+			return make_primitive(u32, bounded(0, 0x1p32));
+		default:
+			break;
+		}
+
+		break;
+	case u64:
+		switch (a.type) {
+		case boolean:
+			return make_primitive(u64, std::optional <uint64_t> (a.bdata));
+		case i32:
+			if (a.idata < 0)
+				return std::nullopt;
+			[[fallthrough]];
+		case u32:
+		case u64:
+			return make_primitive(u64, std::optional <uint64_t> (a.udata));
+		default:
+			break;
+		}
+
+		break;
+	case f32:
+		switch (a.type) {
+		case boolean:
+			return make_primitive(f32, std::optional <float> (a.bdata));
+		case i32:
+			return make_primitive(f32, std::optional <float> (a.idata));
+		case u32:
+		case u64:
+			return make_primitive(f32, std::optional <float> (a.udata));
+		case f32:
+			return a;
+		default:
+			break;
+		}
+
+		break;
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+template <typename T>
+std::optional <T> fold_limiting(IntrinsicOperation opn, const std::vector <T> &args)
+{
+	auto lower = [](T x, T y) { return (y < x) ? y : x; };
+	auto upper = [](T x, T y) { return (x < y) ? y : x; };
+
+	switch (opn) {
+	case abs:
+		if constexpr (std::is_floating_point_v <T>) {
+			return std::fabs(args[0]);
+		} else if constexpr (std::is_signed_v <T>) {
+			if (args[0] == std::numeric_limits <T> ::min())
+				return std::nullopt;
+			return (args[0] < 0) ? T(-args[0]) : args[0];
+		}
+		break;
+	case min:
+		return lower(args[0], args[1]);
+	case max:
+		return upper(args[0], args[1]);
+	case clamp:
+		if (args[2] < args[1])
+			return std::nullopt;
+		return lower(upper(args[0], args[1]), args[2]);
+	case floor:
+		if constexpr (std::is_floating_point_v <T>)
+			return std::floor(args[0]);
+		break;
+	case ceil:
+		if constexpr (std::is_floating_point_v <T>)
+			return std::ceil(args[0]);
+		break;
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+std::optional <Primitive> fold_intrinsic(IntrinsicOperation opn, const std::vector <Primitive> &args, PrimitiveType result)
+{
+	static const std::map <IntrinsicOperation, std::pair <PrimitiveType, size_t>> arities {
+		{ cast_to_int,		{ i32, 1 } },
+		{ cast_to_uint,		{ u32, 1 } },
+		{ cast_to_float,	{ f32, 1 } },
+		{ cast_to_uint64,	{ u64, 1 } },
+		{ abs,			{ bad, 1 } },
+		{ floor,		{ bad, 1 } },
+		{ ceil,			{ bad, 1 } },
+		{ min,			{ bad, 2 } },
+		{ max,			{ bad, 2 } },
+		{ clamp,		{ bad, 3 } },
+	};
+
+	auto it = arities.find(opn);
+	if (it == arities.end() || it->second.second != args.size())
+		return std::nullopt;
+
+	// Casting to a fixed type
+	if (it->second.first != bad) {
+		if (it->second.first != result)
+			return std::nullopt;
+
+		return fold_cast(args[0], result);
+	}
+
+	// Limiting functions operate on arguments of the result type
+	for (auto &arg : args) {
+		if (arg.type != result)
+			return std::nullopt;
+	}
+
+	auto values = [&](auto member) {
+		using T = std::decay_t <decltype(args[0].*member)>;
+
+		std::vector <T> list;
+		for (auto &arg : args)
+			list.push_back(arg.*member);
+
+		return list;
+	};
+
+	switch (result) {
+	case i32:
+		return make_primitive(i32, fold_limiting(opn, values(&Primitive::idata)));
+	case u32:
+		return make_primitive(u32, fold_limiting(opn, values(&Primitive::udata)));
+	case f32:
+		return make_primitive(f32, fold_limiting(opn, values(&Primitive::fdata)));
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+// Values which may be modified, through stores or as arguments to
+// calls, and values which are materialized for array accesses
+struct Mutability {
+	std::vector <bool> mutated;
+	std::vector <bool> addressed;
+};
+
+Mutability mutability(Buffer &buffer)
+{
+	size_t n = buffer.pointer;
+
+	Mutability result {
+		std::vector <bool> (n, false),
+		std::vector <bool> (n, false),
+	};
+
+	for (size_t i = 0; i < n; i++) {
+		auto &atom = buffer.atoms[i];
+
+		if (auto store = atom.get <Store> ()) {
+			result.mutated[buffer.reference_of(store->dst)] = true;
+		} else if (auto call = atom.get <Call> ()) {
+			for (Index k : buffer.expand_list(call->args))
+				result.mutated[buffer.reference_of(k)] = true;
+		} else if (auto access = atom.get <ArrayAccess> ()) {
+			result.addressed[buffer.reference_of(access->src)] = true;
+		}
+	}
+
+	return result;
+}
+
+bool decorated(const Buffer &buffer, Index i)
+{
+	return buffer.decorations.type.contains(i)
+		|| buffer.decorations.phantom.contains(i)
+		|| buffer.decorations.materialize.contains(i);
+}
+
+// Rebuilds the buffer with its atoms in the given order, where
+// every atom must appear after the atoms it references
+void reorder(Buffer &buffer, const std::vector <Index> &order)
+{
+	DenseRelocation relocation(buffer.pointer);
+	for (size_t i = 0; i < order.size(); i++)
+		relocation[order[i]] = i;
+
+	Buffer doubled;
+	for (Index i : order) {
+		Atom atom = buffer.atoms[i];
+		relocation.apply(atom);
+		doubled.emit(atom);
+	}
+
+	doubled.decorations = buffer.decorations.relocated(relocation);
+
+	std::swap(buffer, doubled);
+}
+
 ///////////////////////////////
 // Optimizer implementations //
 ///////////////////////////////
 
-Optimizer Optimizer::stable;
+Optimizer Optimizer::stable { OptimizationFlags::eStable };
 
 // Instruction distillation
 uint32_t Optimizer::distill_types_once(Buffer &buffer) const
 {
-	static_assert(sizeof(Atom) == sizeof(uint64_t));
-	
 	uint32_t counter = 0;
 
 	// Each atom converted to a 64-bit integer
@@ -52,13 +586,18 @@ uint32_t Optimizer::distill_types_once(Buffer &buffer) const
 	// TODO: move outside...
 	auto unique = [&](Index i) -> Index {
 		auto &atom = buffer.atoms[i];
-		auto &hash = reinterpret_cast <uint64_t &> (atom);
+		auto hash = atom.hash();
 		
 		if (!atom.is <TypeInformation> ())
 			return i;
 
+		// Keys of wide atoms can collide, so a colliding type
+		// which differs is left as is rather than merged
 		auto it = existing.find(hash);
 		if (it != existing.end()) {
+			if (!(buffer.atoms[it->second] == atom))
+				return i;
+
 			if (i != it->second) {
 				counter++;
 				buffer.marked.erase(i);
@@ -102,7 +641,602 @@ void Optimizer::distill_types(Buffer &buffer) const
 	JVL_INFO("ran distill types pass {} times", counter);
 }
 
-void Optimizer::distill(Buffer &buffer) const {}
+uint32_t Optimizer::distill_once(Buffer &buffer) const
+{
+	size_t n = buffer.pointer;
+
+	auto [mutated, addressed] = mutability(buffer);
+
+	// Scoped value numbering; values introduced in a scope
+	// are no longer available once the scope is closed
+	std::vector <bool> stable(n, false);
+	std::vector <bool> alive(n, false);
+	std::vector <Index> introduced;
+	std::vector <size_t> scopes;
+
+	auto open = [&]() {
+		scopes.push_back(introduced.size());
+	};
+
+	auto close = [&]() {
+		JVL_ASSERT(scopes.size(), "unbalanced control flow during distillation");
+
+		for (size_t k = scopes.back(); k < introduced.size(); k++)
+			alive[introduced[k]] = false;
+
+		introduced.resize(scopes.back());
+		scopes.pop_back();
+	};
+
+	uint32_t counter = 0;
+
+	Relocation relocation;
+	ValueTable table(n);
+
+	for (size_t i = 0; i < n; i++) {
+		auto &atom = buffer.atoms[i];
+
+		relocation.apply(atom);
+
+		if (auto branch = atom.get <Branch> ()) {
+			switch (branch->kind) {
+			case conditional_if:
+			case loop_while:
+			case loop_for:
+				open();
+				break;
+			case conditional_else_if:
+			case conditional_else:
+				close();
+				open();
+				break;
+			case control_flow_end:
+				close();
+				break;
+			default:
+				break;
+			}
+
+			continue;
+		}
+
+		stable[i] = !mutated[i] && stable_value(buffer, stable, i);
+
+		// Only values can be replaced, types are handled separately
+		bool value = !atom.is <Qualifier> () && !atom.is <TypeInformation> ();
+		if (!stable[i] || !value || addressed[i] || decorated(buffer, i))
+			continue;
+
+		uint64_t key = atom.hash();
+
+		// Keys of wide atoms can collide, so matches are compared as well
+		Index existing = table.lookup(key);
+		if (existing != -1 && alive[existing] && buffer.atoms[existing] == atom) {
+			relocation[i] = existing;
+			counter++;
+			continue;
+		}
+
+		table.insert(key, i);
+		alive[i] = true;
+		introduced.push_back(i);
+	}
+
+	return counter;
+}
+
+void Optimizer::distill(Buffer &buffer) const
+{
+	uint32_t distilled = distill_once(buffer);
+	if (distilled)
+		strip(buffer);
+
+	JVL_INFO("distilled {} duplicate values", distilled);
+}
+
+// Constant folding
+uint32_t Optimizer::fold_once(Buffer &buffer) const
+{
+	size_t n = buffer.pointer;
+
+	auto [mutated, addressed] = mutability(buffer);
+
+	// Values which are never written to, directly or through a parent
+	auto fixed = [&](Index k) {
+		return k >= 0 && !mutated[buffer.reference_of(k)];
+	};
+
+	auto constant = [&](Index k) -> std::optional <Primitive> {
+		if (fixed(k) && buffer.atoms[k].is <Primitive> ())
+			return buffer.atoms[k].as <Primitive> ();
+
+		return std::nullopt;
+	};
+
+	auto primitive_type = [&](Index k) -> PrimitiveType {
+		auto &qt = buffer.types[k];
+		if (!qt.is_primitive())
+			return bad;
+
+		return qt.as <PlainDataType> ().as <PrimitiveType> ();
+	};
+
+	auto integral = [](PrimitiveType type) {
+		return type == i32 || type == u32 || type == u64;
+	};
+
+	// Checks for constants of a particular value; negative zero
+	// is excluded since x - (-0.0) is not an identity for x = -0.0
+	auto equals = [&](Index k, int32_t value) {
+		auto p = constant(k);
+		if (!p)
+			return false;
+
+		switch (p->type) {
+		case i32:
+			return p->idata == value;
+		case u32:
+		case u64:
+			return p->udata == uint32_t(value);
+		case f32:
+			return p->fdata == float(value) && !std::signbit(p->fdata);
+		default:
+			break;
+		}
+
+		return false;
+	};
+
+	// Forwarding is only valid for immutable values of the same type
+	auto forward = [&](Index i, Index k) -> Index {
+		if (!fixed(k) || addressed[k] || buffer.types.id(k) != buffer.types.id(i))
+			return -1;
+
+		return k;
+	};
+
+	auto simplify = [&](const Operation &operation, Index i) -> Index {
+		Index a = operation.a;
+		Index b = operation.b;
+
+		switch (operation.code) {
+		case multiplication:
+			if (equals(b, 1))
+				return forward(i, a);
+			if (equals(a, 1))
+				return forward(i, b);
+			break;
+		case division:
+			if (equals(b, 1))
+				return forward(i, a);
+			break;
+		case addition:
+			if (equals(b, 0) && integral(primitive_type(b)))
+				return forward(i, a);
+			if (equals(a, 0) && integral(primitive_type(a)))
+				return forward(i, b);
+			break;
+		case subtraction:
+			if (equals(b, 0))
+				return forward(i, a);
+			break;
+		case bit_or:
+		case bit_xor:
+			if (equals(b, 0))
+				return forward(i, a);
+			if (equals(a, 0))
+				return forward(i, b);
+			break;
+		case bit_shift_left:
+		case bit_shift_right:
+			if (equals(b, 0))
+				return forward(i, a);
+			break;
+		case unary_negation:
+		case bool_not:
+		{
+			auto inner = buffer.atoms[a].get <Operation> ();
+			if (fixed(a) && inner && inner->code == operation.code)
+				return forward(i, inner->a);
+		} break;
+		default:
+			break;
+		}
+
+		return -1;
+	};
+
+	auto extract = [&](const Swizzle &swizzle, Index i) -> Index {
+		Index src = swizzle.src;
+		if (!fixed(src) || !buffer.atoms[src].is <Construct> ())
+			return -1;
+
+		auto &ctor = buffer.atoms[src].as <Construct> ();
+		if (ctor.mode != normal || ctor.args == -1)
+			return -1;
+
+		size_t components = vector_component_count(primitive_type(src));
+		size_t code = swizzle.code;
+		if (components == 0 || code >= components)
+			return -1;
+
+		// Either a splat of a scalar or one scalar per component
+		auto args = buffer.expand_list(ctor.args);
+		if (args.size() == 1)
+			return forward(i, args[0]);
+		if (args.size() == components)
+			return forward(i, args[code]);
+
+		return -1;
+	};
+
+	uint32_t counter = 0;
+
+	Relocation relocation;
+
+	for (size_t i = 0; i < n; i++) {
+		auto &atom = buffer.atoms[i];
+
+		relocation.apply(atom);
+
+		if (decorated(buffer, i))
+			continue;
+
+		PrimitiveType type = primitive_type(i);
+
+		// Constant results replace the atom in place, which
+		// preserves it as the initial value of any variable
+		std::optional <Primitive> folded;
+
+		Index replacement = -1;
+
+		switch (atom.index()) {
+
+		variant_case(Atom, Operation):
+		{
+			auto &operation = atom.as <Operation> ();
+
+			auto a = constant(operation.a);
+			auto b = (operation.b == -1) ? a : constant(operation.b);
+			if (a && b)
+				folded = fold_operation(operation.code, *a, *b, type);
+
+			// Products with zero are only exact for integers
+			bool zero = equals(operation.a, 0) || equals(operation.b, 0);
+			if (!folded && operation.code == multiplication && integral(type) && zero)
+				folded = make_primitive(type, std::optional <uint32_t> (0));
+
+			// As are shifts of zero, by any amount
+			bool shift = (operation.code == bit_shift_left || operation.code == bit_shift_right);
+			if (!folded && shift && integral(type) && equals(operation.a, 0))
+				folded = make_primitive(type, std::optional <uint32_t> (0));
+
+			if (!folded && !mutated[i])
+				replacement = simplify(operation, i);
+		} break;
+
+		variant_case(Atom, Intrinsic):
+		{
+			auto &intrinsic = atom.as <Intrinsic> ();
+
+			auto list = buffer.expand_list(intrinsic.args);
+
+			std::vector <Primitive> args;
+			for (Index k : list) {
+				if (auto p = constant(k))
+					args.push_back(p.value());
+			}
+
+			if (args.size() && args.size() == list.size())
+				folded = fold_intrinsic(intrinsic.opn, args, type);
+		} break;
+
+		variant_case(Atom, Swizzle):
+		{
+			if (!mutated[i])
+				replacement = extract(atom.as <Swizzle> (), i);
+		} break;
+
+		default:
+			break;
+		}
+
+		if (folded) {
+			atom = folded.value();
+			counter++;
+		} else if (replacement != -1) {
+			relocation[i] = replacement;
+			counter++;
+		}
+	}
+
+	return counter;
+}
+
+void Optimizer::fold(Buffer &buffer) const
+{
+	uint32_t folded = fold_once(buffer);
+	if (folded)
+		strip(buffer);
+
+	JVL_INFO("folded {} constant expressions", folded);
+}
+
+// Loop invariant code motion
+uint32_t Optimizer::hoist_once(Buffer &buffer) const
+{
+	size_t n = buffer.pointer;
+	if (n == 0)
+		return 0;
+
+	ControlFlowGraph cfg = control_flow_graph(buffer);
+
+	// Last position at which each value may be modified, and the
+	// atoms which are written through (destinations and arguments)
+	std::vector <Index> modified(n, -1);
+	std::vector <bool> written(n, false);
+
+	Index effect = -1;
+
+	auto write = [&](Index k, Index i) {
+		while (k >= 0) {
+			written[k] = true;
+
+			auto &atom = buffer.atoms[k];
+			if (auto swizzle = atom.get <Swizzle> ())
+				k = swizzle->src;
+			else if (auto load = atom.get <Load> ())
+				k = load->src;
+			else if (auto access = atom.get <ArrayAccess> ())
+				k = access->src;
+			else
+				break;
+		}
+
+		modified[k] = i;
+	};
+
+	for (size_t i = 0; i < n; i++) {
+		auto &atom = buffer.atoms[i];
+
+		if (auto store = atom.get <Store> ()) {
+			write(store->dst, i);
+		} else if (auto call = atom.get <Call> ()) {
+			for (Index k : buffer.expand_list(call->args))
+				write(k, i);
+
+			effect = i;
+		} else if (auto intrinsic = atom.get <Intrinsic> ()) {
+			if (side_effects(intrinsic->opn)) {
+				for (Index k : buffer.expand_list(intrinsic->args))
+					write(k, i);
+
+				effect = i;
+			}
+		}
+	}
+
+	auto floating = [&](Index k) {
+		auto &qt = buffer.types[k];
+		if (!qt.is_primitive())
+			return false;
+
+		switch (qt.as <PlainDataType> ().as <PrimitiveType> ()) {
+		case f32:
+		case vec2:
+		case vec3:
+		case vec4:
+			return true;
+		default:
+			break;
+		}
+
+		return false;
+	};
+
+	// Worth keeping as a local rather than re-evaluating in place
+	auto computational = [&](Index k) {
+		auto &atom = buffer.atoms[k];
+
+		switch (atom.index()) {
+		variant_case(Atom, Operation):
+		variant_case(Atom, Intrinsic):
+			return true;
+		variant_case(Atom, Construct):
+			return atom.as <Construct> ().mode == normal;
+		default:
+			break;
+		}
+
+		return false;
+	};
+
+	std::vector <Index> destination(n, -1);
+	std::vector <uint32_t> stamp(n, 0);
+	std::vector <bool> memo(n, false);
+
+	uint32_t counter = 0;
+
+	for (size_t h = 0; h < n; h++) {
+		Index hb = cfg.block_of[h];
+		if (cfg.loop[hb] != hb || cfg.first[hb] != Index(h))
+			continue;
+
+		auto &branch = buffer.atoms[h].as <Branch> ();
+
+		Index e = branch.failto;
+
+		// Values are only kept as locals from within the straight
+		// line block leading into the loop, which shares its scope
+		Index start = h;
+		if (hb > 0 && !buffer.atoms[cfg.last[hb - 1]].is <Branch> ())
+			start = cfg.first[hb - 1];
+
+		// Values which are the same throughout the loop, where those
+		// inside the loop must be movable to ahead of its header
+		uint32_t current = h + 1;
+
+		auto invariant = [&](auto &self, Index k) -> bool {
+			if (k < 0)
+				return true;
+
+			if (stamp[k] == current)
+				return memo[k];
+
+			auto &atom = buffer.atoms[k];
+
+			bool result = (modified[buffer.reference_of(k)] < start);
+			if (k > Index(h)) {
+				result &= (cfg.loop[cfg.block_of[k]] == hb);
+				result &= !written[k];
+			}
+
+			switch (atom.index()) {
+
+			variant_case(Atom, Qualifier):
+			{
+				auto &kind = atom.as <Qualifier> ().kind;
+				result &= invariant_kind(kind) || effect < start;
+			} break;
+
+			variant_case(Atom, TypeInformation):
+			variant_case(Atom, Primitive):
+			variant_case(Atom, Storage):
+				break;
+
+			variant_case(Atom, Call):
+				result &= (k < start);
+				break;
+
+			variant_case(Atom, Load):
+			variant_case(Atom, ArrayAccess):
+				// Memory reads may be out of bounds once executed ahead
+				// of a loop which might not run, unless they are already
+				// evaluated in place before it
+				result &= (effect < start);
+				result &= (k < Index(h))
+					&& (buffer.marked.contains(k) || buffer.decorations.materialize.contains(k));
+				[[fallthrough]];
+			variant_case(Atom, Swizzle):
+			variant_case(Atom, List):
+			{
+				auto &&addrs = atom.addresses();
+				result = result && self(self, addrs.a0) && self(self, addrs.a1);
+			} break;
+
+			variant_case(Atom, Operation):
+			{
+				// Integral division may trap once executed speculatively
+				auto &operation = atom.as <Operation> ();
+				if (operation.code == division || operation.code == modulus)
+					result &= floating(k);
+
+				result = result && self(self, operation.a) && self(self, operation.b);
+			} break;
+
+			variant_case(Atom, Intrinsic):
+			{
+				auto &intrinsic = atom.as <Intrinsic> ();
+				result = result && pure(intrinsic.opn) && self(self, intrinsic.args);
+			} break;
+
+			variant_case(Atom, Construct):
+			{
+				auto &constructor = atom.as <Construct> ();
+				result &= (constructor.mode != assignment);
+				result = result && self(self, constructor.type) && self(self, constructor.args);
+			} break;
+
+			default:
+				result = false;
+				break;
+			}
+
+			stamp[k] = current;
+			memo[k] = result;
+
+			return result;
+		};
+
+		auto move = [&](auto &self, Index k) -> void {
+			if (k <= Index(h) || destination[k] != -1)
+				return;
+
+			destination[k] = h;
+
+			auto &&addrs = buffer.atoms[k].addresses();
+			self(self, addrs.a0);
+			self(self, addrs.a1);
+		};
+
+		// Largest invariant subexpressions of the values computed
+		// in each iteration; those already inside the loop are
+		// moved ahead of it, and the rest are kept as locals
+		auto visit = [&](auto &self, Index k) -> void {
+			if (k < start || buffer.marked.contains(k) || destination[k] != -1)
+				return;
+
+			if (computational(k) && !written[k] && invariant(invariant, k)) {
+				bool inserted = buffer.decorations.materialize.insert(k).second;
+				counter += (inserted || k > Index(h));
+				return move(move, k);
+			}
+
+			auto &&addrs = buffer.atoms[k].addresses();
+			self(self, addrs.a0);
+			self(self, addrs.a1);
+		};
+
+		visit(visit, branch.cond);
+
+		for (Index k = h + 1; k < e; k++) {
+			if (destination[k] != -1)
+				continue;
+
+			auto &&addrs = buffer.atoms[k].addresses();
+			if (buffer.atoms[k].is <Branch> ()) {
+				visit(visit, addrs.a0);
+			} else if (!computational(k) || !invariant(invariant, k)) {
+				visit(visit, addrs.a0);
+				visit(visit, addrs.a1);
+			}
+		}
+	}
+
+	if (!counter)
+		return 0;
+
+	// Moved atoms go right before the header of their loop
+	std::vector <std::vector <Index>> hoisted(n);
+	for (size_t i = 0; i < n; i++) {
+		if (destination[i] != -1)
+			hoisted[destination[i]].push_back(i);
+	}
+
+	std::vector <Index> order;
+	order.reserve(n);
+
+	for (size_t i = 0; i < n; i++) {
+		if (destination[i] != -1)
+			continue;
+
+		order.insert(order.end(), hoisted[i].begin(), hoisted[i].end());
+		order.push_back(i);
+	}
+
+	reorder(buffer, order);
+
+	return counter;
+}
+
+void Optimizer::hoist(Buffer &buffer) const
+{
+	uint32_t total = 0;
+	while (uint32_t hoisted = hoist_once(buffer))
+		total += hoisted;
+
+	JVL_INFO("hoisted {} loop invariant expressions", total);
+}
 
 // Instruction disolving
 bool Optimizer::disolve_casting_intrinsic(Relocation &relocation, const Buffer &buffer, const Intrinsic &intr, Index i) const
@@ -142,6 +1276,188 @@ bool Optimizer::disolve_casting_constructor(Relocation &relocation, const Buffer
 	return false;
 }
 
+// Store elision; variables whose stores all lie in the straight-line region
+// of their definition are replaced by the value stored most recently, and
+// stores to variables which are never read are removed outright
+uint32_t Optimizer::disolve_stores(Buffer &buffer) const
+{
+	size_t n = buffer.pointer;
+
+	auto [mutated, addressed] = mutability(buffer);
+
+	UsageTable table = usage_table(buffer);
+	ScopeHierarchy hierarchy = cfg_blocks(buffer);
+
+	std::vector <bool> escaped(n, false);
+	std::vector <std::vector <Index>> stores(n);
+
+	for (size_t i = 0; i < n; i++) {
+		auto &atom = buffer.atoms[i];
+
+		if (auto store = atom.get <Store> ()) {
+			stores[buffer.reference_of(store->dst)].push_back(i);
+		} else if (auto call = atom.get <Call> ()) {
+			for (Index k : buffer.expand_list(call->args))
+				escaped[buffer.reference_of(k)] = true;
+		}
+	}
+
+	// Only variables local to the procedure are eligible
+	auto local = [&](Index v) {
+		auto &atom = buffer.atoms[v];
+
+		switch (atom.index()) {
+		variant_case(Atom, Primitive):
+		variant_case(Atom, Operation):
+		variant_case(Atom, Storage):
+		variant_case(Atom, Call):
+			return true;
+		variant_case(Atom, Intrinsic):
+			return !side_effects(atom.as <Intrinsic> ().opn);
+		variant_case(Atom, Construct):
+			return atom.as <Construct> ().mode == normal;
+		default:
+			break;
+		}
+
+		return false;
+	};
+
+	std::vector <bool> promoted(n, false);
+	std::vector <bool> unread(n, false);
+
+	for (size_t i = 0; i < n; i++) {
+		Index v = i;
+		if (stores[v].empty() || !local(v))
+			continue;
+
+		if (addressed[v] || escaped[v] || decorated(buffer, v))
+			continue;
+
+		// Partial stores through swizzles or fields are not tracked
+		bool whole = true;
+		for (Index s : stores[v])
+			whole &= (buffer.atoms[s].as <Store> ().dst == v);
+
+		if (!whole)
+			continue;
+
+		auto &block = hierarchy.block(v);
+
+		bool straight = true;
+		for (Index s : stores[v])
+			straight &= (&hierarchy.block(s) == &block);
+
+		// Reads must be within the region of the definition, and
+		// uninitialized storage must be written before it is read
+		bool read = false;
+		bool contained = true;
+		for (auto it = table.begin(v); it != table.end(v); it++) {
+			Index u = *it;
+
+			auto store = buffer.atoms[u].get <Store> ();
+			if (store && store->dst == v && store->src != v)
+				continue;
+
+			read = true;
+			contained &= block.contains(u);
+			if (buffer.atoms[v].is <Storage> ())
+				contained &= (u > stores[v].front());
+		}
+
+		unread[v] = !read;
+		promoted[v] = read && straight && contained;
+	}
+
+	// Forwarded values are evaluated at their uses rather than at the
+	// store, so they cannot depend on variables which are still mutable
+	std::vector <bool> unsafe(n, false);
+
+	auto operand = [&](Index k, Index i) {
+		return (k >= 0) && (k < i) && unsafe[k];
+	};
+
+	auto dependent = [&](Index i) {
+		auto &&addrs = buffer.atoms[i].addresses();
+		return operand(addrs.a0, i) || operand(addrs.a1, i);
+	};
+
+	bool changed;
+	do {
+		for (size_t i = 0; i < n; i++) {
+			auto &atom = buffer.atoms[i];
+			if (promoted[i])
+				unsafe[i] = false;
+			else if (mutated[i])
+				unsafe[i] = true;
+			else
+				unsafe[i] = !buffer.naturally_forced(atom) && dependent(i);
+		}
+
+		changed = false;
+		for (size_t i = 0; i < n; i++) {
+			Index v = i;
+			if (!promoted[v])
+				continue;
+
+			bool safe = buffer.naturally_forced(buffer.atoms[v]) || !dependent(v);
+			for (Index s : stores[v])
+				safe &= !unsafe[buffer.atoms[s].as <Store> ().src];
+
+			if (!safe) {
+				promoted[v] = false;
+				changed = true;
+			}
+		}
+	} while (changed);
+
+	// Forward the most recent value of each variable to its uses
+	std::vector <Index> current(n, -1);
+	std::vector <bool> include(n, true);
+
+	for (size_t v = 0; v < n; v++) {
+		if (promoted[v])
+			current[v] = v;
+
+		// Storage without any remaining users is dropped as well
+		bool storage = buffer.atoms[v].is <Storage> ();
+		if (storage && (promoted[v] || unread[v]))
+			include[v] = false;
+	}
+
+	auto resolve = [&](Index &k) {
+		if (k >= 0 && promoted[k])
+			k = current[k];
+	};
+
+	uint32_t counter = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		auto &atom = buffer.atoms[i];
+
+		if (auto store = atom.get <Store> ()) {
+			Index dst = store->dst;
+			if (promoted[dst] || unread[dst]) {
+				Index src = store->src;
+				resolve(src);
+				current[dst] = src;
+				include[i] = false;
+				counter++;
+				continue;
+			}
+		}
+
+		auto &&addrs = atom.addresses();
+		resolve(addrs.a0);
+		resolve(addrs.a1);
+	}
+
+	if (counter)
+		strip_buffer(buffer, include);
+
+	return counter;
+}
+
 void Optimizer::disolve_once(Buffer &buffer, DisolveFlags dflags) const
 {
 	Relocation relocation;
@@ -180,6 +1496,11 @@ void Optimizer::disolve_once(Buffer &buffer, DisolveFlags dflags) const
 
 	// Replacement phase
 	relocation.apply(buffer);
+
+	if (has(dflags, DisolveFlags::eStores)) {
+		uint32_t elided = disolve_stores(buffer);
+		JVL_INFO("elided {} stores", elided);
+	}
 }
 
 void Optimizer::disolve(Buffer &buffer, DisolveFlags dflags) const
@@ -203,7 +1524,7 @@ bool Optimizer::strip_buffer(Buffer &buffer, const std::vector <bool> &include)
 {
 	Index pointer = 0;
 
-	Relocation relocation;
+	DenseRelocation relocation(buffer.pointer);
 	for (size_t i = 0; i < buffer.pointer; i++) {
 		if (include[i])
 			relocation[i] = pointer++;
@@ -217,21 +1538,8 @@ bool Optimizer::strip_buffer(Buffer &buffer, const std::vector <bool> &include)
 		}
 	}
 
-	// Transfer decorations
-	for (auto &[i, hint] : buffer.decorations.type) {
-		auto k = relocation[i];
-		doubled.decorations.type[k] = hint;
-	}
-	
-	for (auto &i : buffer.decorations.phantom) {
-		auto k = relocation[i];
-		doubled.decorations.phantom.insert(k);
-	}
-	
-	for (auto &i : buffer.decorations.materialize) {
-		auto k = relocation[i];
-		doubled.decorations.materialize.insert(k);
-	}
+	// Transfer decorations of the remaining atoms
+	doubled.decorations = buffer.decorations.relocated(relocation);
 
 	std::swap(buffer, doubled);
 
@@ -241,43 +1549,49 @@ bool Optimizer::strip_buffer(Buffer &buffer, const std::vector <bool> &include)
 
 bool Optimizer::strip_once(Buffer &buffer) const
 {
-	UsageGraph graph = usage(buffer);
+	UsageTable table = usage_table(buffer);
 
-	// Reversed usage graph
-	// TODO: users graph...
-	UsageGraph reversed(graph.size());
-	for (size_t i = 0; i < graph.size(); i++) {
-		for (Index j : graph[i])
-			reversed[j].insert(i);
-	}
+	// Remaining number of users for each atom
+	std::vector <uint32_t> remaining(buffer.pointer);
+	for (size_t i = 0; i < buffer.pointer; i++)
+		remaining[i] = table.count(i);
+
+	// Atoms which are required regardless of their users; the marked
+	// set is not used since it may be stale for children of dead atoms
+	auto required = [&](Index i) -> bool {
+		return buffer.naturally_forced(buffer.atoms[i]);
+	};
 
-	// Configure checking queue and inclusion mask
+	// Configure worklist and inclusion mask
 	std::vector <bool> include(buffer.pointer, true);
-	
-	std::queue <Index> check_list;
-	for (size_t i = 0; i < buffer.pointer; i++)
-		check_list.push(i);
 
-	// Keep checking as long as something got erased
-	while (check_list.size()) {
-		std::set <Index> erasure;
+	std::vector <Index> worklist;
+	for (size_t i = 0; i < buffer.pointer; i++) {
+		if (remaining[i] == 0 && !required(i))
+			worklist.push_back(i);
+	}
 
-		while (check_list.size()) {
-			Index i = check_list.front();
-			check_list.pop();
-			
-			if (graph[i].empty() && !buffer.marked.contains(i)) {
-				include[i] = false;
-				erasure.insert(i);
-			}
-		}
+	// Releasing an atom may release its operands in turn
+	auto release = [&](Index addr, Index i) {
+		if (addr < 0 || addr >= i)
+			return;
 
-		for (auto i : erasure) {
-			for (auto j : reversed[i]) {
-				graph[j].erase(i);
-				check_list.push(j);
-			}
-		}
+		if (--remaining[addr] == 0 && !required(addr))
+			worklist.push_back(addr);
+	};
+
+	while (worklist.size()) {
+		Index i = worklist.back();
+		worklist.pop_back();
+
+		include[i] = false;
+
+		Atom atom = buffer.atoms[i];
+
+		auto &&addresses = atom.addresses();
+		release(addresses.a0, i);
+		if (addresses.a1 != addresses.a0)
+			release(addresses.a1, i);
 	}
 
 	// Reconstruct with the reduced set
@@ -286,18 +1600,13 @@ bool Optimizer::strip_once(Buffer &buffer) const
 
 bool Optimizer::strip(Buffer &buffer) const
 {
-	uint32_t counter = 0;
 	uint32_t size_begin = buffer.pointer;
 
-	bool changed;
-	do {
-		changed = strip_once(buffer);
-		counter++;
-	} while (changed);
+	strip_once(buffer);
 
 	uint32_t size_end = buffer.pointer;
 	
-	JVL_INFO("ran dead code elimination pass {} times ({} to {})", counter, size_begin, size_end);
+	JVL_INFO("ran dead code elimination pass ({} to {})", size_begin, size_end);
 
 	return (size_begin != size_end);
 }
@@ -308,15 +1617,28 @@ void Optimizer::apply(Buffer &buffer) const
 	JVL_STAGE_SECTION(optimizer apply);
 
 	distill_types(buffer);
-	disolve(buffer);
+
+	if (has(flags, OptimizationFlags::eStoreElision))
+		disolve(buffer, DisolveFlags::eStores);
+
+	if (has(flags, OptimizationFlags::eConstantFolding))
+		fold(buffer);
+
+	if (has(flags, OptimizationFlags::eDeduplication))
+		distill(buffer);
+
+	disolve(buffer, DisolveFlags::eCasting);
+
+	if (has(flags, OptimizationFlags::eLoopInvariance))
+		hoist(buffer);
 }
 
 void Optimizer::apply(TrackedBuffer &tracked) const
 {
-	Buffer &buffer = tracked;
-	apply(buffer);
+	// Copies of the procedure keep the unoptimized contents
+	apply(tracked.edit());
 
-	TrackedBuffer::cache_insert(&tracked);
+	tracked.publish();
 }
 
 } // namespace jvl::thunder
@@ -14,8 +14,12 @@ MODULE(classify-atoms);
 void Buffer::transfer_decorations(Index dst, Index src)
 {
 	auto &type = decorations.type;
-	if (type.contains(src))
-		type[dst] = type[src];
+	auto it = type.find(src);
+	if (it != type.end()) {
+		// Copied first, since inserting may move the entries
+		auto hint = it->second;
+		type[dst] = std::move(hint);
+	}
 
 	auto &phantom = decorations.phantom;
 	if (phantom.contains(src))
@@ -44,7 +48,7 @@ QualifiedType Buffer::semalz_qualifier(const Qualifier &qualifier, Index i)
 		&& qualifier.underlying < (Index) atoms.size(),
 		"qualifier with invalid underlying reference: {}", qualifier);
 
-	QualifiedType decl = semalz(qualifier.underlying);
+	QualifiedType decl = types[qualifier.underlying];
 
 	// Extended qualifiers
 	if (qualifier.kind == writeonly
@@ -101,7 +105,7 @@ QualifiedType Buffer::semalz_construct(const Construct &constructor, Index i)
 	// Always transfer name hints
 	transfer_decorations(i, constructor.type);
 
-	QualifiedType qt = semalz(constructor.type);
+	QualifiedType qt = types[constructor.type];
 	if (qt.is <PlainDataType> ())
 		return qt;
 
@@ -126,7 +130,7 @@ QualifiedType Buffer::semalz_construct(const Construct &constructor, Index i)
 
 QualifiedType Buffer::semalz_load(const Load &load, Index i)
 {
-	QualifiedType qt = semalz(load.src);
+	auto &qt = types[load.src];
 	if (load.idx == -1)
 		return qt;
 
@@ -173,12 +177,12 @@ QualifiedType Buffer::semalz_load(const Load &load, Index i)
 
 QualifiedType Buffer::semalz_access(const ArrayAccess &access, Index i)
 {
-	auto qt = semalz(access.src);
+	QualifiedType qt = types[access.src];
 
 	while (true) {
 		if (auto pd = qt.get <PlainDataType> ()) {
 			if (pd->is <Index> ())
-				qt = semalz(pd->as <Index> ());
+				qt = types[pd->as <Index> ()];
 			else
 				JVL_BUFFER_DUMP_AND_ABORT("unexpected path, is the base type an array?");
 		} else if (auto sft = qt.get <StructFieldType> ()) {
@@ -210,7 +214,7 @@ QualifiedType Buffer::semalz_access(const ArrayAccess &access, Index i)
 		auto concrete = element.as <Index> ();
 		transfer_decorations(i, concrete);
 
-		auto eqt = semalz(concrete);
+		auto &eqt = types[concrete];
 		if (eqt.is <SamplerType> ())
 			result = eqt;
 	}
@@ -218,12 +222,10 @@ QualifiedType Buffer::semalz_access(const ArrayAccess &access, Index i)
 	return result;
 }
 
+// Operands are always classified before their users, so each
+// atom is classified exactly once from the types of its operands
 QualifiedType Buffer::semalz(Index i)
 {
-	// Cached results
-	if (types[i])
-		return types[i];
-
 	auto &atom = atoms[i];
 
 	switch (atom.index()) {
@@ -319,7 +321,7 @@ QualifiedType Buffer::semalz(Index i)
 	{
 		auto &swz = atom.as <Swizzle> ();
 
-		QualifiedType decl = semalz(swz.src);
+		auto &decl = types[swz.src];
 		QualifiedType plain = decl.remove_qualifiers();
 
 		if (!plain.is_primitive())
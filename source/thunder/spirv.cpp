@@ -0,0 +1,1781 @@
+#include <bit>
+
+#include "common/logging.hpp"
+
+#include "thunder/atom.hpp"
+#include "thunder/enumerations.hpp"
+#include "thunder/properties.hpp"
+#include "thunder/qualified_type.hpp"
+#include "thunder/spirv_generator.hpp"
+
+namespace jvl::thunder::detail {
+
+MODULE(spirv);
+
+// Helper methods for primitive types
+static bool matrix_type(PrimitiveType primitive)
+{
+	switch (primitive) {
+	case mat2:
+	case mat3:
+	case mat4:
+	case mat4x3:
+	case mat3x4:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Column type and count of matrices
+static std::pair <PrimitiveType, uint32_t> matrix_columns(PrimitiveType primitive)
+{
+	switch (primitive) {
+	case mat2:
+		return { vec2, 2 };
+	case mat3:
+		return { vec3, 3 };
+	case mat4:
+		return { vec4, 4 };
+	case mat4x3:
+		return { vec3, 4 };
+	case mat3x4:
+		return { vec4, 3 };
+	default:
+		break;
+	}
+
+	JVL_ABORT("{} is not a matrix type", tbl_primitive_types[primitive]);
+}
+
+static PrimitiveType component_of(PrimitiveType primitive)
+{
+	if (vector_type(primitive))
+		return swizzle_type_of(primitive, SwizzleCode::x);
+
+	if (matrix_type(primitive))
+		return f32;
+
+	return primitive;
+}
+
+static PrimitiveType vector_of(PrimitiveType component, size_t count)
+{
+	static constexpr PrimitiveType floats[] { f32, f32, vec2, vec3, vec4 };
+	static constexpr PrimitiveType ints[] { i32, i32, ivec2, ivec3, ivec4 };
+	static constexpr PrimitiveType uints[] { u32, u32, uvec2, uvec3, uvec4 };
+
+	JVL_ASSERT(count <= 4, "vectors are limited to four components, requested {}", count);
+
+	switch (component) {
+	case f32:
+		return floats[count];
+	case i32:
+		return ints[count];
+	case u32:
+		return uints[count];
+	default:
+		break;
+	}
+
+	JVL_ABORT("no vector type with {} components", tbl_primitive_types[component]);
+}
+
+static bool composite_type(const QualifiedType &qt)
+{
+	return qt.is <ArrayType> () || qt.is <StructFieldType> ();
+}
+
+static uint32_t round_up(uint32_t offset, uint32_t align)
+{
+	return align * ((offset + align - 1) / align);
+}
+
+////////////////////////
+// SPIR-V module data //
+////////////////////////
+
+spirv_module_t::spirv_module_t(const LinkageUnit &unit_) : unit(unit_)
+{
+	size_t atoms = 0;
+	for (auto &function : unit.functions)
+		atoms += function.pointer;
+
+	// Most atoms turn into a single instruction of a few words
+	annotations.reserve(atoms);
+	globals.reserve(4 * atoms);
+	code.reserve(8 * atoms);
+
+	capabilities.insert(spv::Shader);
+
+	glsl_std_450 = id();
+	for (size_t i = 0; i < unit.functions.size(); i++)
+		functions.push_back(id());
+}
+
+uint32_t spirv_module_t::id()
+{
+	return bound++;
+}
+
+// Encoding strings as literal operands
+std::vector <uint32_t> spirv_module_t::literal(const std::string &string)
+{
+	std::vector <uint32_t> words(string.size() / 4 + 1, 0);
+	for (size_t i = 0; i < string.size(); i++)
+		words[i / 4] |= uint32_t(uint8_t(string[i])) << (8 * (i % 4));
+
+	return words;
+}
+
+void spirv_module_t::emit(std::vector <uint32_t> &words, spv::Op op, const std::vector <uint32_t> &operands)
+{
+	words.push_back(uint32_t(operands.size() + 1) << 16 | op);
+	words.insert(words.end(), operands.begin(), operands.end());
+}
+
+uint32_t spirv_module_t::intern(spv::Op op, const std::vector <uint32_t> &operands, uint32_t tag)
+{
+	std::vector <uint32_t> key;
+	key.reserve(operands.size() + 1);
+	key.push_back(tag << 16 | op);
+	key.insert(key.end(), operands.begin(), operands.end());
+
+	auto it = interned.find(key);
+	if (it != interned.end())
+		return it->second;
+
+	uint32_t result = id();
+
+	// Constants are preceded by their type
+	std::vector <uint32_t> words = operands;
+	if (op >= spv::OpConstantTrue && op <= spv::OpConstantNull)
+		words.insert(words.begin() + 1, result);
+	else
+		words.insert(words.begin(), result);
+
+	emit(globals, op, words);
+
+	return (interned[key] = result);
+}
+
+uint32_t spirv_module_t::type_void()
+{
+	return intern(spv::OpTypeVoid, {});
+}
+
+uint32_t spirv_module_t::type_bool()
+{
+	return intern(spv::OpTypeBool, {});
+}
+
+uint32_t spirv_module_t::type_primitive(PrimitiveType primitive)
+{
+	switch (primitive) {
+	case none:
+		return type_void();
+	case boolean:
+		return type_bool();
+	case i32:
+		return intern(spv::OpTypeInt, { 32, 1 });
+	case u32:
+		return intern(spv::OpTypeInt, { 32, 0 });
+	case u64:
+		capabilities.insert(spv::Int64);
+		return intern(spv::OpTypeInt, { 64, 0 });
+	case f32:
+		return intern(spv::OpTypeFloat, { 32 });
+	default:
+		break;
+	}
+
+	if (vector_type(primitive)) {
+		uint32_t component = type_primitive(component_of(primitive));
+		uint32_t count = vector_component_count(primitive);
+		return intern(spv::OpTypeVector, { component, count });
+	}
+
+	if (matrix_type(primitive)) {
+		auto [column, count] = matrix_columns(primitive);
+		return intern(spv::OpTypeMatrix, { type_primitive(column), count });
+	}
+
+	JVL_ABORT("unsupported primitive type {} for SPIR-V", tbl_primitive_types[primitive]);
+}
+
+uint32_t spirv_module_t::type_pointer(uint32_t storage, uint32_t pointee)
+{
+	return intern(spv::OpTypePointer, { storage, pointee });
+}
+
+uint32_t spirv_module_t::constant(const Primitive &primitive)
+{
+	switch (primitive.type) {
+	case boolean:
+		return intern(primitive.bdata ? spv::OpConstantTrue : spv::OpConstantFalse, { type_bool() });
+	case i32:
+	case u32:
+	case f32:
+		return intern(spv::OpConstant, { type_primitive(primitive.type), primitive.udata });
+	case u64:
+		return intern(spv::OpConstant, { type_primitive(u64), primitive.udata, 0 });
+	default:
+		break;
+	}
+
+	JVL_ABORT("unsupported primitive constant: {}", primitive);
+}
+
+uint32_t spirv_module_t::constant_i32(int32_t value)
+{
+	return intern(spv::OpConstant, { type_primitive(i32), uint32_t(value) });
+}
+
+uint32_t spirv_module_t::constant_u32(uint32_t value)
+{
+	return intern(spv::OpConstant, { type_primitive(u32), value });
+}
+
+uint32_t spirv_module_t::constant_null(uint32_t type)
+{
+	return intern(spv::OpConstantNull, { type });
+}
+
+std::vector <uint32_t> spirv_module_t::assemble() const
+{
+	auto extended = literal("GLSL.std.450");
+
+	size_t size = 5
+		+ 2 * capabilities.size()
+		+ 2 + extended.size()
+		+ 3
+		+ entries.size()
+		+ names.size()
+		+ annotations.size()
+		+ globals.size()
+		+ code.size();
+
+	std::vector <uint32_t> binary;
+	binary.reserve(size);
+
+	binary.push_back(spv::magic);
+	binary.push_back(spv::version);
+	binary.push_back(0);
+	binary.push_back(bound);
+	binary.push_back(0);
+
+	for (auto capability : capabilities)
+		emit(binary, spv::OpCapability, { capability });
+
+	std::vector <uint32_t> import { glsl_std_450 };
+	import.insert(import.end(), extended.begin(), extended.end());
+	emit(binary, spv::OpExtInstImport, import);
+
+	// Logical addressing with the GLSL450 memory model
+	emit(binary, spv::OpMemoryModel, { 0, 1 });
+
+	binary.insert(binary.end(), entries.begin(), entries.end());
+	binary.insert(binary.end(), names.begin(), names.end());
+	binary.insert(binary.end(), annotations.begin(), annotations.end());
+	binary.insert(binary.end(), globals.begin(), globals.end());
+	binary.insert(binary.end(), code.begin(), code.end());
+
+	JVL_ASSERT(binary.size() == size, "mismatch in SPIR-V binary size ({} vs {} words)", binary.size(), size);
+
+	return binary;
+}
+
+///////////////////////////////
+// SPIR-V function generator //
+///////////////////////////////
+
+spirv_function_generator_t::spirv_function_generator_t(spirv_module_t &module_, size_t index)
+		: BufferView(module_.unit.functions[index]),
+		module(module_),
+		function(module_.unit.functions[index]),
+		terminated(false)
+{
+	body.reserve(8 * pointer);
+}
+
+// Types and layouts
+QualifiedType spirv_function_generator_t::resolve(QualifiedType qt) const
+{
+	while (true) {
+		switch (qt.index()) {
+
+		variant_case(QualifiedType, PlainDataType):
+		{
+			auto &pd = qt.as <PlainDataType> ();
+			if (pd.is <PrimitiveType> ())
+				return qt;
+
+			qt = types[pd.as <Index> ()];
+		} break;
+
+		variant_case(QualifiedType, InArgType):
+			qt = static_cast <PlainDataType> (qt.as <InArgType> ());
+			break;
+
+		variant_case(QualifiedType, OutArgType):
+			qt = static_cast <PlainDataType> (qt.as <OutArgType> ());
+			break;
+
+		variant_case(QualifiedType, InOutArgType):
+			qt = static_cast <PlainDataType> (qt.as <InOutArgType> ());
+			break;
+
+		default:
+			return qt;
+		}
+	}
+}
+
+std::vector <QualifiedType> spirv_function_generator_t::fields(QualifiedType qt) const
+{
+	std::vector <QualifiedType> result;
+
+	while (qt.is <StructFieldType> ()) {
+		auto &sft = qt.as <StructFieldType> ();
+		result.push_back(sft.base());
+		qt = types[sft.next];
+	}
+
+	JVL_ASSERT(qt.is <NilType> (), "failed to reach nil marker for structure, got {} instead", qt);
+
+	return result;
+}
+
+PrimitiveType spirv_function_generator_t::primitive(Index i) const
+{
+	auto qt = resolve(types[i]);
+	JVL_ASSERT(qt.is_primitive(), "expected a primitive type for @{}, got {} instead", i, qt);
+	return qt.as <PlainDataType> ().as <PrimitiveType> ();
+}
+
+spirv_function_generator_t::layout_info spirv_function_generator_t::layout(const QualifiedType &original, spirv_layout rules) const
+{
+	auto qt = resolve(original);
+
+	if (qt.is_primitive()) {
+		auto item = qt.as <PlainDataType> ().as <PrimitiveType> ();
+
+		if (matrix_type(item)) {
+			auto [column, count] = matrix_columns(item);
+			auto info = layout(QualifiedType::primitive(column), rules);
+			uint32_t stride = round_up(info.size, info.align);
+			return { count * stride, info.align };
+		}
+
+		uint32_t scalar = (component_of(item) == u64) ? 8 : 4;
+		switch (vector_component_count(item)) {
+		case 0:
+			return { scalar, scalar };
+		case 2:
+			return { 2 * scalar, 2 * scalar };
+		case 3:
+			return { 3 * scalar, 4 * scalar };
+		default:
+			return { 4 * scalar, 4 * scalar };
+		}
+	}
+
+	if (auto at = qt.get <ArrayType> ()) {
+		auto info = layout(at->element(), rules);
+		uint32_t align = (rules == std140) ? round_up(info.align, 16) : info.align;
+		uint32_t stride = round_up(info.size, align);
+		uint32_t count = std::max <int32_t> (at->size, 0);
+		return { count * stride, align };
+	}
+
+	if (qt.is <StructFieldType> ()) {
+		uint32_t offset = 0;
+		uint32_t align = (rules == std140) ? 16 : 1;
+		for (auto &field : fields(qt)) {
+			auto info = layout(field, rules);
+			offset = round_up(offset, info.align) + info.size;
+			align = std::max(align, info.align);
+		}
+
+		return { round_up(offset, align), align };
+	}
+
+	JVL_ABORT("failed to compute the memory layout of {}", original);
+}
+
+// Matrix members need their strides, even through arrays
+static std::optional <PrimitiveType> matrix_member(const spirv_function_generator_t &generator, QualifiedType qt)
+{
+	qt = generator.resolve(qt);
+	while (auto at = qt.get <ArrayType> ())
+		qt = generator.resolve(at->element());
+
+	if (qt.is_primitive()) {
+		auto item = qt.as <PlainDataType> ().as <PrimitiveType> ();
+		if (matrix_type(item))
+			return item;
+	}
+
+	return std::nullopt;
+}
+
+// Structures with explicit layouts, optionally as interface blocks
+uint32_t spirv_function_generator_t::structure(const std::vector <QualifiedType> &members, spirv_layout rules, uint32_t shift, bool block)
+{
+	std::vector <uint32_t> ids;
+	for (auto &member : members)
+		ids.push_back(type(member, rules));
+
+	// Blocks are kept apart from the plain structures with the same members
+	uint32_t before = module.bound;
+	uint32_t tag = block ? 4 * (shift + 1) + rules : rules;
+	uint32_t result = module.intern(spv::OpTypeStruct, ids, tag);
+	if (result < before || rules == plain)
+		return result;
+
+	auto &annotations = module.annotations;
+
+	if (block)
+		module.emit(annotations, spv::OpDecorate, { result, spv::Block });
+
+	uint32_t offset = shift;
+	for (uint32_t i = 0; i < members.size(); i++) {
+		auto info = layout(members[i], rules);
+		offset = round_up(offset, info.align);
+
+		module.emit(annotations, spv::OpMemberDecorate, { result, i, spv::Offset, offset });
+		if (auto matrix = matrix_member(*this, members[i])) {
+			auto column = layout(QualifiedType::primitive(matrix_columns(*matrix).first), rules);
+			module.emit(annotations, spv::OpMemberDecorate, { result, i, spv::ColMajor });
+			module.emit(annotations, spv::OpMemberDecorate, { result, i, spv::MatrixStride, column.align });
+		}
+
+		offset += info.size;
+	}
+
+	return result;
+}
+
+uint32_t spirv_function_generator_t::type(const QualifiedType &original, spirv_layout rules)
+{
+	auto qt = resolve(original);
+
+	switch (qt.index()) {
+
+	variant_case(QualifiedType, NilType):
+		return module.type_void();
+
+	variant_case(QualifiedType, PlainDataType):
+		return module.type_primitive(qt.as <PlainDataType> ().as <PrimitiveType> ());
+
+	variant_case(QualifiedType, ArrayType):
+	{
+		auto &at = qt.as <ArrayType> ();
+
+		uint32_t element = type(at.element(), rules);
+
+		uint32_t before = module.bound;
+
+		uint32_t result = 0;
+		if (at.size < 0) {
+			JVL_ASSERT(rules != plain, "unsized arrays are only supported in buffers");
+			result = module.intern(spv::OpTypeRuntimeArray, { element }, rules);
+		} else {
+			uint32_t count = module.constant_u32(at.size);
+			before = module.bound;
+			result = module.intern(spv::OpTypeArray, { element, count }, rules);
+		}
+
+		if (rules != plain && result >= before) {
+			auto info = layout(at.element(), rules);
+			uint32_t align = (rules == std140) ? round_up(info.align, 16) : info.align;
+			uint32_t stride = round_up(info.size, align);
+			module.emit(module.annotations, spv::OpDecorate, { result, spv::ArrayStride, stride });
+		}
+
+		return result;
+	}
+
+	variant_case(QualifiedType, StructFieldType):
+	{
+		return structure(fields(qt), rules);
+	}
+
+	default:
+		break;
+	}
+
+	JVL_ABORT("failed to generate SPIR-V type for {}", original);
+}
+
+// Instructions
+void spirv_function_generator_t::emit(spv::Op op, const std::vector <uint32_t> &operands)
+{
+	// Anything following a terminator is unreachable,
+	// but still needs to be placed in a block
+	if (terminated)
+		label(module.id());
+
+	module.emit(body, op, operands);
+}
+
+uint32_t spirv_function_generator_t::emit_value(spv::Op op, uint32_t type, const std::vector <uint32_t> &operands)
+{
+	uint32_t result = module.id();
+
+	std::vector <uint32_t> words { type, result };
+	words.insert(words.end(), operands.begin(), operands.end());
+	emit(op, words);
+
+	return result;
+}
+
+uint32_t spirv_function_generator_t::local(uint32_t type)
+{
+	uint32_t result = module.id();
+	uint32_t pointer = module.type_pointer(spv::Function, type);
+	module.emit(variables, spv::OpVariable, { pointer, result, spv::Function });
+	return result;
+}
+
+void spirv_function_generator_t::label(uint32_t id)
+{
+	module.emit(body, spv::OpLabel, { id });
+	terminated = false;
+	cache.clear();
+}
+
+void spirv_function_generator_t::jump(uint32_t target)
+{
+	if (terminated)
+		return;
+
+	emit(spv::OpBranch, { target });
+	terminated = true;
+}
+
+uint32_t spirv_function_generator_t::splat(uint32_t value, PrimitiveType from, PrimitiveType to)
+{
+	size_t count = vector_component_count(to);
+	if (from == to || count == 0 || vector_component_count(from) != 0)
+		return value;
+
+	return emit_value(spv::OpCompositeConstruct,
+		module.type_primitive(to),
+		std::vector <uint32_t> (count, value));
+}
+
+uint32_t spirv_function_generator_t::convert(uint32_t value, PrimitiveType from, PrimitiveType to)
+{
+	if (from == to)
+		return value;
+
+	size_t count = vector_component_count(to);
+	if (count && !vector_component_count(from)) {
+		value = convert(value, from, component_of(to));
+		return splat(value, component_of(to), to);
+	}
+
+	auto source = component_of(from);
+	auto target = component_of(to);
+	uint32_t type = module.type_primitive(to);
+
+	if (source == boolean) {
+		Primitive zero;
+		Primitive one;
+		zero.type = one.type = target;
+		zero.udata = 0;
+		one.udata = (target == f32) ? std::bit_cast <uint32_t> (1.0f) : 1;
+
+		uint32_t zeros = splat(module.constant(zero), target, to);
+		uint32_t ones = splat(module.constant(one), target, to);
+
+		return emit_value(spv::OpSelect, type, { value, ones, zeros });
+	}
+
+	spv::Op op = spv::OpBitcast;
+	if (source == f32)
+		op = (target == i32) ? spv::OpConvertFToS : spv::OpConvertFToU;
+	else if (target == f32)
+		op = (source == i32) ? spv::OpConvertSToF : spv::OpConvertUToF;
+	else if (source == u64 || target == u64)
+		op = (source == i32) ? spv::OpSConvert : spv::OpUConvert;
+
+	JVL_ASSERT(target != boolean, "unsupported conversion from {} to {}",
+		tbl_primitive_types[from], tbl_primitive_types[to]);
+
+	return emit_value(op, type, { value });
+}
+
+// Global variables
+static uint32_t builtin(QualifierKind kind)
+{
+	switch (kind) {
+	case glsl_FragCoord:
+		return 15;
+	case glsl_FragDepth:
+		return 22;
+	case glsl_InstanceIndex:
+		return 43;
+	case glsl_VertexIndex:
+		return 42;
+	case glsl_GlobalInvocationID:
+		return 28;
+	case glsl_LocalInvocationID:
+		return 27;
+	case glsl_LocalInvocationIndex:
+		return 29;
+	case glsl_WorkGroupID:
+		return 26;
+	case glsl_SubgroupInvocationID:
+		return 41;
+	case glsl_Position:
+		return 0;
+	default:
+		break;
+	}
+
+	JVL_ABORT("{} is unsupported by the SPIR-V backend", tbl_qualifier_kind[kind]);
+}
+
+spirv_pointer spirv_function_generator_t::global_variable(Index i)
+{
+	auto &qualifier = atoms[i].as <Qualifier> ();
+
+	switch (qualifier.kind) {
+	case writeonly:
+	case readonly:
+		return global_variable(qualifier.underlying);
+	default:
+		break;
+	}
+
+	auto key = std::make_pair(qualifier.kind, qualifier.numerical);
+
+	spirv_pointer result;
+
+	auto it = module.variables.find(key);
+	if (it != module.variables.end()) {
+		result = it->second;
+	} else {
+		auto &annotations = module.annotations;
+
+		uint32_t pointee = 0;
+		uint32_t id = module.id();
+
+		std::vector <std::pair <uint32_t, uint32_t>> decorations;
+
+		switch (qualifier.kind) {
+
+		case storage_buffer:
+		{
+			auto underlying = resolve(types[qualifier.underlying]);
+			pointee = structure(fields(underlying), std430, 0, true);
+			result = { id, spv::StorageBuffer, std430 };
+
+			decorations.emplace_back(spv::DescriptorSet, 0);
+			decorations.emplace_back(spv::Binding, qualifier.numerical);
+
+			auto &buffers = module.unit.globals.buffers;
+			if (buffers.contains(qualifier.numerical)) {
+				for (auto kind : buffers.at(qualifier.numerical).extra) {
+					JVL_ASSERT(kind != scalar, "scalar block layouts are unsupported by the SPIR-V backend");
+					if (kind == writeonly)
+						decorations.emplace_back(spv::NonReadable, -1);
+					if (kind == readonly)
+						decorations.emplace_back(spv::NonWritable, -1);
+				}
+			}
+		} break;
+
+		case uniform_buffer:
+		{
+			pointee = structure({ types[qualifier.underlying] }, std140, 0, true);
+			result = { id, spv::Uniform, std140 };
+
+			decorations.emplace_back(spv::DescriptorSet, 0);
+			decorations.emplace_back(spv::Binding, qualifier.numerical);
+		} break;
+
+		case push_constant:
+		{
+			auto underlying = resolve(types[qualifier.underlying]);
+			pointee = structure(fields(underlying), std430, std::max <int32_t> (qualifier.numerical, 0), true);
+			result = { id, spv::PushConstant, std430 };
+		} break;
+
+		case layout_in_flat:
+		case layout_in_noperspective:
+		case layout_in_smooth:
+		case layout_out_flat:
+		case layout_out_noperspective:
+		case layout_out_smooth:
+		{
+			bool input = (qualifier.kind == layout_in_flat)
+				|| (qualifier.kind == layout_in_noperspective)
+				|| (qualifier.kind == layout_in_smooth);
+
+			pointee = type(types[qualifier.underlying]);
+			result = { id, input ? spv::Input : spv::Output, plain };
+
+			decorations.emplace_back(spv::Location, qualifier.numerical);
+			if (qualifier.kind == layout_in_flat || qualifier.kind == layout_out_flat)
+				decorations.emplace_back(spv::Flat, -1);
+			if (qualifier.kind == layout_in_noperspective || qualifier.kind == layout_out_noperspective)
+				decorations.emplace_back(spv::NoPerspective, -1);
+		} break;
+
+		case shared:
+		{
+			pointee = type(types[qualifier.underlying]);
+			result = { id, spv::Workgroup, plain };
+		} break;
+
+		default:
+		{
+			// Remaining qualifiers are built-in variables
+			uint32_t code = builtin(qualifier.kind);
+
+			bool output = (qualifier.kind == glsl_Position) || (qualifier.kind == glsl_FragDepth);
+
+			pointee = type(types[i]);
+			result = { id, output ? spv::Output : spv::Input, plain };
+
+			decorations.emplace_back(spv::BuiltIn, code);
+
+			if (qualifier.kind == glsl_FragDepth)
+				module.depth_replacing = true;
+			if (qualifier.kind == glsl_SubgroupInvocationID)
+				module.capabilities.insert(spv::GroupNonUniform);
+		} break;
+
+		}
+
+		for (auto [decoration, operand] : decorations) {
+			if (operand == uint32_t(-1))
+				module.emit(annotations, spv::OpDecorate, { id, decoration });
+			else
+				module.emit(annotations, spv::OpDecorate, { id, decoration, operand });
+		}
+
+		uint32_t pointer = module.type_pointer(result.storage, pointee);
+		module.emit(module.globals, spv::OpVariable, { pointer, id, result.storage });
+
+		module.interface.push_back(id);
+		module.variables[key] = result;
+	}
+
+	// Uniform blocks wrap the actual value
+	if (qualifier.kind == uniform_buffer) {
+		uint32_t member = type(types[qualifier.underlying], std140);
+		uint32_t pointer = module.type_pointer(spv::Uniform, member);
+		result.id = emit_value(spv::OpAccessChain, pointer, { result.id, module.constant_i32(0) });
+	}
+
+	return result;
+}
+
+// Values and pointers
+std::optional <spirv_pointer> spirv_function_generator_t::address(Index i)
+{
+	auto it = locals.find(i);
+	if (it != locals.end())
+		return it->second;
+
+	auto &atom = atoms[i];
+
+	switch (atom.index()) {
+
+	variant_case(Atom, Qualifier):
+	{
+		auto &qualifier = atom.as <Qualifier> ();
+		if (qualifier.kind != parameter)
+			return global_variable(i);
+
+		// Output parameters are passed by pointer
+		auto &qt = function.args[qualifier.numerical];
+		if (qt.is <OutArgType> () || qt.is <InOutArgType> ())
+			return spirv_pointer(parameters[qualifier.numerical], spv::Function, plain);
+	} break;
+
+	variant_case(Atom, Construct):
+	{
+		auto &constructor = atom.as <Construct> ();
+		if (constructor.mode == global)
+			return address(constructor.type);
+	} break;
+
+	variant_case(Atom, Load):
+	{
+		auto &load = atom.as <Load> ();
+
+		auto src = address(load.src);
+		if (!src || load.idx == -1)
+			return src;
+
+		return chain(src.value(), module.constant_i32(load.idx), i);
+	}
+
+	variant_case(Atom, ArrayAccess):
+	{
+		auto &access = atom.as <ArrayAccess> ();
+		if (auto src = address(access.src))
+			return chain(src.value(), value(access.loc), i);
+	} break;
+
+	variant_case(Atom, Swizzle):
+	{
+		auto &swizzle = atom.as <Swizzle> ();
+		if (swizzle.code > SwizzleCode::w)
+			break;
+
+		if (auto src = address(swizzle.src))
+			return chain(src.value(), module.constant_i32(swizzle.code), i);
+	} break;
+
+	default:
+		break;
+	}
+
+	return std::nullopt;
+}
+
+spirv_pointer spirv_function_generator_t::chain(const spirv_pointer &src, uint32_t index, Index i)
+{
+	uint32_t pointee = type(types[i], src.layout);
+	uint32_t pointer = module.type_pointer(src.storage, pointee);
+	uint32_t id = emit_value(spv::OpAccessChain, pointer, { src.id, index });
+	return spirv_pointer(id, src.storage, src.layout);
+}
+
+uint32_t spirv_function_generator_t::load(const spirv_pointer &src, Index i)
+{
+	uint32_t result = emit_value(spv::OpLoad, type(types[i], src.layout), { src.id });
+
+	// Aggregates with explicit layouts are distinct types
+	if (src.layout != plain && composite_type(resolve(types[i])))
+		result = emit_value(spv::OpCopyLogical, type(types[i]), { result });
+
+	return result;
+}
+
+void spirv_function_generator_t::store(const spirv_pointer &dst, Index i, uint32_t value)
+{
+	if (dst.layout != plain && composite_type(resolve(types[i])))
+		value = emit_value(spv::OpCopyLogical, type(types[i], dst.layout), { value });
+
+	emit(spv::OpStore, { dst.id, value });
+
+	// Inlined values may have read the destination
+	cache.clear();
+}
+
+uint32_t spirv_function_generator_t::value(Index i)
+{
+	JVL_ASSERT(i != -1, "invalid index passed to value");
+
+	auto it = values.find(i);
+	if (it != values.end())
+		return it->second;
+
+	auto &atom = atoms[i];
+	if (auto primitive = atom.get <Primitive> (); primitive && !locals.contains(i))
+		return module.constant(primitive.value());
+
+	auto cached = cache.find(i);
+	if (cached != cache.end())
+		return cached->second;
+
+	uint32_t result = 0;
+	if (auto ptr = address(i))
+		result = load(ptr.value(), i);
+	else
+		result = compute(i);
+
+	return (cache[i] = result);
+}
+
+uint32_t spirv_function_generator_t::compute(Index i)
+{
+	auto &atom = atoms[i];
+
+	switch (atom.index()) {
+
+	variant_case(Atom, Primitive):
+		return module.constant(atom.as <Primitive> ());
+
+	variant_case(Atom, Operation):
+		return generate_operation(atom.as <Operation> (), i);
+
+	variant_case(Atom, Intrinsic):
+		return generate_intrinsic(atom.as <Intrinsic> (), i);
+
+	variant_case(Atom, Construct):
+		return generate_construct(atom.as <Construct> (), i);
+
+	variant_case(Atom, Call):
+		return generate_call(atom.as <Call> (), i);
+
+	variant_case(Atom, Qualifier):
+	{
+		auto &qualifier = atom.as <Qualifier> ();
+		if (qualifier.kind == parameter)
+			return parameters[qualifier.numerical];
+	} break;
+
+	variant_case(Atom, Swizzle):
+	{
+		auto &swizzle = atom.as <Swizzle> ();
+
+		uint32_t src = value(swizzle.src);
+		uint32_t type = this->type(types[i]);
+
+		if (swizzle.code == SwizzleCode::xy)
+			return emit_value(spv::OpVectorShuffle, type, { src, src, 0, 1 });
+
+		return emit_value(spv::OpCompositeExtract, type, { src, uint32_t(swizzle.code) });
+	}
+
+	variant_case(Atom, Load):
+	{
+		auto &load = atom.as <Load> ();
+		if (load.idx == -1)
+			return value(load.src);
+
+		uint32_t src = value(load.src);
+		return emit_value(spv::OpCompositeExtract, type(types[i]), { src, uint32_t(load.idx) });
+	}
+
+	variant_case(Atom, ArrayAccess):
+	{
+		auto &access = atom.as <ArrayAccess> ();
+
+		uint32_t src = value(access.src);
+		uint32_t loc = value(access.loc);
+
+		auto qt = resolve(types[access.src]);
+		if (qt.is_primitive())
+			return emit_value(spv::OpVectorExtractDynamic, type(types[i]), { src, loc });
+
+		// Dynamic indexing into values requires a variable
+		uint32_t temporary = local(type(qt));
+		emit(spv::OpStore, { temporary, src });
+
+		auto element = chain(spirv_pointer(temporary, spv::Function, plain), loc, i);
+		return load(element, i);
+	}
+
+	default:
+		break;
+	}
+
+	JVL_ABORT("failed to generate SPIR-V value for: {} (@{})", atom, i);
+}
+
+// Materialized atoms are evaluated in place
+void spirv_function_generator_t::define(Index i)
+{
+	auto it = locals.find(i);
+	if (it != locals.end())
+		return store(it->second, i, compute(i));
+
+	// Resolved as pointers wherever they are used
+	if (lvalues.contains(i))
+		return;
+
+	values[i] = value(i);
+}
+
+// Operations
+static spv::Op operation_code(OperationCode code, PrimitiveType component)
+{
+	bool floating = (component == f32);
+	bool sign = (component == i32);
+	bool logical = (component == boolean);
+
+	switch (code) {
+	case addition:
+		return floating ? spv::OpFAdd : spv::OpIAdd;
+	case subtraction:
+		return floating ? spv::OpFSub : spv::OpISub;
+	case multiplication:
+		return floating ? spv::OpFMul : spv::OpIMul;
+	case division:
+		return floating ? spv::OpFDiv : (sign ? spv::OpSDiv : spv::OpUDiv);
+	case modulus:
+		return floating ? spv::OpFMod : (sign ? spv::OpSMod : spv::OpUMod);
+	case bool_or:
+		return spv::OpLogicalOr;
+	case bool_and:
+		return spv::OpLogicalAnd;
+	case bit_or:
+		return spv::OpBitwiseOr;
+	case bit_and:
+		return spv::OpBitwiseAnd;
+	case bit_xor:
+		return spv::OpBitwiseXor;
+	case bit_shift_left:
+		return spv::OpShiftLeftLogical;
+	case bit_shift_right:
+		return sign ? spv::OpShiftRightArithmetic : spv::OpShiftRightLogical;
+	case equals:
+		return floating ? spv::OpFOrdEqual : (logical ? spv::OpLogicalEqual : spv::OpIEqual);
+	case not_equals:
+		return floating ? spv::OpFUnordNotEqual : (logical ? spv::OpLogicalNotEqual : spv::OpINotEqual);
+	case cmp_ge:
+		return floating ? spv::OpFOrdGreaterThan : (sign ? spv::OpSGreaterThan : spv::OpUGreaterThan);
+	case cmp_geq:
+		return floating ? spv::OpFOrdGreaterThanEqual : (sign ? spv::OpSGreaterThanEqual : spv::OpUGreaterThanEqual);
+	case cmp_le:
+		return floating ? spv::OpFOrdLessThan : (sign ? spv::OpSLessThan : spv::OpULessThan);
+	case cmp_leq:
+		return floating ? spv::OpFOrdLessThanEqual : (sign ? spv::OpSLessThanEqual : spv::OpULessThanEqual);
+	default:
+		break;
+	}
+
+	JVL_ABORT("unsupported operation for SPIR-V: {}", tbl_operation_code[code]);
+}
+
+uint32_t spirv_function_generator_t::generate_operation(const Operation &operation, Index i)
+{
+	uint32_t type = this->type(types[i]);
+
+	switch (operation.code) {
+	case swz_x:
+	case swz_y:
+	case swz_z:
+	case swz_w:
+	{
+		uint32_t component = operation.code - swz_x;
+		return emit_value(spv::OpCompositeExtract, type, { value(operation.a), component });
+	}
+
+	case unary_negation:
+	{
+		bool floating = (component_of(primitive(operation.a)) == f32);
+		return emit_value(floating ? spv::OpFNegate : spv::OpSNegate, type, { value(operation.a) });
+	}
+
+	case bool_not:
+		return emit_value(spv::OpLogicalNot, type, { value(operation.a) });
+
+	default:
+		break;
+	}
+
+	auto pa = primitive(operation.a);
+	auto pb = primitive(operation.b);
+
+	uint32_t a = value(operation.a);
+	uint32_t b = value(operation.b);
+
+	// Linear algebra has dedicated instructions
+	if (operation.code == multiplication && component_of(pa) == f32) {
+		bool ma = matrix_type(pa);
+		bool mb = matrix_type(pb);
+		bool va = vector_type(pa);
+		bool vb = vector_type(pb);
+
+		if (ma && mb)
+			return emit_value(spv::OpMatrixTimesMatrix, type, { a, b });
+		if (ma && vb)
+			return emit_value(spv::OpMatrixTimesVector, type, { a, b });
+		if (va && mb)
+			return emit_value(spv::OpVectorTimesMatrix, type, { a, b });
+		if (ma)
+			return emit_value(spv::OpMatrixTimesScalar, type, { a, b });
+		if (mb)
+			return emit_value(spv::OpMatrixTimesScalar, type, { b, a });
+		if (va && !vb)
+			return emit_value(spv::OpVectorTimesScalar, type, { a, b });
+		if (vb && !va)
+			return emit_value(spv::OpVectorTimesScalar, type, { b, a });
+	}
+
+	// Scalars are broadcast against vectors
+	bool shift = (operation.code == bit_shift_left) || (operation.code == bit_shift_right);
+	if (!shift) {
+		if (vector_type(pa) && !vector_type(pb))
+			b = splat(convert(b, pb, component_of(pa)), component_of(pa), pa);
+		else if (vector_type(pb) && !vector_type(pa))
+			a = splat(convert(a, pa, component_of(pb)), component_of(pb), pb), pa = pb;
+	} else if (vector_type(pa) && !vector_type(pb)) {
+		b = splat(b, pb, vector_of(component_of(pb), vector_component_count(pa)));
+	}
+
+	return emit_value(operation_code(operation.code, component_of(pa)), type, { a, b });
+}
+
+// Intrinsics, mostly through the GLSL.std.450 instruction set
+static uint32_t extended_instruction(IntrinsicOperation opn, PrimitiveType component, size_t arguments)
+{
+	bool floating = (component == f32);
+	bool sign = (component == i32);
+
+	switch (opn) {
+	case sin:
+		return 13;
+	case cos:
+		return 14;
+	case tan:
+		return 15;
+	case asin:
+		return 16;
+	case acos:
+		return 17;
+	case atan:
+		return (arguments == 2) ? 25 : 18;
+	case sinh:
+		return 19;
+	case cosh:
+		return 20;
+	case tanh:
+		return 21;
+	case pow:
+		return 26;
+	case exp:
+		return 27;
+	case log:
+		return 28;
+	case sqrt:
+		return 31;
+	case abs:
+		return floating ? 4 : 5;
+	case floor:
+		return 8;
+	case ceil:
+		return 9;
+	case fract:
+		return 10;
+	case min:
+		return floating ? 37 : (sign ? 39 : 38);
+	case max:
+		return floating ? 40 : (sign ? 42 : 41);
+	case clamp:
+		return floating ? 43 : (sign ? 45 : 44);
+	case mix:
+		return 46;
+	case smoothstep:
+		return 49;
+	case length:
+		return 66;
+	case cross:
+		return 68;
+	case normalize:
+		return 69;
+	case reflect:
+		return 71;
+	default:
+		break;
+	}
+
+	JVL_ABORT("{} intrinsic is unsupported by the SPIR-V backend", tbl_intrinsic_operation[opn]);
+}
+
+uint32_t spirv_function_generator_t::generate_intrinsic(const Intrinsic &intrinsic, Index i)
+{
+	auto args = expand_list(intrinsic.args);
+
+	switch (intrinsic.opn) {
+
+	// Handled by the linkage unit
+	case layout_local_size:
+	case layout_mesh_shader_sizes:
+		return 0;
+
+	case discard:
+		emit(spv::OpKill, {});
+		terminated = true;
+		return 0;
+
+	case glsl_barrier:
+	{
+		// Workgroup execution and memory scopes, with
+		// acquire-release semantics on workgroup memory
+		uint32_t scope = module.constant_u32(2);
+		uint32_t semantics = module.constant_u32(0x108);
+		emit(spv::OpControlBarrier, { scope, scope, semantics });
+		return 0;
+	}
+
+	default:
+		break;
+	}
+
+	uint32_t type = this->type(types[i]);
+	auto result = primitive(i);
+
+	std::vector <uint32_t> operands;
+	for (auto j : args)
+		operands.push_back(value(j));
+
+	switch (intrinsic.opn) {
+
+	case cast_to_int:
+	case cast_to_ivec2:
+	case cast_to_ivec3:
+	case cast_to_ivec4:
+	case cast_to_uint:
+	case cast_to_uvec2:
+	case cast_to_uvec3:
+	case cast_to_uvec4:
+	case cast_to_float:
+	case cast_to_vec2:
+	case cast_to_vec3:
+	case cast_to_vec4:
+	case cast_to_uint64:
+		return convert(operands[0], primitive(args[0]), result);
+
+	case glsl_floatBitsToInt:
+	case glsl_floatBitsToUint:
+	case glsl_intBitsToFloat:
+	case glsl_uintBitsToFloat:
+		return emit_value(spv::OpBitcast, type, { operands[0] });
+
+	case glsl_dFdx:
+		return emit_value(spv::OpDPdx, type, { operands[0] });
+	case glsl_dFdy:
+		return emit_value(spv::OpDPdy, type, { operands[0] });
+	case glsl_dFdxFine:
+		module.capabilities.insert(spv::DerivativeControl);
+		return emit_value(spv::OpDPdxFine, type, { operands[0] });
+	case glsl_dFdyFine:
+		module.capabilities.insert(spv::DerivativeControl);
+		return emit_value(spv::OpDPdyFine, type, { operands[0] });
+
+	case dot:
+		return emit_value(spv::OpDot, type, operands);
+
+	default:
+		break;
+	}
+
+	// Scalar arguments are broadcast for vector results
+	for (size_t j = 0; j < args.size(); j++)
+		operands[j] = splat(operands[j], primitive(args[j]), result);
+
+	auto component = component_of(primitive(args[0]));
+
+	if (intrinsic.opn == mod) {
+		auto op = operation_code(modulus, component);
+		return emit_value(op, type, operands);
+	}
+
+	uint32_t instruction = extended_instruction(intrinsic.opn, component, args.size());
+
+	operands.insert(operands.begin(), { module.glsl_std_450, instruction });
+
+	return emit_value(spv::OpExtInst, type, operands);
+}
+
+// Constructors
+uint32_t spirv_function_generator_t::generate_construct(const Construct &constructor, Index i)
+{
+	if (constructor.mode == global)
+		return value(constructor.type);
+
+	uint32_t type = this->type(types[i]);
+	if (constructor.args == -1)
+		return module.constant_null(type);
+
+	auto args = expand_list(constructor.args);
+
+	auto qt = resolve(types[i]);
+	if (!qt.is_primitive()) {
+		std::vector <uint32_t> operands;
+		for (auto j : args)
+			operands.push_back(value(j));
+
+		return emit_value(spv::OpCompositeConstruct, type, operands);
+	}
+
+	auto result = qt.as <PlainDataType> ().as <PrimitiveType> ();
+	auto component = component_of(result);
+
+	// Scalars and splatting
+	if (args.size() == 1) {
+		auto pa = primitive(args[0]);
+		if (!matrix_type(result) || vector_type(pa) || matrix_type(pa))
+			return convert(value(args[0]), pa, result);
+	}
+
+	if (matrix_type(result)) {
+		auto [column, count] = matrix_columns(result);
+		size_t rows = vector_component_count(column);
+		uint32_t ctype = module.type_primitive(column);
+
+		std::vector <uint32_t> scalars;
+		if (args.size() == 1) {
+			// Diagonal matrices
+			uint32_t diagonal = convert(value(args[0]), primitive(args[0]), f32);
+
+			Primitive zero;
+			zero.type = f32;
+			zero.fdata = 0.0f;
+
+			for (size_t c = 0; c < count; c++) {
+				for (size_t r = 0; r < rows; r++)
+					scalars.push_back((c == r) ? diagonal : module.constant(zero));
+			}
+		} else if (args.size() == count) {
+			std::vector <uint32_t> columns;
+			for (auto j : args)
+				columns.push_back(convert(value(j), primitive(j), column));
+
+			return emit_value(spv::OpCompositeConstruct, type, columns);
+		} else {
+			for (auto j : args)
+				scalars.push_back(convert(value(j), primitive(j), f32));
+		}
+
+		JVL_ASSERT(scalars.size() == count * rows,
+			"invalid number of arguments for {} constructor",
+			tbl_primitive_types[result]);
+
+		std::vector <uint32_t> columns;
+		for (size_t c = 0; c < count; c++) {
+			auto begin = scalars.begin() + c * rows;
+			std::vector <uint32_t> column_scalars(begin, begin + rows);
+			columns.push_back(emit_value(spv::OpCompositeConstruct, ctype, column_scalars));
+		}
+
+		return emit_value(spv::OpCompositeConstruct, type, columns);
+	}
+
+	// Vectors from scalars and smaller vectors
+	std::vector <uint32_t> operands;
+	for (auto j : args) {
+		auto pj = primitive(j);
+		auto target = vector_of(component, std::max <size_t> (vector_component_count(pj), 1));
+		operands.push_back(convert(value(j), pj, target));
+	}
+
+	return emit_value(spv::OpCompositeConstruct, type, operands);
+}
+
+// Calling other functions in the unit
+uint32_t spirv_function_generator_t::generate_call(const Call &call, Index i)
+{
+	auto &unit = module.unit;
+
+	JVL_ASSERT(unit.loaded.contains(call.cid), "callable ${} is not part of the linkage unit", call.cid);
+
+	uint32_t index = unit.loaded.at(call.cid);
+	auto &callee = unit.functions[index];
+
+	auto args = expand_list(call.args);
+
+	std::vector <uint32_t> operands { module.functions[index] };
+	for (size_t j = 0; j < args.size(); j++) {
+		auto &qt = callee.args[j];
+		if (qt.is <OutArgType> () || qt.is <InOutArgType> ()) {
+			auto ptr = address(args[j]);
+			JVL_ASSERT(ptr && ptr->storage == spv::Function,
+				"output arguments must be local variables in the SPIR-V backend");
+
+			operands.push_back(ptr->id);
+		} else {
+			operands.push_back(value(args[j]));
+		}
+	}
+
+	uint32_t result = emit_value(spv::OpFunctionCall, type(types[i]), operands);
+
+	// Callees may write through their arguments
+	cache.clear();
+
+	return result;
+}
+
+// Per-atom generator
+template <>
+void spirv_function_generator_t::generate(const Qualifier &, Index)
+{
+	// Global variables are declared on first use
+}
+
+template <>
+void spirv_function_generator_t::generate(const TypeInformation &, Index)
+{
+	// Types are generated on demand
+}
+
+template <>
+void spirv_function_generator_t::generate(const List &, Index)
+{
+	// Lists are expanded by their users
+}
+
+template <>
+void spirv_function_generator_t::generate(const Primitive &primitive, Index index)
+{
+	if (locals.contains(index))
+		store(locals[index], index, module.constant(primitive));
+}
+
+template <>
+void spirv_function_generator_t::generate(const Operation &, Index index)
+{
+	define(index);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Swizzle &, Index index)
+{
+	define(index);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Load &, Index index)
+{
+	define(index);
+}
+
+template <>
+void spirv_function_generator_t::generate(const ArrayAccess &, Index index)
+{
+	define(index);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Intrinsic &intrinsic, Index index)
+{
+	auto qt = resolve(types[index]);
+
+	bool voided = qt.is <NilType> ();
+	if (auto pd = qt.get <PlainDataType> ()) {
+		if (auto p = pd->get <PrimitiveType> ())
+			voided |= (p == none);
+	}
+
+	if (voided || side_effects(intrinsic.opn))
+		generate_intrinsic(intrinsic, index);
+	else
+		define(index);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Construct &constructor, Index index)
+{
+	if (locals.contains(index)) {
+		// Declarations without initial values
+		if (constructor.mode != global && constructor.args == -1)
+			return;
+
+		return define(index);
+	}
+
+	if (constructor.mode == global)
+		return;
+
+	define(index);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Call &call, Index index)
+{
+	if (call.type >= 0)
+		define(index);
+	else
+		generate_call(call, index);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Storage &, Index)
+{
+	// Allocated with the rest of the local variables
+}
+
+template <>
+void spirv_function_generator_t::generate(const Store &store, Index)
+{
+	uint32_t src = value(store.src);
+
+	auto dst = address(store.dst);
+	JVL_ASSERT(dst.has_value(), "store destination (@{}) is not addressable", store.dst);
+
+	this->store(dst.value(), store.dst, src);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Branch &branch, Index)
+{
+	this->branch(branch);
+}
+
+template <>
+void spirv_function_generator_t::generate(const Return &returns, Index)
+{
+	if (returns.value >= 0)
+		emit(spv::OpReturnValue, { value(returns.value) });
+	else
+		emit(spv::OpReturn, {});
+
+	terminated = true;
+}
+
+// Structured control flow
+void spirv_function_generator_t::branch(const Branch &branch)
+{
+	auto innermost_loop = [&]() -> construct & {
+		for (auto it = constructs.rbegin(); it != constructs.rend(); it++) {
+			if (it->kind == loop_while)
+				return *it;
+		}
+
+		JVL_ABORT("control flow statement outside of a loop");
+	};
+
+	switch (branch.kind) {
+
+	case conditional_if:
+	case conditional_else_if:
+	{
+		bool chained = (branch.kind == conditional_else_if);
+		if (chained) {
+			JVL_ASSERT(constructs.size() && constructs.back().next,
+				"else-if branch without a preceding if");
+
+			auto &previous = constructs.back();
+			jump(previous.merge);
+			label(previous.next);
+			previous.next = 0;
+		}
+
+		uint32_t cond = value(branch.cond);
+
+		construct selection {
+			.kind = conditional_if,
+			.merge = module.id(),
+			.next = module.id(),
+			.header = 0,
+			.continuing = 0,
+			.chained = chained,
+		};
+
+		uint32_t then = module.id();
+
+		emit(spv::OpSelectionMerge, { selection.merge, 0 });
+		emit(spv::OpBranchConditional, { cond, then, selection.next });
+		terminated = true;
+
+		label(then);
+
+		constructs.push_back(selection);
+	} break;
+
+	case conditional_else:
+	{
+		JVL_ASSERT(constructs.size() && constructs.back().next,
+			"else branch without a preceding if");
+
+		auto &previous = constructs.back();
+		jump(previous.merge);
+		label(previous.next);
+		previous.next = 0;
+	} break;
+
+	case loop_while:
+	case loop_for:
+	{
+		construct loop {
+			.kind = loop_while,
+			.merge = module.id(),
+			.next = 0,
+			.header = module.id(),
+			.continuing = module.id(),
+			.chained = false,
+		};
+
+		uint32_t check = module.id();
+		uint32_t body = module.id();
+
+		jump(loop.header);
+		label(loop.header);
+
+		emit(spv::OpLoopMerge, { loop.merge, loop.continuing, 0 });
+		emit(spv::OpBranch, { check });
+		terminated = true;
+
+		// Conditions are evaluated again on every iteration
+		label(check);
+
+		uint32_t cond = value(branch.cond);
+		emit(spv::OpBranchConditional, { cond, body, loop.merge });
+		terminated = true;
+
+		label(body);
+
+		constructs.push_back(loop);
+	} break;
+
+	case control_flow_skip:
+		jump(innermost_loop().continuing);
+		break;
+
+	case control_flow_stop:
+		jump(innermost_loop().merge);
+		break;
+
+	case control_flow_end:
+	{
+		JVL_ASSERT(constructs.size(), "end of control flow without an open construct");
+
+		auto current = constructs.back();
+		constructs.pop_back();
+
+		if (current.kind == loop_while) {
+			jump(current.continuing);
+			label(current.continuing);
+			jump(current.header);
+			label(current.merge);
+			break;
+		}
+
+		while (true) {
+			jump(current.merge);
+
+			if (current.next) {
+				label(current.next);
+				jump(current.merge);
+			}
+
+			label(current.merge);
+
+			if (!current.chained)
+				break;
+
+			// Else-if branches are nested selections
+			current = constructs.back();
+			constructs.pop_back();
+		}
+	} break;
+
+	default:
+		JVL_ABORT("failed to generate SPIR-V for branch: {}", branch);
+	}
+}
+
+void spirv_function_generator_t::generate(Index i)
+{
+	auto ftn = [&](auto atom) { return generate(atom, i); };
+	return std::visit(ftn, atoms[i]);
+}
+
+// Wholistic generation
+void spirv_function_generator_t::generate()
+{
+	// Variables are needed for everything that is written to
+	std::set <Index> written;
+
+	auto lvalue = [&](Index i) {
+		Index root = reference_of(i);
+		for (Index j = i; j != root; ) {
+			lvalues.insert(j);
+			if (auto load = atoms[j].get <Load> ())
+				j = load->src;
+			else if (auto access = atoms[j].get <ArrayAccess> ())
+				j = access->src;
+			else
+				j = atoms[j].as <Swizzle> ().src;
+		}
+
+		written.insert(root);
+	};
+
+	for (size_t i = 0; i < pointer; i++) {
+		auto &atom = atoms[i];
+
+		if (auto store = atom.get <Store> ())
+			lvalue(store->dst);
+
+		if (atom.is <Storage> ())
+			written.insert(i);
+
+		if (auto call = atom.get <Call> ()) {
+			auto &unit = module.unit;
+			if (!unit.loaded.contains(call->cid))
+				continue;
+
+			auto &callee = unit.functions[unit.loaded.at(call->cid)];
+
+			auto args = expand_list(call->args);
+			for (size_t j = 0; j < args.size(); j++) {
+				auto &qt = callee.args[j];
+				if (qt.is <OutArgType> () || qt.is <InOutArgType> ())
+					lvalue(args[j]);
+			}
+		}
+	}
+
+	// Signature of the function
+	uint32_t returns = type(function.returns);
+
+	std::vector <uint32_t> signature { returns };
+	for (auto &qt : function.args) {
+		uint32_t arg = type(qt);
+		if (qt.is <OutArgType> () || qt.is <InOutArgType> ())
+			arg = module.type_pointer(spv::Function, arg);
+
+		signature.push_back(arg);
+		parameters.push_back(module.id());
+	}
+
+	for (Index i : written) {
+		auto &atom = atoms[i];
+
+		// Global variables and output parameters are already addressable
+		Index root = i;
+		if (auto constructor = atom.get <Construct> (); constructor && constructor->mode == global)
+			root = constructor->type;
+
+		if (auto qualifier = atoms[root].get <Qualifier> ()) {
+			if (qualifier->kind != parameter)
+				continue;
+
+			auto &qt = function.args[qualifier->numerical];
+			if (qt.is <OutArgType> () || qt.is <InOutArgType> ())
+				continue;
+		}
+
+		locals[i] = spirv_pointer(local(type(types[i])), spv::Function, plain);
+	}
+
+	for (size_t i = 0; i < pointer; i++) {
+		if (marked.contains(i) || decorations.materialize.contains(i) || locals.contains(i))
+			generate(i);
+	}
+
+	JVL_ASSERT(constructs.empty(), "unterminated control flow in function '{}'", function.name);
+
+	if (!terminated) {
+		if (resolve(function.returns).is <NilType> ())
+			emit(spv::OpReturn, {});
+		else
+			emit(spv::OpUnreachable, {});
+	}
+
+	// Assemble the function
+	auto &code = module.code;
+
+	uint32_t id = module.functions[&function - module.unit.functions.data()];
+	uint32_t ftype = module.intern(spv::OpTypeFunction, signature);
+
+	module.emit(code, spv::OpFunction, { returns, id, 0, ftype });
+	for (size_t j = 0; j < parameters.size(); j++)
+		module.emit(code, spv::OpFunctionParameter, { signature[j + 1], parameters[j] });
+
+	module.emit(code, spv::OpLabel, { module.id() });
+
+	code.insert(code.end(), variables.begin(), variables.end());
+	code.insert(code.end(), body.begin(), body.end());
+
+	module.emit(code, spv::OpFunctionEnd, {});
+
+	auto name = module.literal(function.name);
+	name.insert(name.begin(), id);
+	module.emit(module.names, spv::OpName, name);
+}
+
+} // namespace jvl::thunder::detail
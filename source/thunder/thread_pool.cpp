@@ -0,0 +1,101 @@
+#include <algorithm>
+
+#include "thunder/thread_pool.hpp"
+
+namespace jvl::thunder {
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	threads = std::max <size_t> (threads, 1);
+
+	for (size_t i = 0; i < threads; i++)
+		queues.emplace_back(std::make_unique <worker_queue_t> ());
+
+	for (size_t i = 0; i < threads; i++)
+		workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard guard(mutex);
+		stopping = true;
+	}
+
+	available.notify_all();
+
+	// Workers drain the remaining tasks before exiting
+	for (auto &worker : workers)
+		worker.join();
+}
+
+size_t ThreadPool::size() const
+{
+	return workers.size();
+}
+
+// Own tasks are taken from the back, stolen ones from the front
+std::optional <ThreadPool::task_t> ThreadPool::pop(size_t index)
+{
+	size_t count = queues.size();
+	for (size_t k = 0; k < count; k++) {
+		auto &queue = *queues[(index + k) % count];
+
+		std::lock_guard guard(queue.mutex);
+		if (queue.tasks.empty())
+			continue;
+
+		task_t task;
+		if (k == 0) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		} else {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+
+		pending--;
+		return task;
+	}
+
+	return std::nullopt;
+}
+
+void ThreadPool::push(task_t task)
+{
+	{
+		std::lock_guard guard(mutex);
+		pending++;
+	}
+
+	auto &queue = *queues[next++ % queues.size()];
+	{
+		std::lock_guard guard(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	available.notify_one();
+}
+
+void ThreadPool::run(size_t index)
+{
+	while (true) {
+		if (auto task = pop(index)) {
+			task.value()();
+			continue;
+		}
+
+		std::unique_lock lock(mutex);
+		available.wait(lock, [&]() { return stopping || pending > 0; });
+		if (stopping && pending == 0)
+			return;
+	}
+}
+
+ThreadPool &ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+} // namespace jvl::thunder
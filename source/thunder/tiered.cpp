@@ -0,0 +1,84 @@
+#include "common/logging.hpp"
+
+#include "thunder/gcc_jit_generator.hpp"
+#include "thunder/tiered.hpp"
+
+namespace jvl::thunder {
+
+MODULE(tiered);
+
+CompiledProcedure::CompiledProcedure(const LinkageUnit &unit_, const TieredOptions &options_)
+		: unit(unit_), interpreter(unit), options(options_), compilable(true)
+{
+	for (auto &function : unit.functions)
+		compilable &= detail::gcc_jit_supported(function);
+
+	if (!compilable)
+		JVL_INFO("procedure cannot be compiled with gcc-jit, staying in the interpreter");
+
+	if (options.threshold == 0)
+		promote();
+}
+
+// Compilation refers to the unit, so it must finish first
+CompiledProcedure::~CompiledProcedure()
+{
+	std::lock_guard guard(mutex);
+	if (compilation.valid())
+		compilation.wait();
+}
+
+// Starts compiling on a background thread, at most once
+void CompiledProcedure::promote()
+{
+	if (!compilable)
+		return;
+
+	std::lock_guard guard(mutex);
+	if (started.exchange(true))
+		return;
+
+	JVL_INFO("compiling procedure after {} interpreted invocations",
+		counter.load(std::memory_order_relaxed));
+
+	compilation = std::async(std::launch::async, [this]() {
+		native.store(unit.generate_jit_gcc(options.jit), std::memory_order_release);
+	}).share();
+}
+
+Tier CompiledProcedure::tier() const
+{
+	if (native.load(std::memory_order_acquire))
+		return Tier::native;
+
+	if (started.load(std::memory_order_acquire))
+		return Tier::compiling;
+
+	return Tier::interpreted;
+}
+
+size_t CompiledProcedure::invocations() const
+{
+	return counter.load(std::memory_order_relaxed);
+}
+
+void *CompiledProcedure::function() const
+{
+	return native.load(std::memory_order_acquire);
+}
+
+void CompiledProcedure::wait()
+{
+	promote();
+
+	std::shared_future <void> pending;
+	{
+		std::lock_guard guard(mutex);
+		pending = compilation;
+	}
+
+	if (pending.valid())
+		pending.get();
+}
+
+} // namespace jvl::thunder
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 #include "common/logging.hpp"
 #include "common/io.hpp"
 
@@ -14,91 +18,105 @@ TrackedBuffer::cache_t &TrackedBuffer::cache()
 	return cache;
 }
 
+TrackedBuffer::cache_shard_t &TrackedBuffer::cache_shard(int32_t cid)
+{
+	return cache()[size_t(cid) % cache_shards];
+}
+
 void TrackedBuffer::cache_display()
 {
-	JVL_INFO("cached buffers:");
-	for (auto &[k, entry] : cache()) {
-		fmt::println("\t{} -> ({}, {}, {})",
-			k, entry.count,
-			entry.buffer.name,
-			(void *) entry.link);
+	std::map <int32_t, std::string> lines;
+	for (auto &shard : cache()) {
+		std::shared_lock lock(shard.mutex);
+		for (auto &[k, entry] : shard.entries) {
+			lines[k] = fmt::format("\t{} -> ({}, {}, {})",
+				k, entry.count,
+				entry.buffer->name,
+				(void *) entry.buffer.get());
+		}
 	}
+
+	JVL_INFO("cached buffers:");
+	for (auto &[k, line] : lines)
+		fmt::println("{}", line);
 }
-	
-const NamedBuffer &TrackedBuffer::cache_load(int32_t cid)
+
+Snapshot TrackedBuffer::cache_load(int32_t cid)
 {
-	auto &c = cache();
-	if (c.contains(cid)) {
-		auto &entry = c[cid];
-		if (entry.link)
-			return *entry.link;
-		else
-			return c[cid].buffer;
-	}
+	auto &shard = cache_shard(cid);
+
+	std::shared_lock lock(shard.mutex);
+
+	auto it = shard.entries.find(cid);
+	if (it != shard.entries.end())
+		return it->second.buffer;
 
 	JVL_ABORT("no tracked buffer cache entry @{}", cid);
 }
 
 void TrackedBuffer::cache_increment(int32_t cid)
 {
-	auto &c = cache();
-	c[cid].count++;
+	auto &shard = cache_shard(cid);
+
+	std::unique_lock lock(shard.mutex);
+	shard.entries[cid].count++;
 }
 
 void TrackedBuffer::cache_decrement(int32_t cid)
 {
-	auto &c = cache();
+	auto &shard = cache_shard(cid);
 
-	JVL_ASSERT(c.contains(cid), "no tracked buffer cache entry @{}", cid);
-	if (--c[cid].count <= 0) {
-		auto p = c[cid];
-		JVL_INFO("offloading cache entry '{}' (@{})", p.buffer.name, cid);
-		c.erase(cid);
-	}
-}
+	std::unique_lock lock(shard.mutex);
 
-void TrackedBuffer::cache_unlink(int32_t cid)
-{
-	auto &c = cache();
-	auto &entry = c[cid];
-
-	// Transfer linked buffer, then "destroy" it
-	if (entry.link) {
-		entry.buffer = *entry.link;
-		entry.link = nullptr;
+	auto it = shard.entries.find(cid);
+	JVL_ASSERT(it != shard.entries.end(), "no tracked buffer cache entry @{}", cid);
+	if (--it->second.count <= 0) {
+		JVL_INFO("offloading cache entry '{}' (@{})", it->second.buffer->name, cid);
+		shard.entries.erase(it);
 	}
 }
 
 void TrackedBuffer::cache_insert(const TrackedBuffer *tb)
 {
-	auto &c = cache();
-	c[tb->cid] = cache_entry_t(1, *tb, static_cast <const NamedBuffer *> (tb));
+	auto &shard = cache_shard(tb->cid);
+
+	std::unique_lock lock(shard.mutex);
+
+	// Re-inserting (e.g. after optimization) keeps the references
+	auto &entry = shard.entries[tb->cid];
+	entry.count = std::max(entry.count, 1);
+	entry.buffer = tb->snapshot;
 }
 
 // Track buffer methods
 TrackedBuffer::TrackedBuffer()
 {
-	static size_t id = 0;
+	static std::atomic <int32_t> id = 0;
 
-	cid = id++;
-	name = fmt::format("callable{}", cid);
+	cid = id.fetch_add(1, std::memory_order_relaxed);
+
+	auto buffer = std::make_shared <NamedBuffer> ();
+	buffer->name = fmt::format("callable{}", cid);
+	snapshot = buffer;
 
 	cache_insert(this);
 }
 
 TrackedBuffer::TrackedBuffer(const TrackedBuffer &other)
+		: cid(other.cid), snapshot(other.snapshot)
 {
-	*this = other;
+	cache_increment(cid);
 }
 
 TrackedBuffer &TrackedBuffer::operator=(const TrackedBuffer &other)
 {
 	if (this != &other) {
-		NamedBuffer::operator=(other);
+		// Acquire before releasing, in case both share an entry
+		cache_increment(other.cid);
+		cache_decrement(cid);
 
-		// Replace with the most recent tracked version
 		cid = other.cid;
-		cache_increment(cid);
+		snapshot = other.snapshot;
 	}
 
 	return *this;
@@ -106,22 +124,50 @@ TrackedBuffer &TrackedBuffer::operator=(const TrackedBuffer &other)
 
 TrackedBuffer::~TrackedBuffer()
 {
-	// Unlink; by now the buffer should have its contents
-	cache_unlink(cid);
-	
 	cache_decrement(cid);
 }
 
+const NamedBuffer &TrackedBuffer::operator*() const
+{
+	return *snapshot;
+}
+
+const NamedBuffer *TrackedBuffer::operator->() const
+{
+	return snapshot.get();
+}
+
+TrackedBuffer::operator const NamedBuffer &() const
+{
+	return *snapshot;
+}
+
+NamedBuffer &TrackedBuffer::edit()
+{
+	// Contents are only ever created as mutable buffers, so an
+	// unshared snapshot can be modified in place
+	if (snapshot.use_count() > 1)
+		snapshot = std::make_shared <NamedBuffer> (*snapshot);
+
+	return const_cast <NamedBuffer &> (*snapshot);
+}
+
+void TrackedBuffer::publish() const
+{
+	cache_insert(this);
+}
+
 void TrackedBuffer::display_assembly() const
 {
-	fmt::println("{}:", name);
-	Buffer::display_assembly();
+	fmt::println("{}:", snapshot->name);
+	snapshot->display_assembly();
 }
 
 void TrackedBuffer::display_pretty() const
 {
-	jvl::io::header(fmt::format("TRACKED BUFFER ${} ({}/{})", name, pointer, atoms.size()), 50);
-	Buffer::display_pretty();
+	jvl::io::header(fmt::format("TRACKED BUFFER ${} ({}/{})",
+		snapshot->name, snapshot->pointer, snapshot->atoms.size()), 50);
+	snapshot->display_pretty();
 }
 
 } // namespace jvl::thunder
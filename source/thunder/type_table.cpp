@@ -0,0 +1,156 @@
+#include <limits>
+
+#include "common/logging.hpp"
+
+#include "thunder/type_table.hpp"
+
+namespace jvl::thunder {
+
+MODULE(type-table);
+
+TypeTable::TypeTable(size_t size) : entries(1, NilType()), ids(size, nil) {}
+
+const QualifiedType &TypeTable::operator[](size_t i) const
+{
+	return entries[ids[i]];
+}
+
+TypeId TypeTable::id(size_t i) const
+{
+	return ids[i];
+}
+
+void TypeTable::assign(size_t i, const QualifiedType &qt)
+{
+	ids[i] = intern(qt);
+}
+
+void TypeTable::resize(size_t size)
+{
+	ids.resize(size, nil);
+}
+
+size_t TypeTable::size() const
+{
+	return ids.size();
+}
+
+// Kind of the type, then whether the plain data is concrete, its
+// primitive or concrete index, and the extra index of the kind
+uint64_t TypeTable::key(const QualifiedType &qt)
+{
+	constexpr size_t bits = 8 * sizeof(Index);
+
+	auto plain = [](const PlainDataType &pd) -> uint64_t {
+		if (auto p = pd.get <PrimitiveType> ())
+			return uint16_t(*p);
+
+		return (uint64_t(1) << bits) | TypeId(pd.as <Index> ());
+	};
+
+	uint64_t data = 0;
+	uint64_t extra = 0;
+
+	switch (qt.index()) {
+
+	variant_case(QualifiedType, PlainDataType):
+		data = plain(qt.as <PlainDataType> ());
+		break;
+
+	variant_case(QualifiedType, StructFieldType):
+		data = plain(qt.as <StructFieldType> ());
+		extra = TypeId(qt.as <StructFieldType> ().next);
+		break;
+
+	variant_case(QualifiedType, ArrayType):
+		data = plain(qt.as <ArrayType> ());
+		extra = TypeId(qt.as <ArrayType> ().size);
+		break;
+
+	variant_case(QualifiedType, ImageType):
+		data = plain(qt.as <ImageType> ());
+		extra = TypeId(qt.as <ImageType> ().dimension);
+		break;
+
+	variant_case(QualifiedType, SamplerType):
+		data = plain(qt.as <SamplerType> ());
+		extra = TypeId(qt.as <SamplerType> ().dimension);
+		break;
+
+	variant_case(QualifiedType, IntrinsicType):
+		data = TypeId(qt.as <IntrinsicType> ().kind);
+		break;
+
+	variant_case(QualifiedType, BufferReferenceType):
+		data = plain(qt.as <BufferReferenceType> ());
+		extra = TypeId(qt.as <BufferReferenceType> ().unique);
+		break;
+
+	variant_case(QualifiedType, InArgType):
+		data = plain(qt.as <InArgType> ());
+		break;
+
+	variant_case(QualifiedType, OutArgType):
+		data = plain(qt.as <OutArgType> ());
+		break;
+
+	variant_case(QualifiedType, InOutArgType):
+		data = plain(qt.as <InOutArgType> ());
+		break;
+
+	default:
+		break;
+	}
+
+#ifdef JVL_WIDE_INDEX
+	// Wide fields do not fit below the kind, so they are mixed instead
+	uint64_t fields = data ^ (extra * 0x9e3779b97f4a7c15ull);
+	fields = (fields ^ (fields >> 29)) & ((uint64_t(1) << 48) - 1);
+#else
+	uint64_t fields = data | (extra << (bits + 1));
+#endif
+
+	return (uint64_t(qt.index()) << 48) | fields;
+}
+
+TypeId TypeTable::intern(const QualifiedType &qt)
+{
+	if (!qt)
+		return nil;
+
+	uint64_t k = key(qt);
+
+	Index found = lookup.lookup(k);
+	if (found != -1 && entries[found] == qt)
+		return found;
+
+	// Only wide keys collide, and distinct types are few
+	if (found != -1) {
+		for (size_t id = 1; id < entries.size(); id++) {
+			if (entries[id] == qt)
+				return id;
+		}
+	}
+
+	JVL_ASSERT(entries.size() <= size_t(std::numeric_limits <Index> ::max()),
+		"type table overflow with {} interned types", entries.size());
+
+	TypeId id = entries.size();
+	entries.push_back(qt);
+	if (found == -1)
+		lookup.insert(k, id);
+
+	return id;
+}
+
+const QualifiedType &TypeTable::type(TypeId id) const
+{
+	return entries[id];
+}
+
+const std::vector <QualifiedType> &TypeTable::interned() const
+{
+	return entries;
+}
+
+} // namespace jvl::thunder
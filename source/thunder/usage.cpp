@@ -33,11 +33,59 @@ UsageSet usage(const Buffer &scratch, Index index)
 
 UsageGraph usage(const Buffer &scratch)
 {
+	UsageTable table = usage_table(scratch);
+
 	UsageGraph graph(scratch.pointer);
 	for (size_t i = 0; i < graph.size(); i++)
-		graph[i] = usage(scratch, i);
+		graph[i] = UsageSet(table.begin(i), table.end(i));
 
 	return graph;
 }
 
+// Only backward references are considered as usages, which also
+// excludes forward references such as branch failure targets
+[[gnu::always_inline]]
+inline bool backward(Index addr, size_t i)
+{
+	return (addr >= 0) && (size_t(addr) < i);
+}
+
+UsageTable usage_table(const Buffer &scratch)
+{
+	size_t n = scratch.pointer;
+
+	UsageTable table;
+	table.offsets.resize(n + 1, 0);
+
+	// Count users of each atom, shifted by one for the prefix sum
+	for (size_t i = 0; i < n; i++) {
+		Atom atom = scratch.atoms[i];
+
+		auto &&addresses = atom.addresses();
+		if (backward(addresses.a0, i))
+			table.offsets[addresses.a0 + 1]++;
+		if (backward(addresses.a1, i) && addresses.a1 != addresses.a0)
+			table.offsets[addresses.a1 + 1]++;
+	}
+
+	for (size_t i = 0; i < n; i++)
+		table.offsets[i + 1] += table.offsets[i];
+
+	// Scatter users, which preserves their ordering
+	std::vector <uint32_t> cursor(table.offsets.begin(), table.offsets.end() - 1);
+
+	table.users.resize(table.offsets[n]);
+	for (size_t i = 0; i < n; i++) {
+		Atom atom = scratch.atoms[i];
+
+		auto &&addresses = atom.addresses();
+		if (backward(addresses.a0, i))
+			table.users[cursor[addresses.a0]++] = i;
+		if (backward(addresses.a1, i) && addresses.a1 != addresses.a0)
+			table.users[cursor[addresses.a1]++] = i;
+	}
+
+	return table;
+}
+
 } // namespace jvl::thunder
@@ -1,5 +1,8 @@
 #include "util.hpp"
 
+#include <atomic>
+#include <thread>
+
 #include <ire.hpp>
 
 #include <common/io.hpp>
@@ -34,7 +37,8 @@ const std::string expected_arithmetic_glsl = R"(
 
 float arithmetic(float _arg0, float _arg1, float _arg2)
 {
-    return ((_arg0 + (_arg1 * _arg2)) / ((((_arg0 + (_arg1 * _arg2)) / (_arg0 - _arg1)) * _arg2) * _arg2));
+    float s0 = (_arg0 + (_arg1 * _arg2));
+    return (s0 / (((s0 / (_arg0 - _arg1)) * _arg2) * _arg2));
 }
 )";
 
@@ -74,10 +78,11 @@ const std::string expected_conditional_returns_glsl = R"(
 
 float conditional(float _arg0, float _arg1, float _arg2)
 {
-    if (((_arg0 + (_arg1 * _arg2)) < 0)) {
-        return ((_arg0 + (_arg1 * _arg2)) / ((((_arg0 + (_arg1 * _arg2)) / (_arg0 - _arg1)) * _arg2) * _arg2));
+    float s0 = (_arg0 + (_arg1 * _arg2));
+    if ((s0 < 0)) {
+        return (s0 / (((s0 / (_arg0 - _arg1)) * _arg2) * _arg2));
     }
-    return (_arg0 + (_arg1 * _arg2));
+    return s0;
 }
 )";
 
@@ -160,7 +165,8 @@ struct Seed {
 
 Seed shift_seed(Seed _arg0)
 {
-    return Seed(((_arg0.root << _arg0.shifted) & (_arg0.shifted | _arg0.root)), (_arg0.shifted | _arg0.root));
+    uint s0 = (_arg0.shifted | _arg0.root);
+    return Seed(((_arg0.root << _arg0.shifted) & s0), s0);
 }
 )";
 
@@ -188,4 +194,150 @@ TEST(callable, struct_return)
 	io::display_lines("STRUCT RETURN", glsl);
 
 	check_shader_sources(expected_struct_return_glsl, glsl);
-}
\ No newline at end of file
+}
+
+// Shared between the threads of the concurrent tracing test
+$subroutine(f32, shared_polynomial, f32 x) {
+	$return x * x + 1.0f;
+};
+
+static std::string trace_and_link()
+{
+	$subroutine(f32, permutation, f32 x, f32 y) {
+		f32 a = shared_polynomial(x) * y;
+		$if (a > 1.0f) {
+			a = a - shared_polynomial(y);
+		};
+
+		$return a;
+	};
+
+	return link(permutation).generate_glsl();
+}
+
+TEST(callable, concurrent_tracing)
+{
+	static constexpr size_t threads = 8;
+	static constexpr size_t iterations = 64;
+
+	auto entries = []() {
+		size_t count = 0;
+		for (auto &shard : thunder::TrackedBuffer::cache()) {
+			std::shared_lock lock(shard.mutex);
+			count += shard.entries.size();
+		}
+
+		return count;
+	};
+
+	std::string expected = trace_and_link();
+
+	size_t before = entries();
+
+	std::vector <std::vector <std::string>> results(threads);
+
+	std::vector <std::thread> pool;
+	for (size_t t = 0; t < threads; t++) {
+		pool.emplace_back([&, t]() {
+			for (size_t i = 0; i < iterations; i++)
+				results[t].push_back(trace_and_link());
+		});
+	}
+
+	for (auto &thread : pool)
+		thread.join();
+
+	for (auto &sources : results) {
+		ASSERT_EQ(sources.size(), iterations);
+		for (auto &glsl : sources)
+			ASSERT_EQ(glsl, expected);
+	}
+
+	// Every traced permutation must have been released
+	ASSERT_EQ(entries(), before);
+}
+
+TEST(callable, shared_snapshots)
+{
+	$subroutine(f32, smooth, f32 x) {
+		$return x * x * (3.0f - 2.0f * x);
+	};
+
+	// Copies and the cache share the traced contents
+	thunder::TrackedBuffer copy = smooth;
+	ASSERT_EQ(copy.snapshot, smooth.snapshot);
+	ASSERT_EQ(thunder::TrackedBuffer::cache_load(smooth.cid), smooth.snapshot);
+
+	auto unit = link(smooth);
+	ASSERT_EQ(unit.functions[0].snapshot, smooth.snapshot);
+
+	// Optimizing a copy leaves the original untouched
+	thunder::Optimizer optimizer { thunder::OptimizationFlags::eStable };
+	optimizer.apply(copy.edit());
+
+	ASSERT_NE(copy.snapshot, smooth.snapshot);
+	ASSERT_EQ(thunder::TrackedBuffer::cache_load(smooth.cid), smooth.snapshot);
+
+	// ...until it is published for the callable
+	copy.publish();
+	ASSERT_EQ(thunder::TrackedBuffer::cache_load(smooth.cid), copy.snapshot);
+}
+
+TEST(callable, concurrent_loads)
+{
+	static constexpr size_t readers = 4;
+	static constexpr size_t iterations = 256;
+
+	$subroutine(f32, ramp, f32 x) {
+		$return 2.0f * x - 1.0f;
+	};
+
+	// Loaded contents stay alive after the cache moves on
+	thunder::Snapshot orphan;
+	{
+		thunder::TrackedBuffer temporary = ramp;
+		temporary.edit().name = "temporary";
+		temporary.publish();
+		orphan = thunder::TrackedBuffer::cache_load(ramp.cid);
+		ramp.publish();
+	}
+
+	ASSERT_EQ(orphan->name, "temporary");
+	ASSERT_EQ(orphan->atoms.size(), ramp->atoms.size());
+
+	// Readers keep their snapshots while another thread
+	// keeps republishing different contents for the callable
+	std::atomic <bool> done = false;
+
+	std::thread writer([&]() {
+		thunder::TrackedBuffer copy = ramp;
+		for (size_t i = 0; !done; i++) {
+			copy.edit().name = fmt::format("ramp{}", i);
+			copy.publish();
+		}
+
+		ramp.publish();
+	});
+
+	std::vector <std::thread> pool;
+	std::vector <size_t> sizes(readers);
+	for (size_t t = 0; t < readers; t++) {
+		pool.emplace_back([&, t]() {
+			for (size_t i = 0; i < iterations; i++) {
+				auto snapshot = thunder::TrackedBuffer::cache_load(ramp.cid);
+				sizes[t] = std::max(sizes[t], snapshot->atoms.size());
+			}
+		});
+	}
+
+	for (auto &thread : pool)
+		thread.join();
+
+	done = true;
+	writer.join();
+
+	for (size_t size : sizes)
+		ASSERT_EQ(size, ramp->atoms.size());
+
+	ASSERT_EQ(thunder::TrackedBuffer::cache_load(ramp.cid), ramp.snapshot);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <ire.hpp>
+
+#include "thunder/cfg.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+// Block containing the n-th branch of the given kind
+thunder::Index branch_block(const thunder::Buffer &buffer,
+			    const thunder::ControlFlowGraph &cfg,
+			    thunder::BranchKind kind,
+			    size_t nth = 0)
+{
+	for (size_t i = 0; i < buffer.pointer; i++) {
+		auto branch = buffer.atoms[i].get <thunder::Branch> ();
+		if (branch && branch->kind == kind && nth-- == 0)
+			return cfg.block_of[i];
+	}
+
+	return -1;
+}
+
+std::vector <thunder::Index> collect(std::span <const thunder::Index> span)
+{
+	return { span.begin(), span.end() };
+}
+
+TEST(cfg, conditionals)
+{
+	$subroutine(f32, conditionals, f32 x) {
+		f32 r = 0.0f;
+		$if (x > 0.0f) {
+			r = 1.0f;
+		} $elif (x < 0.0f) {
+			r = 2.0f;
+		} $else {
+			r = 3.0f;
+		};
+
+		$return r;
+	};
+
+	auto cfg = thunder::control_flow_graph(conditionals);
+
+	auto b_if = branch_block(conditionals, cfg, thunder::conditional_if);
+	auto b_elif = branch_block(conditionals, cfg, thunder::conditional_else_if);
+	auto b_else = branch_block(conditionals, cfg, thunder::conditional_else);
+	auto b_end = branch_block(conditionals, cfg, thunder::control_flow_end);
+
+	using indices = std::vector <thunder::Index>;
+
+	ASSERT_EQ(collect(cfg.successors(b_if)), indices({ b_if + 1, b_elif }));
+	ASSERT_EQ(collect(cfg.successors(b_elif)), indices({ b_elif + 1, b_else }));
+	ASSERT_EQ(collect(cfg.successors(b_else)), indices({ b_else + 1 }));
+	ASSERT_EQ(collect(cfg.predecessors(b_end)), indices({ b_if + 1, b_elif + 1, b_else + 1 }));
+
+	// The join point is dominated by the first test, but not by any arm
+	ASSERT_EQ(cfg.idom[b_end], b_if);
+	ASSERT_TRUE(cfg.dominates(b_if, b_end));
+	ASSERT_FALSE(cfg.dominates(b_if + 1, b_end));
+	ASSERT_EQ(collect(cfg.frontier(b_if + 1)), indices({ b_end }));
+
+	// Each arm stores to the result, which merges at the join point
+	ASSERT_EQ(cfg.variables.size(), 1);
+	ASSERT_EQ(collect(cfg.phis(b_end)), indices({ 0 }));
+	ASSERT_TRUE(cfg.live_at_entry(b_end, 0));
+	ASSERT_FALSE(cfg.live_at_entry(b_if + 1, 0));
+}
+
+TEST(cfg, loops)
+{
+	$subroutine(i32, loops, i32 n) {
+		i32 s = 0;
+		$for (i, range(0, n)) {
+			$if (i == 3) {
+				$continue;
+			};
+
+			$if (s > 100) {
+				$break;
+			};
+
+			s += i;
+		};
+
+		$return s;
+	};
+
+	auto cfg = thunder::control_flow_graph(loops);
+
+	auto header = branch_block(loops, cfg, thunder::loop_while);
+	auto skip = branch_block(loops, cfg, thunder::control_flow_skip);
+	auto stop = branch_block(loops, cfg, thunder::control_flow_stop);
+
+	auto &branch = loops->atoms[cfg.last[header]].as <thunder::Branch> ();
+	auto end = cfg.block_of[branch.failto];
+	auto exit = end + 1;
+
+	using indices = std::vector <thunder::Index>;
+
+	ASSERT_EQ(collect(cfg.successors(end)), indices({ header }));
+	ASSERT_EQ(collect(cfg.successors(skip)), indices({ header }));
+	ASSERT_EQ(collect(cfg.successors(stop)), indices({ exit }));
+	ASSERT_EQ(collect(cfg.predecessors(exit)), indices({ header, stop }));
+
+	for (auto b : { skip, stop, end })
+		ASSERT_EQ(cfg.loop[b], header);
+
+	ASSERT_EQ(cfg.loop[exit], -1);
+	ASSERT_EQ(cfg.idom[exit], header);
+	ASSERT_TRUE(cfg.dominates(header, end));
+
+	// Both the accumulator and the induction variable merge at the header
+	ASSERT_EQ(cfg.variables.size(), 2);
+	ASSERT_EQ(cfg.phis(header).size(), 2);
+	for (size_t v = 0; v < cfg.variables.size(); v++)
+		ASSERT_TRUE(cfg.live_at_entry(header, v));
+}
+
+TEST(cfg, loop_conditions)
+{
+	// The variable is only read by the condition, which
+	// is evaluated again in the header on every iteration
+	$subroutine(i32, conditions, i32 n) {
+		i32 k = 0;
+		_while(k < n);
+			k = n;
+		_end();
+
+		$return k;
+	};
+
+	auto cfg = thunder::control_flow_graph(conditions);
+
+	auto header = branch_block(conditions, cfg, thunder::loop_while);
+
+	auto &branch = conditions->atoms[cfg.last[header]].as <thunder::Branch> ();
+	auto end = cfg.block_of[branch.failto];
+
+	using indices = std::vector <thunder::Index>;
+
+	ASSERT_EQ(collect(cfg.successors(end)), indices({ header }));
+
+	ASSERT_EQ(cfg.variables.size(), 1);
+	ASSERT_TRUE(cfg.live_at_entry(header, 0));
+	ASSERT_TRUE(cfg.live_at_exit(end, 0));
+	ASSERT_EQ(collect(cfg.phis(header)), indices({ 0 }));
+}
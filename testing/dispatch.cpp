@@ -0,0 +1,239 @@
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include <ire.hpp>
+
+#include "thunder/dispatch.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+TEST(dispatch, compute_loop)
+{
+	$entrypoint(kernel) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> input(1);
+		writeonly <buffer <unsized_array <f32>>> output(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+
+		f32 sum = 0.0f;
+		$for (i, range(0, 4)) {
+			$if (input[tid] > 1.0f) {
+				sum += sin(input[tid]);
+			} $else {
+				sum -= 1.0f;
+			};
+		};
+
+		output[tid] = sum + length(vec3(sum, 1, 2));
+	};
+
+	static constexpr size_t groups = 37;
+	static constexpr size_t count = 64 * groups;
+
+	std::vector <float> input(count);
+	std::vector <float> output(count, -1.0f);
+	for (size_t i = 0; i < count; i++)
+		input[i] = float(i % 17) / 8.0f;
+
+	thunder::DispatchBindings bindings;
+	bindings.buffers[0] = output.data();
+	bindings.buffers[1] = input.data();
+
+	thunder::dispatch(link(kernel), groups, 1, 1, bindings);
+
+	for (size_t i = 0; i < count; i++) {
+		float sum = 0.0f;
+		for (size_t k = 0; k < 4; k++)
+			sum += (input[i] > 1.0f) ? std::sin(input[i]) : -1.0f;
+
+		float expected = sum + std::sqrt(sum * sum + 5.0f);
+		ASSERT_NEAR(output[i], expected, 1e-5f) << "invocation " << i;
+	}
+}
+
+TEST(dispatch, builtins)
+{
+	$entrypoint(kernel) {
+		local_size(4, 2);
+
+		writeonly <buffer <unsized_array <u32>>> output(0);
+
+		uvec3 gid = gl_GlobalInvocationID;
+		u32 width = 4 * 5;
+
+		output[gid.y * width + gid.x] = gl_WorkGroupID.x * 1000
+			+ gl_WorkGroupID.y * 100
+			+ gl_LocalInvocationIndex * 10
+			+ gl_LocalInvocationID.y;
+	};
+
+	thunder::ComputeKernel compute(link(kernel));
+
+	ASSERT_EQ(compute.workgroup_size(), glm::uvec3(4, 2, 1));
+
+	static constexpr uint32_t gx = 5;
+	static constexpr uint32_t gy = 3;
+
+	std::vector <uint32_t> output(4 * gx * 2 * gy, 0);
+
+	thunder::DispatchBindings bindings;
+	bindings.buffers[0] = output.data();
+
+	compute.dispatch(gx, gy, 1, bindings);
+
+	for (uint32_t y = 0; y < 2 * gy; y++) {
+		for (uint32_t x = 0; x < 4 * gx; x++) {
+			uint32_t lx = x % 4;
+			uint32_t ly = y % 2;
+			uint32_t expected = (x / 4) * 1000 + (y / 2) * 100 + (ly * 4 + lx) * 10 + ly;
+			ASSERT_EQ(output[y * 4 * gx + x], expected) << "invocation (" << x << ", " << y << ")";
+		}
+	}
+}
+
+struct Scaling {
+	f32 scale;
+	u32 count;
+
+	auto layout() {
+		return layout_from("Scaling",
+			verbatim_field(scale),
+			verbatim_field(count));
+	}
+};
+
+TEST(dispatch, push_constants)
+{
+	$entrypoint(kernel) {
+		local_size(32);
+
+		push_constant <Scaling> pc;
+
+		buffer <unsized_array <f32>> data(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+		$if (tid < pc.count) {
+			data[tid] = data[tid] * pc.scale;
+		};
+	};
+
+	struct {
+		float scale;
+		uint32_t count;
+	} constants { 2.5f, 100 };
+
+	std::vector <float> data(128);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = float(i);
+
+	thunder::DispatchBindings bindings;
+	bindings.buffers[0] = data.data();
+	bindings.push_constants = &constants;
+
+	// Dispatching on a small pool, with more groups than workers
+	thunder::ThreadPool pool(2);
+	thunder::ComputeKernel(link(kernel)).dispatch(4, 1, 1, bindings, pool);
+
+	for (size_t i = 0; i < data.size(); i++)
+		ASSERT_FLOAT_EQ(data[i], (i < constants.count) ? 2.5f * i : float(i));
+}
+
+TEST(dispatch, shared_reduction)
+{
+	$entrypoint(kernel) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> input(0);
+		writeonly <buffer <unsized_array <f32>>> output(1);
+
+		shared <array <f32>> partial(64);
+
+		u32 local = gl_LocalInvocationIndex;
+		partial[local] = input[gl_GlobalInvocationID.x];
+		barrier();
+
+		// Tree reduction, halving the active invocations each step
+		u32 stride = 32;
+		$for (k, range(0, 6)) {
+			$if (local < stride) {
+				partial[local] = partial[local] + partial[local + stride];
+			};
+
+			barrier();
+			stride = stride / 2u;
+		};
+
+		$if (local == 0u) {
+			output[gl_WorkGroupID.x] = partial[0];
+		};
+	};
+
+	thunder::ComputeKernel compute(link(kernel));
+
+	static constexpr size_t groups = 50;
+
+	std::vector <float> input(64 * groups);
+	std::vector <float> output(groups, -1.0f);
+	for (size_t i = 0; i < input.size(); i++)
+		input[i] = float(i % 13) * 0.5f;
+
+	thunder::DispatchBindings bindings;
+	bindings.buffers[0] = input.data();
+	bindings.buffers[1] = output.data();
+
+	compute.dispatch(groups, 1, 1, bindings);
+
+	for (size_t g = 0; g < groups; g++) {
+		float expected = 0.0f;
+		for (size_t k = 0; k < 64; k++)
+			expected += input[64 * g + k];
+
+		ASSERT_FLOAT_EQ(output[g], expected) << "workgroup " << g;
+	}
+}
+
+TEST(dispatch, shared_transpose)
+{
+	static constexpr uint32_t width = 32;
+	static constexpr uint32_t height = 16;
+
+	$entrypoint(kernel) {
+		local_size(8, 8);
+
+		buffer <unsized_array <u32>> input(0);
+		writeonly <buffer <unsized_array <u32>>> output(1);
+
+		shared <array <u32>> tile(64);
+
+		u32 lx = gl_LocalInvocationID.x;
+		u32 ly = gl_LocalInvocationID.y;
+
+		tile[ly * 8u + lx] = input[gl_GlobalInvocationID.y * width + gl_GlobalInvocationID.x];
+		barrier();
+
+		// Each invocation writes an element loaded by another one
+		u32 x = gl_WorkGroupID.x * 8u + ly;
+		u32 y = gl_WorkGroupID.y * 8u + lx;
+		output[x * height + y] = tile[lx * 8u + ly];
+	};
+
+	std::vector <uint32_t> input(width * height);
+	std::vector <uint32_t> output(width * height, 0);
+	for (uint32_t i = 0; i < input.size(); i++)
+		input[i] = i * 7 + 3;
+
+	thunder::DispatchBindings bindings;
+	bindings.buffers[0] = input.data();
+	bindings.buffers[1] = output.data();
+
+	thunder::dispatch(link(kernel), width / 8, height / 8, 1, bindings);
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++)
+			ASSERT_EQ(output[x * height + y], input[y * width + x]) << "element (" << x << ", " << y << ")";
+	}
+}
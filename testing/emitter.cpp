@@ -10,18 +10,18 @@ MODULE(test-emitter);
 // Checking that certain operations appear in IR
 bool check_contents(const thunder::TrackedBuffer &ref, const thunder::TrackedBuffer &given)
 {
-	if (ref.pointer != given.pointer) {
+	if (ref->pointer != given->pointer) {
 		ref.display_assembly();
 		given.display_assembly();
 		return false;
 	}
 
-	for (size_t i = 0; i < ref.pointer; i++) {
-		if (ref[i] != given[i]) {
+	for (size_t i = 0; i < ref->pointer; i++) {
+		if ((*ref)[i] != (*given)[i]) {
 			ref.display_assembly();
 			given.display_assembly();
 			JVL_ERROR("generate buffer differs @{}:\n{}\nVersus:\n{}",
-				i, ref[i], given[i]);
+				i, (*ref)[i], (*given)[i]);
 			return false;
 		}
 	}
@@ -36,7 +36,7 @@ void synthesize_layout_io_inner()
 
 	// Generate code manually as a reference
 	thunder::TrackedBuffer ref_buffer;
-	ref_buffer.name = "Reference";
+	ref_buffer.edit().name = "Reference";
 
 	thunder::PrimitiveType p = thunder::boolean;
 	if constexpr (std::same_as <T, int32_t>)
@@ -46,7 +46,7 @@ void synthesize_layout_io_inner()
 	if constexpr (std::same_as <T, float>)
 		p = thunder::f32;
 
-	em.push(ref_buffer);
+	em.push(ref_buffer.edit());
 	{
 		using thunder::Index;
 
@@ -66,9 +66,9 @@ void synthesize_layout_io_inner()
 
 	// Generate code using the IRE
 	thunder::TrackedBuffer buffer;
-	buffer.name = "Generated";
+	buffer.edit().name = "Generated";
 
-	em.push(buffer);
+	em.push(buffer.edit());
 	{
 		layout_in <native_t <T>> lin(0);
 		layout_out <native_t <T>> lout(0);
@@ -99,4 +99,57 @@ TEST(emitter, synthesize_layout_io_bool)
 	synthesize_layout_io_inner <bool> ();
 }
 
+TEST(emitter, interning)
+{
+	auto &em = Emitter::active;
+
+	auto trace = [&](bool interning) {
+		em.interning = interning;
+
+		$subroutine(f32, literals, f32 x) {
+			f32 y = 1.0f;
+			y = 2.0f;
+
+			$if (x > 0.0f) {
+				y = 2.0f;
+			};
+
+			u64 z = uint64_t(1) << 40;
+			z = uint64_t(1) << 40;
+
+			$return y * x + y;
+		};
+
+		em.interning = false;
+
+		return literals;
+	};
+
+	auto plain = trace(false);
+	auto interned = trace(true);
+
+	ASSERT_LT(interned->pointer, plain->pointer);
+	ASSERT_EQ(link(plain).generate_glsl(), link(interned).generate_glsl());
+}
+
+TEST(emitter, interned_types)
+{
+	$subroutine(vec3, blend, vec3 a, vec3 b, f32 t) {
+		vec3 x = a * (1.0f - t);
+		vec3 y = b * t;
+		$return x + y;
+	};
+
+	auto &types = blend->types;
+
+	// Atoms share ids exactly when their types are equal
+	for (size_t i = 0; i < blend->pointer; i++) {
+		for (size_t j = 0; j < blend->pointer; j++)
+			ASSERT_EQ(types.id(i) == types.id(j), types[i] == types[j]);
+	}
+
+	ASSERT_LT(types.interned().size(), blend->pointer);
+	ASSERT_EQ(types.type(thunder::TypeTable::nil), thunder::QualifiedType());
+}
+
 // TODO: more tests...
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "thunder/buffer.hpp"
+#include "thunder/relocation.hpp"
+
+using namespace jvl;
+using namespace jvl::thunder;
+
+TEST(index_set, word_boundaries)
+{
+	IndexSet set;
+	for (Index i : { 0, 63, 64, 127, 200 })
+		ASSERT_TRUE(set.insert(i).second);
+
+	ASSERT_FALSE(set.insert(64).second);
+	ASSERT_EQ(set.size(), 5);
+
+	// Searches start mid-word and skip over empty words
+	ASSERT_EQ(set.next(0), 0);
+	ASSERT_EQ(set.next(1), 63);
+	ASSERT_EQ(set.next(64), 64);
+	ASSERT_EQ(set.next(65), 127);
+	ASSERT_EQ(set.next(128), 200);
+	ASSERT_EQ(set.next(201), set.end().position);
+	ASSERT_EQ(set.next(1000), set.end().position);
+
+	std::vector <Index> visited(set.begin(), set.end());
+	ASSERT_EQ(visited, (std::vector <Index> { 0, 63, 64, 127, 200 }));
+
+	ASSERT_FALSE(set.contains(-1));
+	ASSERT_FALSE(set.contains(65));
+	ASSERT_FALSE(set.contains(4096));
+}
+
+TEST(index_set, erase)
+{
+	IndexSet set;
+	for (Index i = 0; i < 130; i += 2)
+		set.insert(i);
+
+	ASSERT_EQ(set.size(), 65);
+
+	ASSERT_EQ(set.erase(64), 1);
+	ASSERT_EQ(set.erase(64), 0);
+	ASSERT_EQ(set.erase(65), 0);
+	ASSERT_EQ(set.erase(1000), 0);
+	ASSERT_EQ(set.size(), 64);
+
+	ASSERT_FALSE(set.contains(64));
+	ASSERT_EQ(set.next(63), 66);
+
+	// Emptying every word keeps iteration at the end
+	for (Index i = 0; i < 130; i += 2)
+		set.erase(i);
+
+	ASSERT_TRUE(set.empty());
+	ASSERT_EQ(set.begin(), set.end());
+
+	set.insert(5);
+	set.clear();
+	ASSERT_TRUE(set.empty());
+	ASSERT_FALSE(set.contains(5));
+}
+
+TEST(index_set, map_out_of_order)
+{
+	IndexMap <int> map;
+	map[10] = 1;
+	map[3] = 2;
+	map[20] = 3;
+	map[7] = 4;
+	map[3] = 5;
+
+	ASSERT_EQ(map.size(), 4);
+
+	std::vector <std::pair <Index, int>> entries(map.begin(), map.end());
+	ASSERT_EQ(entries, (std::vector <std::pair <Index, int>> {
+		{ 3, 5 }, { 7, 4 }, { 10, 1 }, { 20, 3 }
+	}));
+
+	ASSERT_TRUE(map.contains(7));
+	ASSERT_FALSE(map.contains(8));
+	ASSERT_EQ(map.at(20), 3);
+	ASSERT_THROW(map.at(0), std::out_of_range);
+
+	// Lookups insert default values in place
+	ASSERT_EQ(map[8], 0);
+	ASSERT_EQ(map.size(), 5);
+	ASSERT_EQ(std::next(map.begin(), 2)->first, 8);
+}
+
+TEST(index_set, relocation)
+{
+	// Atoms 1 and 3 are removed, 4 lies beyond the mapping
+	DenseRelocation relocation(4);
+	relocation[0] = 2;
+	relocation[2] = 0;
+
+	ASSERT_TRUE(relocation.contains(0));
+	ASSERT_FALSE(relocation.contains(1));
+	ASSERT_FALSE(relocation.contains(-1));
+	ASSERT_FALSE(relocation.contains(4));
+
+	Index addr = 3;
+	relocation.apply(addr);
+	ASSERT_EQ(addr, 3);
+
+	addr = 2;
+	relocation.apply(addr);
+	ASSERT_EQ(addr, 0);
+
+	Buffer::Decorations decorations;
+	decorations.type[0].name = "first";
+	decorations.type[1].name = "removed";
+	decorations.type[2].name = "third";
+	decorations.phantom.insert(1);
+	decorations.phantom.insert(2);
+	decorations.materialize.insert(0);
+	decorations.materialize.insert(3);
+	decorations.materialize.insert(4);
+
+	auto moved = decorations.relocated(relocation);
+
+	ASSERT_EQ(moved.type.size(), 2);
+	ASSERT_EQ(moved.type.at(0).name, "third");
+	ASSERT_EQ(moved.type.at(2).name, "first");
+	ASSERT_EQ(moved.type.begin()->first, 0);
+
+	ASSERT_EQ(moved.phantom.size(), 1);
+	ASSERT_TRUE(moved.phantom.contains(0));
+
+	ASSERT_EQ(moved.materialize.size(), 1);
+	ASSERT_TRUE(moved.materialize.contains(2));
+}
@@ -0,0 +1,513 @@
+#include <array>
+#include <cmath>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include <ire.hpp>
+
+#include "thunder/interpreter.hpp"
+#include "thunder/optimization.hpp"
+#include "thunder/tiered.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+TEST(interpreter, arithmetic)
+{
+	$subroutine(f32, arithmetic, f32 x, f32 y, f32 z) {
+		f32 a = x + y * z;
+		f32 b = a / (x - y) * z * z;
+		$return a / b;
+	};
+
+	thunder::Interpreter interpreter(link(arithmetic));
+
+	auto reference = [](float x, float y, float z) {
+		float a = x + y * z;
+		float b = a / (x - y) * z * z;
+		return a / b;
+	};
+
+	for (float x : { 1.0f, 2.5f, -3.0f }) {
+		for (float z : { 0.5f, 2.0f })
+			ASSERT_FLOAT_EQ(interpreter.call <float> (x, 0.25f, z), reference(x, 0.25f, z));
+	}
+}
+
+TEST(interpreter, integers)
+{
+	$subroutine(i32, integers, i32 x, i32 y) {
+		i32 a = x * 6 - y;
+		i32 b = (a / 4) % 5;
+		$return (a << 2) ^ b;
+	};
+
+	thunder::Interpreter interpreter(link(integers));
+
+	auto reference = [](int32_t x, int32_t y) {
+		int32_t a = x * 6 - y;
+		int32_t b = (a / 4) % 5;
+		return (a << 2) ^ b;
+	};
+
+	for (int32_t x : { -7, 0, 3, 1000 })
+		ASSERT_EQ(interpreter.call <int32_t> (x, 5), reference(x, 5));
+}
+
+TEST(interpreter, loops_and_branches)
+{
+	$subroutine(i32, loops, i32 n) {
+		i32 s = 0;
+		$for (i, range(0, n)) {
+			$if (i % 3 == 0) {
+				$continue;
+			};
+
+			s += i * i;
+
+			$if (s > 1000) {
+				$break;
+			};
+		};
+
+		$if (s > 500) {
+			s = s - 500;
+		} $elif (s > 100) {
+			s = s * 2;
+		} $else {
+			s = -s;
+		};
+
+		$return s;
+	};
+
+	thunder::Interpreter interpreter(link(loops));
+
+	auto reference = [](int32_t n) {
+		int32_t s = 0;
+		for (int32_t i = 0; i < n; i++) {
+			if (i % 3 == 0)
+				continue;
+
+			s += i * i;
+
+			if (s > 1000)
+				break;
+		}
+
+		if (s > 500)
+			s = s - 500;
+		else if (s > 100)
+			s = s * 2;
+		else
+			s = -s;
+
+		return s;
+	};
+
+	for (int32_t n : { 0, 1, 5, 9, 12, 40 })
+		ASSERT_EQ(interpreter.call <int32_t> (n), reference(n));
+}
+
+TEST(interpreter, vectors)
+{
+	$subroutine(f32, shading, f32 x, f32 y, f32 z) {
+		vec3 n = normalize(vec3(x, y, z));
+		vec3 l = normalize(vec3(1.0f, 2.0f, 3.0f));
+		vec3 h = normalize(n + l);
+		f32 ndoth = max(dot(n, h), 0.0f);
+		$return pow(ndoth, 8.0f) + length(cross(n, l));
+	};
+
+	thunder::Interpreter interpreter(link(shading));
+
+	auto reference = [](float x, float y, float z) {
+		auto normalize = [](std::array <float, 3> v) {
+			float l = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+			return std::array <float, 3> { v[0] / l, v[1] / l, v[2] / l };
+		};
+
+		auto n = normalize({ x, y, z });
+		auto l = normalize({ 1.0f, 2.0f, 3.0f });
+		auto h = normalize({ n[0] + l[0], n[1] + l[1], n[2] + l[2] });
+
+		float ndoth = std::max(n[0] * h[0] + n[1] * h[1] + n[2] * h[2], 0.0f);
+
+		std::array <float, 3> c {
+			n[1] * l[2] - n[2] * l[1],
+			n[2] * l[0] - n[0] * l[2],
+			n[0] * l[1] - n[1] * l[0],
+		};
+
+		return std::pow(ndoth, 8.0f) + std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+	};
+
+	for (float x : { 0.1f, 1.0f, -2.0f })
+		ASSERT_NEAR(interpreter.call <float> (x, 0.5f, 1.5f), reference(x, 0.5f, 1.5f), 1e-5f);
+}
+
+// Callees are lowered alongside the entry point
+$subroutine(f32, interpreted_polynomial, f32 x) {
+	$return x * x + 1.0f;
+};
+
+TEST(interpreter, calls)
+{
+	$subroutine(f32, permutation, f32 x, f32 y) {
+		f32 a = interpreted_polynomial(x) * y;
+		$if (a > 1.0f) {
+			a = a - interpreted_polynomial(y);
+		};
+
+		$return a;
+	};
+
+	thunder::Interpreter interpreter(link(permutation));
+
+	ASSERT_EQ(interpreter.lowered().functions.size(), 2u);
+
+	auto reference = [](float x, float y) {
+		float a = (x * x + 1.0f) * y;
+		if (a > 1.0f)
+			a = a - (y * y + 1.0f);
+
+		return a;
+	};
+
+	for (float x : { 0.0f, 0.5f, 2.0f }) {
+		for (float y : { 0.25f, 3.0f })
+			ASSERT_FLOAT_EQ(interpreter.call <float> (x, y), reference(x, y));
+	}
+}
+
+TEST(interpreter, structures)
+{
+	struct Seed {
+		u32 root;
+		u32 shifted;
+
+		auto layout() {
+			return layout_from("Seed",
+				verbatim_field(root),
+				verbatim_field(shifted));
+		}
+	};
+
+	$subroutine(Seed, shift_seed, Seed seed) {
+		u32 a = seed.root << seed.shifted;
+		u32 b = seed.shifted | seed.root;
+		$return Seed(a & b, b);
+	};
+
+	thunder::Interpreter interpreter(link(shift_seed));
+
+	struct host_seed {
+		uint32_t root;
+		uint32_t shifted;
+	};
+
+	host_seed input { 0b1011, 3 };
+	host_seed output;
+
+	const void *args[] = { &input };
+	interpreter.invoke(&output, args);
+
+	uint32_t a = input.root << input.shifted;
+	uint32_t b = input.shifted | input.root;
+
+	ASSERT_EQ(output.root, a & b);
+	ASSERT_EQ(output.shifted, b);
+}
+
+TEST(interpreter, local_arrays)
+{
+	$subroutine(f32, weighted, f32 x) {
+		array <f32> weights(4, f32(0.5f), f32(0.25f), f32(0.125f), f32(2.0f));
+		weights[1] = weights[1] * x;
+		$return weights[0] + weights[1] * x + weights[2] - weights[3];
+	};
+
+	thunder::Interpreter interpreter(link(weighted));
+
+	auto reference = [](float x) {
+		std::array <float, 4> weights { 0.5f, 0.25f, 0.125f, 2.0f };
+		weights[1] = weights[1] * x;
+		return weights[0] + weights[1] * x + weights[2] - weights[3];
+	};
+
+	for (float x : { -2.0f, 0.0f, 1.5f })
+		ASSERT_FLOAT_EQ(interpreter.call <float> (x), reference(x));
+}
+
+TEST(interpreter, dynamic_indexing)
+{
+	$subroutine(i32, lookup, i32 n) {
+		array <i32> table(8);
+		$for (i, range(0, 8)) {
+			table[i] = i * i - 3 * i;
+		};
+
+		i32 j = n % 8;
+		table[j] = table[j] + n;
+		$return table[j] + table[(j + 3) % 8];
+	};
+
+	thunder::Interpreter interpreter(link(lookup));
+
+	auto reference = [](int32_t n) {
+		std::array <int32_t, 8> table;
+		for (int32_t i = 0; i < 8; i++)
+			table[i] = i * i - 3 * i;
+
+		int32_t j = n % 8;
+		table[j] = table[j] + n;
+		return table[j] + table[(j + 3) % 8];
+	};
+
+	for (int32_t n : { 0, 3, 7, 12, 61 })
+		ASSERT_EQ(interpreter.call <int32_t> (n), reference(n));
+}
+
+TEST(interpreter, booleans)
+{
+	$subroutine(boolean, inside, f32 x, f32 lo, f32 hi, boolean inclusive) {
+		boolean strict = (x > lo) && (x < hi);
+		boolean edge = (x == lo) || (x == hi);
+		$return strict || (inclusive && edge);
+	};
+
+	thunder::Interpreter interpreter(link(inside));
+
+	auto reference = [](float x, float lo, float hi, bool inclusive) {
+		bool strict = (x > lo) && (x < hi);
+		bool edge = (x == lo) || (x == hi);
+		return strict || (inclusive && edge);
+	};
+
+	for (float x : { -1.0f, 0.0f, 0.5f, 1.0f, 2.0f }) {
+		for (bool inclusive : { false, true }) {
+			ASSERT_EQ(interpreter.call <bool> (x, 0.0f, 1.0f, inclusive),
+				reference(x, 0.0f, 1.0f, inclusive));
+		}
+	}
+}
+
+TEST(interpreter, wide_integers)
+{
+	$subroutine(u64, scramble, u64 x, u32 y) {
+		u64 k = uint64_t(0x9E3779B97F4A7C15);
+		u64 a = (x ^ u64(y)) * k;
+		u64 s = uint64_t(29);
+		u64 b = a ^ (a >> s);
+		$return b % u64(uint64_t(1000000007)) + (x / u64(y + 1u));
+	};
+
+	thunder::Interpreter interpreter(link(scramble));
+
+	auto reference = [](uint64_t x, uint32_t y) {
+		uint64_t a = (x ^ uint64_t(y)) * 0x9E3779B97F4A7C15;
+		uint64_t b = a ^ (a >> 29);
+		return b % 1000000007 + x / uint64_t(y + 1u);
+	};
+
+	for (uint64_t x : { uint64_t(0), uint64_t(12345), uint64_t(1) << 40, ~uint64_t(0) }) {
+		for (uint32_t y : { 0u, 7u, 0xFFFFFFF0u })
+			ASSERT_EQ(interpreter.call <uint64_t> (x, y), reference(x, y));
+	}
+}
+
+TEST(interpreter, matrices)
+{
+	$subroutine(vec4, transform, mat4 m, vec4 v) {
+		vec4 p = m * v;
+		$return p + v * 0.5f;
+	};
+
+	thunder::Interpreter interpreter(link(transform));
+
+	glm::mat4 m;
+	for (int c = 0; c < 4; c++) {
+		for (int r = 0; r < 4; r++)
+			m[c][r] = float(c * 4 + r) * 0.25f - 1.0f;
+	}
+
+	for (glm::vec4 v : { glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.5f, -2.0f, 3.0f, 0.25f) }) {
+		glm::vec4 expected = m * v + v * 0.5f;
+		glm::vec4 result = interpreter.call <glm::vec4> (m, v);
+		for (int i = 0; i < 4; i++)
+			ASSERT_NEAR(result[i], expected[i], 1e-5f);
+	}
+}
+
+TEST(interpreter, matches_jit)
+{
+	$subroutine(f32, specular, f32 cosine, f32 roughness, f32 f0) {
+		f32 alpha = roughness * roughness;
+		f32 alpha2 = alpha * alpha;
+		f32 m = 1.0f - cosine;
+		f32 fresnel = f0 + (1.0f - f0) * (m * m * m * m * m);
+		f32 d = cosine * cosine * (alpha2 - 1.0f) + 1.0f;
+		f32 ndf = alpha2 / (3.14159265f * d * d);
+		$return fresnel * ndf / (4.0f * cosine * cosine + 0.0001f);
+	};
+
+	auto unit = link(specular);
+
+	thunder::Interpreter interpreter(unit);
+
+	auto kernel = (float (*)(float, float, float)) unit.generate_jit_gcc();
+
+	for (float cosine : { 0.1f, 0.5f, 0.9f }) {
+		for (float roughness : { 0.2f, 0.7f }) {
+			ASSERT_NEAR(interpreter.call <float> (cosine, roughness, 0.04f),
+				kernel(cosine, roughness, 0.04f), 1e-5f);
+		}
+	}
+}
+
+// Native vector arithmetic in the JIT, against the scalarized interpreter
+TEST(interpreter, matches_jit_vectors)
+{
+	$subroutine(vec4, blend, vec4 a, vec4 b, f32 t) {
+		vec4 c = a + (b - a) * t;
+		f32 w = dot(c, c);
+		$return c * w + a;
+	};
+
+	thunder::TrackedBuffer buffer = blend;
+	thunder::legalize_for_cc(buffer.edit(), thunder::LegalizationFlags::eNativeVectors);
+
+	thunder::LinkageUnit unit;
+	unit.add(buffer);
+
+	thunder::Interpreter interpreter(link(blend));
+
+	auto kernel = (glm::vec4 (*)(glm::vec4, glm::vec4, float)) unit.generate_jit_gcc();
+
+	glm::vec4 a { 1.0f, -2.0f, 0.5f, 3.0f };
+	glm::vec4 b { 0.25f, 4.0f, -1.0f, 2.0f };
+
+	for (float t : { 0.0f, 0.3f, 1.0f }) {
+		glm::vec4 expected = interpreter.call <glm::vec4> (a, b, t);
+		glm::vec4 result = kernel(a, b, t);
+		for (int i = 0; i < 4; i++)
+			ASSERT_NEAR(result[i], expected[i], 1e-4f);
+	}
+}
+
+TEST(interpreter, tiered)
+{
+	$subroutine(f32, smooth, f32 x) {
+		$return x * x * (3.0f - 2.0f * x);
+	};
+
+	auto reference = [](float x) {
+		return x * x * (3.0f - 2.0f * x);
+	};
+
+	thunder::CompiledProcedure procedure(link(smooth), { .threshold = 4 });
+
+	// Interpreted until the threshold is reached
+	for (size_t i = 0; i < 3; i++) {
+		ASSERT_FLOAT_EQ(procedure.call <float> (0.25f * i), reference(0.25f * i));
+		ASSERT_EQ(procedure.tier(), thunder::Tier::interpreted);
+	}
+
+	ASSERT_EQ(procedure.function(), nullptr);
+
+	// ...then compiled in the background, while still being callable
+	ASSERT_FLOAT_EQ(procedure.call <float> (0.75f), reference(0.75f));
+	ASSERT_NE(procedure.tier(), thunder::Tier::interpreted);
+
+	procedure.wait();
+
+	ASSERT_EQ(procedure.tier(), thunder::Tier::native);
+	ASSERT_NE(procedure.function(), nullptr);
+	ASSERT_FLOAT_EQ(procedure.call <float> (0.5f), reference(0.5f));
+	ASSERT_EQ(procedure.invocations(), 5u);
+}
+
+TEST(interpreter, tiered_concurrent_calls)
+{
+	$subroutine(f32, falloff, f32 d, f32 r) {
+		f32 x = d / r;
+		f32 w = 1.0f - x * x;
+		$return w * w / (d * d + 1.0f);
+	};
+
+	auto reference = [](float d, float r) {
+		float x = d / r;
+		float w = 1.0f - x * x;
+		return w * w / (d * d + 1.0f);
+	};
+
+	static constexpr size_t threads = 4;
+	static constexpr size_t iterations = 256;
+
+	thunder::CompiledProcedure procedure(link(falloff), { .threshold = 64 });
+
+	// Calls keep being served while the native function is swapped in
+	std::vector <std::thread> pool;
+	std::atomic <size_t> mismatches = 0;
+	for (size_t t = 0; t < threads; t++) {
+		pool.emplace_back([&]() {
+			for (size_t i = 0; i < iterations; i++) {
+				float d = 0.01f * float(i);
+				if (std::abs(procedure.call <float> (d, 2.0f) - reference(d, 2.0f)) > 1e-5f)
+					mismatches++;
+			}
+		});
+	}
+
+	for (auto &thread : pool)
+		thread.join();
+
+	procedure.wait();
+
+	ASSERT_EQ(mismatches, 0u);
+	ASSERT_EQ(procedure.invocations(), threads * iterations);
+	ASSERT_EQ(procedure.tier(), thunder::Tier::native);
+	ASSERT_NE(procedure.function(), nullptr);
+}
+
+TEST(interpreter, tiered_fallback)
+{
+	$subroutine(i32, triangle, i32 n) {
+		i32 s = 0;
+		$for (i, range(0, n)) {
+			s += i;
+		};
+
+		$return s;
+	};
+
+	static constexpr size_t threads = 4;
+	static constexpr size_t iterations = 256;
+
+	thunder::CompiledProcedure procedure(link(triangle), { .threshold = 64 });
+
+	std::vector <std::thread> pool;
+	std::atomic <size_t> mismatches = 0;
+	for (size_t t = 0; t < threads; t++) {
+		pool.emplace_back([&]() {
+			for (int32_t i = 0; i < int32_t(iterations); i++) {
+				if (procedure.call <int32_t> (i) != i * (i - 1) / 2)
+					mismatches++;
+			}
+		});
+	}
+
+	for (auto &thread : pool)
+		thread.join();
+
+	// Loops are not lowered by gcc-jit, so the interpreter is kept
+	procedure.wait();
+
+	ASSERT_EQ(mismatches, 0u);
+	ASSERT_EQ(procedure.invocations(), threads * iterations);
+	ASSERT_EQ(procedure.tier(), thunder::Tier::interpreted);
+	ASSERT_EQ(procedure.function(), nullptr);
+}
@@ -58,7 +58,7 @@ void simple_vector_parameters()
 	};
 
 	auto F = ProcedureBuilder("shader") << shader;
-	thunder::legalize_for_cc(F);
+	thunder::legalize_for_cc(F.edit());
 	auto cpp = link(F).generate_cpp();
 
 	check_cpluslpus_source(cpp);
@@ -0,0 +1,299 @@
+#include <gtest/gtest.h>
+
+#include <ire.hpp>
+
+#include "thunder/batch.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+thunder::LinkageUnit linked(const thunder::TrackedBuffer &buffer)
+{
+	thunder::LinkageUnit unit;
+	unit.add(buffer);
+	return unit;
+}
+
+TEST(linkage, hash)
+{
+	auto make = []() {
+		$subroutine(f32, scaled, f32 x) {
+			$return x * 2.0f + 1.0f;
+		};
+
+		return scaled;
+	};
+
+	$subroutine(f32, scaled, f32 x) {
+		$return x * 3.0f + 1.0f;
+	};
+
+	auto a = make();
+	auto b = make();
+
+	ASSERT_EQ(linked(a).hash(), linked(b).hash());
+	ASSERT_NE(linked(a).hash(), linked(scaled).hash());
+}
+
+TEST(linkage, jit_cache)
+{
+	$subroutine(f32, polynomial, f32 x) {
+		$return (x * 0.5f + 1.0f) * x - 2.0f;
+	};
+
+	auto directory = std::filesystem::temp_directory_path() / "javelin-jit-cache-test";
+	std::filesystem::remove_all(directory);
+
+	JitOptions options;
+	options.cache = directory;
+
+	auto unit = linked(polynomial);
+
+	auto compiled = (float (*)(float)) unit.generate_jit_gcc(options);
+	ASSERT_NE(compiled, nullptr);
+
+	// A single shared object keyed by the unit and options
+	size_t entries = 0;
+	for (auto &entry : std::filesystem::directory_iterator(directory))
+		entries += (entry.path().extension() == ".so");
+
+	ASSERT_EQ(entries, 1);
+
+	auto cached = (float (*)(float)) unit.generate_jit_gcc(options);
+	ASSERT_NE(cached, nullptr);
+
+	for (float x : { -1.0f, 0.0f, 2.5f }) {
+		ASSERT_FLOAT_EQ(compiled(x), (x * 0.5f + 1.0f) * x - 2.0f);
+		ASSERT_FLOAT_EQ(cached(x), compiled(x));
+	}
+
+	// Different options are separate entries
+	options.optimization = 2;
+	unit.generate_jit_gcc(options);
+
+	entries = 0;
+	for (auto &entry : std::filesystem::directory_iterator(directory))
+		entries += (entry.path().extension() == ".so");
+
+	ASSERT_EQ(entries, 2);
+
+	std::filesystem::remove_all(directory);
+}
+
+TEST(linkage, spirv_cache)
+{
+	auto directory = std::filesystem::temp_directory_path() / "javelin-spirv-cache-test";
+	std::filesystem::remove_all(directory);
+
+	BinaryResult binary { 0x07230203, 0x00010600, 1, 2, 3 };
+
+	{
+		thunder::SpirvCache cache(directory);
+		ASSERT_FALSE(cache.find(42).has_value());
+
+		cache.insert(42, binary);
+		ASSERT_EQ(cache.find(42), binary);
+
+		ASSERT_EQ(cache.hits(), 1);
+		ASSERT_EQ(cache.misses(), 1);
+	}
+
+	// Entries persist across instances through the directory
+	thunder::SpirvCache cache(directory);
+	ASSERT_EQ(cache.find(42), binary);
+	ASSERT_FALSE(cache.find(7).has_value());
+
+	ASSERT_EQ(cache.hits(), 1);
+	ASSERT_EQ(cache.misses(), 1);
+
+	std::filesystem::remove_all(directory);
+}
+
+TEST(linkage, spirv_cache_compilation)
+{
+	$entrypoint(main) {
+		local_size(1);
+
+		writeonly <buffer <unsized_array <f32>>> output(0);
+		output[0] = f32(2.0f) * 0.5f + 1.0f;
+	};
+
+	thunder::SpirvCache cache;
+
+	thunder::SpirvOptions options;
+	options.cache = &cache;
+
+	auto unit = linked(main);
+
+	auto first = unit.generate_spirv_via_glsl(vk::ShaderStageFlagBits::eCompute, options);
+	auto second = unit.generate_spirv_via_glsl(vk::ShaderStageFlagBits::eCompute, options);
+
+	ASSERT_FALSE(first.empty());
+	ASSERT_EQ(first, second);
+	ASSERT_EQ(cache.misses(), 1);
+	ASSERT_EQ(cache.hits(), 1);
+
+	// Different options are separate entries
+	options.debug_info = false;
+	unit.generate_spirv_via_glsl(vk::ShaderStageFlagBits::eCompute, options);
+	ASSERT_EQ(cache.misses(), 2);
+}
+
+TEST(linkage, batch)
+{
+	$subroutine(f32, polynomial, f32 x) {
+		$return (x * 0.5f + 1.0f) * x - 2.0f;
+	};
+
+	$entrypoint(main) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> data(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+		data[tid] = data[tid] * data[tid] + 1.0f;
+	};
+
+	size_t atoms = polynomial->pointer;
+
+	auto directory = std::filesystem::temp_directory_path() / "javelin-batch-cache-test";
+	std::filesystem::remove_all(directory);
+
+	// Native items share a cache key, so workers race on the same
+	// entry; every fourth one compiles without the cache
+	std::vector <thunder::BatchItem> items;
+	for (size_t i = 0; i < 48; i++) {
+		thunder::BatchItem item;
+		switch (i % 4) {
+		case 0:
+			item.procedures = { main };
+			item.target = Target::spirv_binary;
+			break;
+		case 1:
+			item.procedures = { polynomial };
+			item.target = Target::glsl;
+			break;
+		case 2:
+			item.procedures = { polynomial };
+			item.target = Target::jit_gcc;
+			item.jit.cache = directory;
+			break;
+		case 3:
+			item.procedures = { polynomial };
+			item.target = Target::jit_gcc;
+			item.jit.optimization = 2;
+			break;
+		}
+
+		item.optimizer = thunder::Optimizer::stable;
+		items.push_back(item);
+	}
+
+	thunder::BatchCompiler compiler(4);
+	ASSERT_EQ(compiler.size(), 4);
+
+	auto futures = compiler.submit(items);
+	ASSERT_EQ(futures.size(), items.size());
+
+	// Results must match compiling each item serially
+	for (size_t i = 0; i < items.size(); i++) {
+		auto result = futures[i].get();
+		auto expected = thunder::BatchCompiler::compile(items[i]);
+
+		if (items[i].target == Target::jit_gcc) {
+			auto compiled = (float (*)(float)) result.result.as <FunctionResult> ();
+			auto serial = (float (*)(float)) expected.result.as <FunctionResult> ();
+			ASSERT_NE(compiled, nullptr);
+			ASSERT_NE(serial, nullptr);
+
+			for (float x : { -1.0f, 0.0f, 2.5f }) {
+				ASSERT_FLOAT_EQ(compiled(x), (x * 0.5f + 1.0f) * x - 2.0f);
+				ASSERT_FLOAT_EQ(serial(x), compiled(x));
+			}
+		} else {
+			ASSERT_EQ(result.result, expected.result);
+		}
+
+		ASSERT_GE(result.timing.queued.count(), 0);
+		ASSERT_GE(result.timing.total().count(), result.timing.generation.count());
+	}
+
+	// Concurrent writers of the same key leave a single entry
+	// and none of their temporary files behind
+	size_t entries = 0;
+	for (auto &entry : std::filesystem::directory_iterator(directory)) {
+		ASSERT_EQ(entry.path().extension(), ".so");
+		entries++;
+	}
+
+	ASSERT_EQ(entries, 1);
+
+	std::filesystem::remove_all(directory);
+
+	// Optimization applies to copies, not the registered callables
+	ASSERT_EQ(thunder::TrackedBuffer::cache_load(polynomial.cid)->pointer, atoms);
+}
+
+// Callee which only simplifies once optimized
+$subroutine(f32, batch_scaled, f32 x) {
+	f32 a = 2.0f;
+	f32 b = 3.0f;
+	$return x * (a + b) - (b - a);
+};
+
+TEST(linkage, batch_callees)
+{
+	$subroutine(f32, batch_caller, f32 x) {
+		$return batch_scaled(x * x) + 1.0f;
+	};
+
+	auto compile = [](std::vector <thunder::TrackedBuffer> procedures) {
+		thunder::BatchItem item;
+		item.procedures = procedures;
+		item.optimizer = thunder::Optimizer::stable;
+
+		auto result = thunder::BatchCompiler::compile(item);
+		return result.result.as <SourceResult> ();
+	};
+
+	auto function = [](const std::string &glsl) {
+		return glsl.substr(glsl.find("float batch_scaled"));
+	};
+
+	std::string optimized = function(compile({ batch_scaled }));
+	std::string unoptimized = function(linked(batch_scaled).generate_glsl());
+	ASSERT_NE(optimized, unoptimized);
+
+	// Callees are optimized whether or not they come first,
+	// and whether or not they are listed at all
+	for (auto procedures : std::vector <std::vector <thunder::TrackedBuffer>> {
+		{ batch_caller, batch_scaled },
+		{ batch_scaled, batch_caller },
+		{ batch_caller },
+	}) {
+		std::string glsl = compile(procedures);
+		ASSERT_NE(glsl.find(optimized), std::string::npos) << glsl;
+		ASSERT_EQ(glsl.find(unoptimized), std::string::npos) << glsl;
+	}
+}
+
+TEST(linkage, shared_subexpressions)
+{
+	$subroutine(f32, power, f32 x) {
+		std::vector <f32> tower { x };
+		for (size_t i = 0; i < 24; i++)
+			tower.emplace_back(tower.back() * tower.back() + tower.back());
+
+		$return tower.back();
+	};
+
+	// Inlining each use would double the source at every level
+	auto unit = linked(power);
+
+	std::string glsl = unit.generate_glsl();
+	ASSERT_LT(glsl.size(), 2048);
+	ASSERT_NE(glsl.find("float s22 = ((s21 * s21) + s21);"), std::string::npos);
+
+	std::string cpp = unit.generate_cpp();
+	ASSERT_LT(cpp.size(), 4096);
+}
@@ -0,0 +1,482 @@
+#include "util.hpp"
+
+#include <ire.hpp>
+
+#include "thunder/cfg.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+// Optimizes a copy of the procedure, leaving the original intact
+template <typename F>
+thunder::TrackedBuffer optimized(const F &ftn, thunder::OptimizationFlags flags)
+{
+	thunder::TrackedBuffer copy = ftn;
+
+	thunder::Optimizer optimizer { flags };
+	optimizer.apply(copy.edit());
+
+	return copy;
+}
+
+std::string generate_glsl(const thunder::TrackedBuffer &buffer)
+{
+	thunder::LinkageUnit unit;
+	unit.add(buffer);
+	return unit.generate_glsl();
+}
+
+TEST(optimization, distill_swizzles)
+{
+	$subroutine(f32, swizzles, vec3 v) {
+		$return v.x * v.y + v.x * v.y + v.z;
+	};
+
+	auto stable = optimized(swizzles, thunder::OptimizationFlags::eStable);
+	auto distilled = optimized(swizzles, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eDeduplication);
+
+	ASSERT_LT(distilled->pointer, stable->pointer);
+
+	check_shader_sources(generate_glsl(stable), generate_glsl(distilled));
+}
+
+TEST(optimization, distill_stores)
+{
+	$subroutine(f32, stores, f32 x) {
+		f32 a = x + 1.0f;
+		f32 b = a * 2.0f;
+		a += 3.0f;
+		f32 c = a * 2.0f;
+		$return b + c;
+	};
+
+	auto stable = optimized(stores, thunder::OptimizationFlags::eStable);
+	auto distilled = optimized(stores, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eDeduplication);
+
+	check_shader_sources(generate_glsl(stable), generate_glsl(distilled));
+}
+
+TEST(optimization, distill_scopes)
+{
+	$subroutine(f32, scoped, f32 x) {
+		f32 r = 0.0f;
+		$if (x > 0.0f) {
+			r = x * x;
+		};
+
+		$return r + x * x;
+	};
+
+	auto stable = optimized(scoped, thunder::OptimizationFlags::eStable);
+	auto distilled = optimized(scoped, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eDeduplication);
+
+	check_shader_sources(generate_glsl(stable), generate_glsl(distilled));
+}
+
+TEST(optimization, elide_stores)
+{
+	$subroutine(f32, stores, f32 x) {
+		f32 a = x + 1.0f;
+		a += 3.0f;
+		f32 c = a * 2.0f;
+		$return c + a;
+	};
+
+	auto elided = optimized(stores, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eStoreElision);
+
+	auto reference = [&]() {
+		$subroutine(f32, stores, f32 x) {
+			f32 a = (x + 1.0f) + 3.0f;
+			$return a * 2.0f + a;
+		};
+
+		return optimized(stores, thunder::OptimizationFlags::eStable);
+	};
+
+	check_shader_sources(generate_glsl(reference()), generate_glsl(elided));
+}
+
+TEST(optimization, elide_stores_control_flow)
+{
+	// Stores inside of nested blocks must be preserved
+	$subroutine(i32, loops, i32 n) {
+		i32 s = 0;
+		i32 k = n * 2;
+		k += 1;
+		$for (i, range(0, n)) {
+			s += i * k;
+		};
+
+		$if (s > 100) {
+			s = 100;
+		};
+
+		i32 unused = 5;
+		unused = s;
+		$return s + k;
+	};
+
+	auto elided = optimized(loops, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eStoreElision);
+
+	auto reference = [&]() {
+		$subroutine(i32, loops, i32 n) {
+			i32 s = 0;
+			i32 k = n * 2 + 1;
+			$for (i, range(0, n)) {
+				s += i * k;
+			};
+
+			$if (s > 100) {
+				s = 100;
+			};
+
+			$return s + k;
+		};
+
+		return optimized(loops, thunder::OptimizationFlags::eStable);
+	};
+
+	check_shader_sources(generate_glsl(reference()), generate_glsl(elided));
+}
+
+// JIT compiles the procedure into a native function
+template <typename R, typename ... Args>
+auto jit(const thunder::TrackedBuffer &buffer, const JitOptions &options = {})
+{
+	thunder::LinkageUnit unit;
+	unit.add(buffer);
+	return (R (*)(Args...)) unit.generate_jit_gcc(options);
+}
+
+TEST(optimization, fold_constants)
+{
+	$subroutine(f32, constants, f32 x) {
+		f32 a = 1.5f;
+		f32 b = 0.25f;
+		$return x + (a + b) * (a - b);
+	};
+
+	auto stable = optimized(constants, thunder::OptimizationFlags::eStable);
+	auto folded = optimized(constants, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eConstantFolding);
+
+	ASSERT_LT(folded->pointer, stable->pointer);
+
+	std::string source = generate_glsl(folded);
+	ASSERT_NE(source.find("2.1875"), std::string::npos);
+}
+
+TEST(optimization, fold_identities)
+{
+	$subroutine(f32, identities, f32 x, f32 y) {
+		vec3 v = vec3(x, y, 1.0f);
+		$return -(-v.x) * 1.0f + (-(-v.y) - 0.0f);
+	};
+
+	auto folded = optimized(identities, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eConstantFolding);
+
+	auto reference = [&]() {
+		$subroutine(f32, identities, f32 x, f32 y) {
+			$return x + y;
+		};
+
+		return optimized(identities, thunder::OptimizationFlags::eStable);
+	};
+
+	check_shader_sources(generate_glsl(reference()), generate_glsl(folded));
+}
+
+TEST(optimization, fold_u64_literals)
+{
+	$subroutine(u64, literal, u64 x) {
+		u64 small = uint64_t(1234);
+		u64 zero = uint64_t(0);
+		$return (x | zero) + small;
+	};
+
+	auto folded = optimized(literal, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eConstantFolding);
+
+	// Literals below 2^32 fold to a single primitive, with
+	// neither the casts nor the shift and or of the halves
+	size_t primitives = 0;
+	for (size_t i = 0; i < folded->pointer; i++) {
+		auto &atom = folded->atoms[i];
+		ASSERT_FALSE(atom.is <thunder::Intrinsic> ());
+
+		if (auto operation = atom.get <thunder::Operation> ())
+			ASSERT_EQ(operation->code, thunder::addition);
+
+		if (auto primitive = atom.get <thunder::Primitive> ()) {
+			ASSERT_EQ(primitive->type, thunder::u64);
+			ASSERT_EQ(primitive->udata, 1234u);
+			primitives++;
+		}
+	}
+
+	ASSERT_EQ(primitives, 1u);
+
+	auto simplified = jit <uint64_t, uint64_t> (folded);
+	ASSERT_EQ(simplified(uint64_t(1) << 40), (uint64_t(1) << 40) + 1234);
+}
+
+TEST(optimization, fold_integers_jit)
+{
+	$subroutine(i32, integers, i32 x) {
+		i32 a = 6;
+		i32 b = 7;
+		i32 c = (a * b - 2) / 4;
+		$return (x * 1 + 0) * c + x * 0 - (x - 0);
+	};
+
+	auto stable = optimized(integers, thunder::OptimizationFlags::eStable);
+	auto folded = optimized(integers, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eConstantFolding);
+
+	ASSERT_LT(folded->pointer, stable->pointer);
+
+	auto original = jit <int32_t, int32_t> (stable);
+	auto simplified = jit <int32_t, int32_t> (folded);
+
+	for (int32_t x : { -7, 0, 1, 13, 1 << 20 }) {
+		ASSERT_EQ(original(x), 9 * x);
+		ASSERT_EQ(simplified(x), original(x));
+	}
+}
+
+TEST(optimization, fold_unsigned_jit)
+{
+	$subroutine(u32, bits, u32 x) {
+		u32 a = 0xF0u;
+		u32 b = 0x0Fu;
+		u32 s = 4u;
+		$return ((a | b) ^ (a >> s)) + (x << s) - (b & a);
+	};
+
+	auto stable = optimized(bits, thunder::OptimizationFlags::eStable);
+	auto folded = optimized(bits, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eConstantFolding);
+
+	ASSERT_LT(folded->pointer, stable->pointer);
+
+	auto original = jit <uint32_t, uint32_t> (stable);
+	auto simplified = jit <uint32_t, uint32_t> (folded);
+
+	for (uint32_t x : { 0u, 1u, 0xABCDu, 0xFFFFFFFFu }) {
+		ASSERT_EQ(original(x), 0xF0u + (x << 4));
+		ASSERT_EQ(simplified(x), original(x));
+	}
+}
+
+TEST(optimization, fold_floats_jit)
+{
+	$subroutine(f32, floats, f32 x) {
+		f32 a = 1.5f;
+		f32 b = 0.25f;
+		$return (x * 1.0f - 0.0f) * (a + b) / (a - b) + clamp(a * b, 0.0f, 0.25f);
+	};
+
+	auto stable = optimized(floats, thunder::OptimizationFlags::eStable);
+	auto folded = optimized(floats, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eConstantFolding);
+
+	ASSERT_LT(folded->pointer, stable->pointer);
+
+	auto original = jit <float, float> (stable);
+	auto simplified = jit <float, float> (folded);
+
+	for (float x : { -2.0f, 0.0f, 0.5f, 1024.0f }) {
+		ASSERT_FLOAT_EQ(original(x), x * 1.75f / 1.25f + 0.25f);
+		ASSERT_FLOAT_EQ(simplified(x), original(x));
+	}
+}
+
+TEST(optimization, jit_options)
+{
+	$subroutine(f32, polynomial, f32 x) {
+		$return ((x * 0.5f + 1.0f) * x - 2.0f) * x + 0.25f;
+	};
+
+	auto stable = optimized(polynomial, thunder::OptimizationFlags::eStable);
+
+	auto unoptimized = jit <float, float> (stable);
+
+	thunder::LinkageUnit unit;
+	unit.add(stable);
+
+	JitOptions options;
+	options.optimization = 3;
+	options.native = true;
+
+	auto result = unit.generate(Target::jit_gcc, Stage::compute, options);
+	auto optimized = (float (*)(float)) result.as <FunctionResult> ();
+
+	for (float x : { -3.0f, 0.0f, 0.5f, 8.0f }) {
+		ASSERT_FLOAT_EQ(unoptimized(x), ((x * 0.5f + 1.0f) * x - 2.0f) * x + 0.25f);
+		ASSERT_FLOAT_EQ(optimized(x), unoptimized(x));
+	}
+}
+
+// Operations and intrinsics evaluated within the body of some loop
+size_t loop_work(const thunder::Buffer &buffer)
+{
+	auto cfg = thunder::control_flow_graph(buffer);
+
+	size_t count = 0;
+	for (size_t i = 0; i < buffer.pointer; i++) {
+		auto &atom = buffer.atoms[i];
+		bool work = atom.is <thunder::Operation> () || atom.is <thunder::Intrinsic> ();
+		count += work && (cfg.loop[cfg.block_of[i]] != -1);
+	}
+
+	return count;
+}
+
+TEST(optimization, hoist_loop_invariants)
+{
+	$subroutine(f32, invariants, f32 x, f32 y, i32 n) {
+		f32 s = 0.0f;
+		$for (i, range(0, n * 2)) {
+			s += x * y + 1.0f;
+			$for (j, range(0, n)) {
+				s += sin(x) * (y / 3.0f);
+				$if (s > x * 4.0f) {
+					$break;
+				};
+			};
+		};
+
+		$return s;
+	};
+
+	auto stable = optimized(invariants, thunder::OptimizationFlags::eStable);
+	auto hoisted = optimized(invariants, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eLoopInvariance);
+
+	ASSERT_EQ(hoisted->pointer, stable->pointer);
+	ASSERT_LT(loop_work(hoisted), loop_work(stable));
+
+	// Everything but the accumulation and the induction variables
+	ASSERT_EQ(loop_work(hoisted), 6);
+
+	std::string source = generate_glsl(hoisted);
+	ASSERT_LT(source.find("sin("), source.find("while"));
+	ASSERT_LT(source.find("(_arg2 * 2)"), source.find("while"));
+}
+
+TEST(optimization, hoist_loop_variants)
+{
+	$subroutine(i32, variants, i32 n, i32 d) {
+		i32 s = 0;
+		$for (i, range(0, n)) {
+			$if (d != 0) {
+				s += n / d;
+			};
+
+			s += s * 2;
+		};
+
+		$return s;
+	};
+
+	auto hoisted = optimized(variants, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eLoopInvariance);
+
+	// Only the guard is invariant; integral division may not be executed
+	// speculatively, and the remaining values are modified in the loop
+	ASSERT_EQ(hoisted->decorations.materialize.size(), 1);
+
+	thunder::Index guard = *hoisted->decorations.materialize.begin();
+	ASSERT_EQ(hoisted->atoms[guard].as <thunder::Operation> ().code, thunder::not_equals);
+
+	auto stable = optimized(variants, thunder::OptimizationFlags::eStable);
+	ASSERT_EQ(loop_work(hoisted) + 1, loop_work(stable));
+}
+
+TEST(optimization, hoist_memory_reads)
+{
+	$entrypoint(reads) {
+		buffer <unsized_array <f32>> data(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+		i32 n = i32(tid);
+
+		f32 sum = 0.0f;
+		$for (i, range(0, n)) {
+			sum += data[tid + 1u] * 2.0f;
+		};
+
+		data[tid] = sum;
+	};
+
+	auto hoisted = optimized(reads, thunder::OptimizationFlags::eStable
+		+ thunder::OptimizationFlags::eLoopInvariance);
+
+	thunder::Index header = -1;
+	for (size_t i = 0; i < hoisted->pointer; i++) {
+		auto branch = hoisted->atoms[i].get <thunder::Branch> ();
+		if (branch && branch->kind == thunder::loop_while)
+			header = i;
+	}
+
+	ASSERT_NE(header, -1);
+
+	// The loop may not run, so the read stays within it, and so do
+	// the values computed from it; the index itself may be hoisted
+	for (size_t i = 0; i < hoisted->pointer; i++) {
+		auto &atom = hoisted->atoms[i];
+		if (atom.is <thunder::ArrayAccess> () && !hoisted->marked.contains(i))
+			ASSERT_GT(thunder::Index(i), header);
+	}
+
+	for (thunder::Index k : hoisted->decorations.materialize) {
+		if (auto operation = hoisted->atoms[k].get <thunder::Operation> ())
+			ASSERT_NE(operation->code, thunder::multiplication);
+	}
+}
+
+// Unrolled accumulation, with about five atoms for every term
+thunder::TrackedBuffer unrolled(size_t terms)
+{
+	thunder::TrackedBuffer kernel;
+	kernel.edit().name = "unrolled";
+
+	auto &em = Emitter::active;
+	em.push(kernel.edit());
+	{
+		buffer <unsized_array <f32>> data(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+
+		f32 sum = 0.0f;
+		for (size_t i = 0; i < terms; i++)
+			sum += data[tid] * f32(i);
+
+		data[tid] = sum;
+	}
+	em.pop();
+
+	return kernel;
+}
+
+TEST(optimization, index_limit)
+{
+#ifdef JVL_WIDE_INDEX
+	auto kernel = unrolled(8000);
+	ASSERT_GT(kernel->pointer, 32768);
+
+	thunder::Optimizer::stable.apply(kernel);
+
+	std::string source = generate_glsl(kernel);
+	ASSERT_NE(source.find("7999"), std::string::npos);
+#else
+	// Diagnostics are printed to stdout, so only the abort is checked
+	ASSERT_DEATH(unrolled(8000), "");
+#endif
+}
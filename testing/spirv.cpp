@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#ifdef JVL_SPIRV_TOOLS
+#include <spirv-tools/libspirv.hpp>
+#endif
+
+#include <ire.hpp>
+
+#include "thunder/spirv_generator.hpp"
+
+using namespace jvl;
+using namespace jvl::ire;
+
+struct lighting {
+	mat4 model;
+	vec3 color;
+
+	auto layout() {
+		return layout_from("lighting",
+			verbatim_field(model),
+			verbatim_field(color));
+	}
+};
+
+$subroutine(f32, halved, f32 x, out <f32> y) {
+	y = x * 0.5f;
+	$return x * 2.0f + 1.0f;
+};
+
+// Tests are reported as skipped rather than passed without the validator
+static void validate_spirv(const std::vector <uint32_t> &binary, const std::string &assembly)
+{
+#ifdef JVL_SPIRV_TOOLS
+	spvtools::SpirvTools tools(SPV_ENV_VULKAN_1_3);
+
+	std::string messages;
+	tools.SetMessageConsumer([&](spv_message_level_t, const char *, const spv_position_t &, const char *message) {
+		messages += message;
+		messages += "\n";
+	});
+
+	EXPECT_TRUE(tools.Validate(binary)) << messages << "\n" << assembly;
+#else
+	GTEST_SKIP() << "SPIRV-Tools is unavailable, the binary is not validated";
+#endif
+}
+
+static std::vector <uint32_t> check_spirv(const thunder::TrackedBuffer &buffer, vk::ShaderStageFlagBits stage)
+{
+	thunder::LinkageUnit unit;
+	unit.add(buffer);
+
+	auto binary = unit.generate_spirv(stage);
+
+	EXPECT_GE(binary.size(), 5);
+	EXPECT_EQ(binary[0], thunder::detail::spv::magic);
+	EXPECT_EQ(binary[1], thunder::detail::spv::version);
+
+	// Instructions must tile the binary exactly
+	size_t offset = 5;
+	while (offset < binary.size()) {
+		uint32_t count = binary[offset] >> 16;
+		EXPECT_GT(count, 0);
+		if (count == 0)
+			break;
+
+		offset += count;
+	}
+
+	EXPECT_EQ(offset, binary.size());
+
+	// Every id must be below the bound
+	std::string assembly = thunder::detail::spirv_disassemble(binary);
+	for (size_t i = assembly.find('%'); i != std::string::npos; i = assembly.find('%', i + 1))
+		EXPECT_LT(std::stoul(assembly.substr(i + 1)), binary[3]);
+
+	validate_spirv(binary, assembly);
+
+	return binary;
+}
+
+static std::string assembly(const std::vector <uint32_t> &binary)
+{
+	return thunder::detail::spirv_disassemble(binary);
+}
+
+TEST(spirv, compute_loop)
+{
+	$entrypoint(kernel) {
+		local_size(64);
+
+		buffer <unsized_array <f32>> input(1);
+		writeonly <buffer <unsized_array <f32>>> output(0);
+
+		u32 tid = gl_GlobalInvocationID.x;
+
+		f32 sum = 0.0f;
+		$for (i, range(0, 4)) {
+			$if (input[tid] > 1.0f) {
+				sum += sin(input[tid]);
+			} $else {
+				sum -= 1.0f;
+			};
+		};
+
+		output[tid] = sum + length(vec3(sum, 1, 2));
+	};
+
+	auto text = assembly(check_spirv(kernel, vk::ShaderStageFlagBits::eCompute));
+
+	EXPECT_NE(text.find("OpEntryPoint GLCompute"), std::string::npos);
+	EXPECT_NE(text.find("OpExecutionMode %2 LocalSize 64 1 1"), std::string::npos);
+	EXPECT_NE(text.find("OpLoopMerge"), std::string::npos);
+	EXPECT_NE(text.find("OpSelectionMerge"), std::string::npos);
+	EXPECT_NE(text.find("OpTypeRuntimeArray"), std::string::npos);
+	EXPECT_NE(text.find("NonReadable"), std::string::npos);
+}
+
+TEST(spirv, vertex_push_constant)
+{
+	$entrypoint(vertex) {
+		layout_in <vec3> position(0);
+		layout_out <vec3> color(0);
+
+		push_constant <lighting> pc;
+
+		gl_Position = pc.model * vec4(position, 1);
+		color = pc.color;
+	};
+
+	auto text = assembly(check_spirv(vertex, vk::ShaderStageFlagBits::eVertex));
+
+	EXPECT_NE(text.find("OpEntryPoint Vertex"), std::string::npos);
+	EXPECT_NE(text.find("OpMatrixTimesVector"), std::string::npos);
+	EXPECT_NE(text.find("MatrixStride 16"), std::string::npos);
+	EXPECT_NE(text.find("Offset 64"), std::string::npos);
+	EXPECT_NE(text.find("PushConstant"), std::string::npos);
+}
+
+TEST(spirv, fragment_call)
+{
+	$entrypoint(fragment) {
+		layout_in <vec3> normal(0);
+		layout_out <vec4> result(0);
+
+		uniform <vec3> direction(0);
+
+		f32 half;
+		f32 d = halved(dot(normal, direction), half);
+		$if (d < 0.0f) {
+			discard();
+		};
+
+		vec3 c = vec3(d + half);
+		c.x = max(c.x, 0.1f);
+		result = vec4(c, 1.0f);
+	};
+
+	auto text = assembly(check_spirv(fragment, vk::ShaderStageFlagBits::eFragment));
+
+	EXPECT_NE(text.find("OpEntryPoint Fragment"), std::string::npos);
+	EXPECT_NE(text.find("OriginUpperLeft"), std::string::npos);
+	EXPECT_NE(text.find("OpFunctionCall"), std::string::npos);
+	EXPECT_NE(text.find("OpName %3 \"halved\""), std::string::npos);
+	EXPECT_NE(text.find("OpKill"), std::string::npos);
+}
+
+TEST(spirv, assembly_target)
+{
+	$entrypoint(kernel) {
+		local_size(8, 8);
+
+		buffer <unsized_array <u32>> data(0);
+
+		uvec3 id = gl_GlobalInvocationID;
+		data[id.x] = id.x + id.y;
+	};
+
+	thunder::LinkageUnit unit;
+	unit.add(kernel);
+
+	auto text = unit.generate(Target::spirv_assembly, Stage::compute).as <SourceResult> ();
+	auto binary = unit.generate(Target::spirv_binary, Stage::compute).as <BinaryResult> ();
+
+	ASSERT_EQ(text, assembly(binary));
+	ASSERT_NE(text.find("LocalSize 8 8 1"), std::string::npos);
+}
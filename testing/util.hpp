@@ -5,7 +5,7 @@
 #include <string>
 
 // Source comparison utilities
-std::string trim_shader_source(const std::string &A)
+inline std::string trim_shader_source(const std::string &A)
 {
 	static constexpr const char ws[] = " \t\n\r\f\v";
 	std::string s = A;
@@ -14,7 +14,7 @@ std::string trim_shader_source(const std::string &A)
 	return s;
 }
 
-void check_shader_sources(const std::string &A, const std::string &B)
+inline void check_shader_sources(const std::string &A, const std::string &B)
 {
 	auto tA = trim_shader_source(A);
 	auto tB = trim_shader_source(B);